@@ -4,6 +4,9 @@
 #include "../Math/Math.h"
 #include "../Pipeline/Pipeline.h"
 
+// external
+#include <cstdio>
+
 namespace Isonia::Controllers
 {
     struct KeyboardController
@@ -75,6 +78,74 @@ namespace Isonia::Controllers
         KeyboardController m_controller{};
     };
 
+    struct InputRecorder
+    {
+    public:
+        InputRecorder(const char* path);
+        ~InputRecorder();
+
+        InputRecorder() = delete;
+        InputRecorder(const InputRecorder&) = delete;
+        InputRecorder& operator=(const InputRecorder&) = delete;
+
+        // stores the frame's time step and the keys that changed since the frame before
+        void record(const Pipeline::Window* window, float frame_time_s);
+
+    private:
+        FILE* m_file;
+        unsigned int m_frame_count = 0u;
+        unsigned char m_key_state[State::Keyboard::max_keyboard_keys]{};
+    };
+
+    struct InputReplay
+    {
+    public:
+        InputReplay(const char* path);
+        ~InputReplay();
+
+        InputReplay() = delete;
+        InputReplay(const InputReplay&) = delete;
+        InputReplay& operator=(const InputReplay&) = delete;
+
+        // overwrites every key of the window with the recorded ones, false once the recording ran out
+        bool play(Pipeline::Window* window, float* out_frame_time_s);
+        unsigned int getFrameCount() const;
+
+    private:
+        unsigned char* m_data;
+        size_t m_size;
+        size_t m_offset;
+        unsigned int m_frame_count;
+        unsigned int m_frame = 0u;
+        unsigned char m_key_state[State::Keyboard::max_keyboard_keys]{};
+    };
+
+    struct CameraKeyframe
+    {
+        float time_s;
+        Math::Transform transform;
+    };
+
+    struct CameraPath
+    {
+    public:
+        // one keyframe per line, "time_s px py pz rx ry rz" in ascending time, # starts a comment
+        CameraPath(const char* path);
+        ~CameraPath();
+
+        CameraPath() = delete;
+        CameraPath(const CameraPath&) = delete;
+        CameraPath& operator=(const CameraPath&) = delete;
+
+        // linear between keyframes, held at either end
+        void sample(float time_s, Math::Transform* out_transform) const;
+        float getDuration() const;
+
+    private:
+        CameraKeyframe* m_keyframes;
+        unsigned int m_keyframe_count;
+    };
+
     struct PlayerIsometric
     {
     public:
@@ -85,6 +156,8 @@ namespace Isonia::Controllers
         PlayerIsometric& operator=(const PlayerIsometric&) = delete;
 
         void act(Pipeline::Window* window, float frame_time_s);
+        // takes the transform from the path instead of the keyboard
+        void follow(const CameraPath* path, float time_s);
 
         Pipeline::PixelRenderer::EventHandler getOnAspectChangeCallback();
         static void onAspectChange(Pipeline::PixelRenderer* renderer, void* user_data);
@@ -43,6 +43,12 @@ namespace Isonia::Controllers
         m_camera.setView(&m_transform);
     }
 
+    void PlayerIsometric::follow(const CameraPath* path, float time_s)
+    {
+        path->sample(time_s, &m_transform);
+        m_camera.setView(&m_transform);
+    }
+
     Pipeline::PixelRenderer::EventHandler PlayerIsometric::getOnAspectChangeCallback()
     {
         return &PlayerIsometric::onAspectChange;
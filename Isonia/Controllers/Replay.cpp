@@ -0,0 +1,240 @@
+// internal
+#include "Controllers.h"
+
+// external
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace Isonia::Controllers
+{
+    // recordings are not portable between byte orders, they are meant to be replayed on the machine or build farm that made them
+    static constexpr unsigned int input_recording_magic = 0x52495349u; // "ISIR"
+    static constexpr unsigned int input_recording_version = 1u;
+
+    // followed by one record per frame: frame_time_s, change count, then a key and action per change
+    struct InputRecordingHeader
+    {
+        unsigned int magic;
+        unsigned int version;
+        unsigned int max_keyboard_keys;
+        unsigned int frame_count;
+    };
+
+    InputRecorder::InputRecorder(const char* path)
+    {
+        m_file = fopen(path, "wb");
+        if (m_file == nullptr)
+        {
+            throw std::runtime_error("Failed to open input recording!");
+        }
+
+        // the frame count is filled in once the recording is closed
+        const InputRecordingHeader header{ input_recording_magic, input_recording_version, State::Keyboard::max_keyboard_keys, 0u };
+        fwrite(&header, sizeof(header), 1, m_file);
+    }
+
+    InputRecorder::~InputRecorder()
+    {
+        const InputRecordingHeader header{ input_recording_magic, input_recording_version, State::Keyboard::max_keyboard_keys, m_frame_count };
+        fseek(m_file, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, m_file);
+        fclose(m_file);
+    }
+
+    void InputRecorder::record(const Pipeline::Window* window, float frame_time_s)
+    {
+        unsigned short changed_keys[State::Keyboard::max_keyboard_keys];
+        unsigned short change_count = 0u;
+        for (unsigned int key = 0u; key < State::Keyboard::max_keyboard_keys; key++)
+        {
+            const unsigned char action = window->getKey(key);
+            if (action != m_key_state[key])
+            {
+                m_key_state[key] = action;
+                changed_keys[change_count++] = static_cast<unsigned short>(key);
+            }
+        }
+
+        fwrite(&frame_time_s, sizeof(frame_time_s), 1, m_file);
+        fwrite(&change_count, sizeof(change_count), 1, m_file);
+        for (unsigned int i = 0u; i < change_count; i++)
+        {
+            fwrite(&changed_keys[i], sizeof(unsigned short), 1, m_file);
+            fwrite(&m_key_state[changed_keys[i]], sizeof(unsigned char), 1, m_file);
+        }
+        m_frame_count++;
+    }
+
+    InputReplay::InputReplay(const char* path)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Failed to open input recording!");
+        }
+
+        InputRecordingHeader header;
+        if (fread(&header, sizeof(header), 1, file) != 1
+            || header.magic != input_recording_magic
+            || header.version != input_recording_version
+            || header.max_keyboard_keys != State::Keyboard::max_keyboard_keys)
+        {
+            fclose(file);
+            throw std::runtime_error("Input recording is invalid or from another version!");
+        }
+        m_frame_count = header.frame_count;
+
+        // read whole, replaying does no file io while frames are measured
+        const long begin = ftell(file);
+        fseek(file, 0, SEEK_END);
+        m_size = static_cast<size_t>(ftell(file) - begin);
+        fseek(file, begin, SEEK_SET);
+
+        m_data = (unsigned char*)malloc(m_size);
+        if (m_size != 0u && fread(m_data, m_size, 1, file) != 1)
+        {
+            fclose(file);
+            free(m_data);
+            throw std::runtime_error("Failed to read input recording!");
+        }
+        fclose(file);
+        m_offset = 0u;
+    }
+
+    InputReplay::~InputReplay()
+    {
+        free(m_data);
+    }
+
+    bool InputReplay::play(Pipeline::Window* window, float* out_frame_time_s)
+    {
+        const size_t frame_size = sizeof(float) + sizeof(unsigned short);
+        if (m_frame == m_frame_count || m_offset + frame_size > m_size)
+        {
+            return false;
+        }
+
+        unsigned short change_count;
+        memcpy(out_frame_time_s, m_data + m_offset, sizeof(float));
+        memcpy(&change_count, m_data + m_offset + sizeof(float), sizeof(unsigned short));
+        m_offset += frame_size;
+
+        const size_t change_size = sizeof(unsigned short) + sizeof(unsigned char);
+        if (m_offset + change_count * change_size > m_size)
+        {
+            return false;
+        }
+        for (unsigned int i = 0u; i < change_count; i++)
+        {
+            unsigned short key;
+            memcpy(&key, m_data + m_offset, sizeof(unsigned short));
+            if (key < State::Keyboard::max_keyboard_keys)
+            {
+                m_key_state[key] = m_data[m_offset + sizeof(unsigned short)];
+            }
+            m_offset += change_size;
+        }
+
+        // keys pressed on the window are overridden, the recording is the only input
+        for (unsigned int key = 0u; key < State::Keyboard::max_keyboard_keys; key++)
+        {
+            window->inputKey(key, m_key_state[key]);
+        }
+        m_frame++;
+        return true;
+    }
+
+    unsigned int InputReplay::getFrameCount() const
+    {
+        return m_frame_count;
+    }
+
+    CameraPath::CameraPath(const char* path)
+    {
+        FILE* file = fopen(path, "r");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Failed to open camera path!");
+        }
+
+        unsigned int capacity = 16u;
+        m_keyframes = (CameraKeyframe*)malloc(capacity * sizeof(CameraKeyframe));
+        m_keyframe_count = 0u;
+
+        char line[256];
+        while (fgets(line, sizeof(line), file) != nullptr)
+        {
+            if (line[0] == '#')
+            {
+                continue;
+            }
+
+            CameraKeyframe keyframe;
+            keyframe.transform = Math::Transform{};
+            if (sscanf(line, "%f %f %f %f %f %f %f",
+                &keyframe.time_s,
+                &keyframe.transform.position.x, &keyframe.transform.position.y, &keyframe.transform.position.z,
+                &keyframe.transform.rotation.x, &keyframe.transform.rotation.y, &keyframe.transform.rotation.z) != 7)
+            {
+                continue;
+            }
+            if (m_keyframe_count != 0u && keyframe.time_s <= m_keyframes[m_keyframe_count - 1u].time_s)
+            {
+                fclose(file);
+                free(m_keyframes);
+                throw std::runtime_error("Camera path keyframes are not in ascending time!");
+            }
+
+            if (m_keyframe_count == capacity)
+            {
+                capacity *= 2u;
+                m_keyframes = (CameraKeyframe*)realloc(m_keyframes, capacity * sizeof(CameraKeyframe));
+            }
+            m_keyframes[m_keyframe_count++] = keyframe;
+        }
+        fclose(file);
+
+        if (m_keyframe_count == 0u)
+        {
+            free(m_keyframes);
+            throw std::runtime_error("Camera path has no keyframes!");
+        }
+    }
+
+    CameraPath::~CameraPath()
+    {
+        free(m_keyframes);
+    }
+
+    void CameraPath::sample(float time_s, Math::Transform* out_transform) const
+    {
+        if (time_s <= m_keyframes[0].time_s)
+        {
+            *out_transform = m_keyframes[0].transform;
+            return;
+        }
+
+        for (unsigned int i = 1u; i < m_keyframe_count; i++)
+        {
+            const CameraKeyframe* next = &m_keyframes[i];
+            if (time_s < next->time_s)
+            {
+                // rotations are not wrapped, keyframes should not jump across +-pi
+                const CameraKeyframe* previous = &m_keyframes[i - 1u];
+                const float t = (time_s - previous->time_s) / (next->time_s - previous->time_s);
+                out_transform->position = Math::lerpv3(&previous->transform.position, &next->transform.position, t);
+                out_transform->rotation = Math::lerpv3(&previous->transform.rotation, &next->transform.rotation, t);
+                out_transform->scale = previous->transform.scale;
+                return;
+            }
+        }
+
+        *out_transform = m_keyframes[m_keyframe_count - 1u].transform;
+    }
+
+    float CameraPath::getDuration() const
+    {
+        return m_keyframes[m_keyframe_count - 1u].time_s;
+    }
+}
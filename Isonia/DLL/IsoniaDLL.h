@@ -1,7 +1,11 @@
 #pragma once
 
 #ifdef DLL_BUILD
+#ifdef _WIN32
 #define ISONIA_DLL_API __declspec(dllexport)
+#else
+#define ISONIA_DLL_API __attribute__((visibility("default")))
+#endif
 
 extern "C" ISONIA_DLL_API void* createIsoniaWindow();
 extern "C" ISONIA_DLL_API void destroyIsoniaWindow(void* window_handle);
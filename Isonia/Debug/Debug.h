@@ -3,21 +3,138 @@
 // internal
 #include "../Math/Math.h"
 
+// external
+#if PROFILING
+#include <atomic>
+#endif
+
+#if PROFILING
+#define ISONIA_PROFILE_CONCAT_INNER(a, b) a##b
+#define ISONIA_PROFILE_CONCAT(a, b) ISONIA_PROFILE_CONCAT_INNER(a, b)
+// times the rest of the enclosing scope, the name is kept by pointer until the export so it has to be a literal
+#define ISONIA_PROFILE_ZONE(name) const ::Isonia::Debug::ProfileZone ISONIA_PROFILE_CONCAT(profile_zone_, __LINE__){ name }
+#define ISONIA_PROFILE_FUNCTION() ISONIA_PROFILE_ZONE(__FUNCTION__)
+#define ISONIA_PROFILE_THREAD(name) ::Isonia::Debug::Profiler::setThreadName(name)
+#else
+#define ISONIA_PROFILE_ZONE(name)
+#define ISONIA_PROFILE_FUNCTION()
+#define ISONIA_PROFILE_THREAD(name)
+#endif
+
 namespace Isonia::Debug
 {
+    struct FrameTimeStats
+    {
+        unsigned int frame_count;
+        // frames the percentiles were taken over, at most the ring size
+        unsigned int sample_count;
+        float average_ms;
+        float highest_ms;
+        float p50_ms;
+        float p90_ms;
+        float p99_ms;
+        float p999_ms;
+        // frames over the stutter threshold since the start
+        unsigned int stutter_count;
+    };
+
     struct PerformanceTracker
     {
     public:
-        char* logFrameTime(float frame_time_s);
+        // recent frames the percentiles are taken over, a bit over a minute at 60 fps
+        static constexpr const unsigned int ring_size = 4096u;
+        // quarter octaves from histogram_min_ms, the first and last bucket also hold everything below and above
+        static constexpr const unsigned int histogram_bucket_count = 48u;
+        static constexpr const unsigned int histogram_buckets_per_octave = 4u;
+        static constexpr const float histogram_min_ms = 0.5f;
+        // two frames at 60 fps
+        static constexpr const float default_stutter_threshold_ms = 33.3f;
+        // sorting the ring every frame would cost more than the frame it measures
+        static constexpr const float stats_refresh_s = 0.5f;
+        static constexpr const unsigned int max_text_length = 256u;
+
+        // the returned text is owned by the tracker and valid until the next call
+        const char* logFrameTime(float frame_time_s);
+        // as of the last refresh
+        const FrameTimeStats* getStats() const;
+        void setStutterThreshold(float stutter_threshold_ms);
+
+        // the ring oldest first
+        void exportCsv(const char* path);
+        // the stats and the histogram of all frames, extra members are written as they are after them
+        void exportJson(const char* path, const char* extra_members = nullptr);
 
         PerformanceTracker() = default;
         PerformanceTracker(const PerformanceTracker&) = delete;
         PerformanceTracker& operator=(const PerformanceTracker&) = delete;
 
     private:
+        void updateStats();
+        float getHistogramBucketMin(unsigned int bucket) const;
+
         unsigned int m_frame_count = 0;
-        float m_total_frame_time_ms = 0.0f;
-        float m_average_frame_time_ms = 0.0f;
+        double m_total_frame_time_ms = 0.0;
         float m_highest_frame_time_ms = 0.0f;
+        float m_stutter_threshold_ms = default_stutter_threshold_ms;
+        unsigned int m_stutter_count = 0;
+        float m_time_since_refresh_s = stats_refresh_s;
+
+        float m_frame_times_ms[ring_size]{};
+        float m_sorted_frame_times_ms[ring_size]{};
+        unsigned int m_histogram[histogram_bucket_count]{};
+
+        FrameTimeStats m_stats{};
+        char m_text[max_text_length]{};
+    };
+
+#if PROFILING
+    struct ProfileEvent
+    {
+        const char* name;
+        long long begin_ns;
+        long long end_ns;
+    };
+
+    // written only by its own thread, so recording a zone takes no lock
+    struct ProfileThread
+    {
+        // the oldest events are overwritten once full
+        static constexpr const unsigned int max_events = 32768u;
+
+        const char* name;
+        unsigned int id;
+        // every event ever recorded, published after the event is written
+        std::atomic<unsigned int> event_count;
+        ProfileEvent events[max_events];
+    };
+
+    struct Profiler
+    {
+    public:
+        static constexpr const unsigned int max_threads = 64u;
+
+        // steady clock, in nanoseconds since the profiler was loaded
+        static long long now();
+        static void record(const char* name, long long begin_ns, long long end_ns);
+        static void setThreadName(const char* name);
+        // chrome trace event json, threads that are still recording may tear the events they overwrite
+        static void exportChromeTrace(const char* path);
+
+        Profiler() = delete;
+    };
+
+    struct ProfileZone
+    {
+    public:
+        explicit ProfileZone(const char* name);
+        ~ProfileZone();
+
+        ProfileZone(const ProfileZone&) = delete;
+        ProfileZone& operator=(const ProfileZone&) = delete;
+
+    private:
+        const char* m_name;
+        long long m_begin_ns;
     };
+#endif
 }
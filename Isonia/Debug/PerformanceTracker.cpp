@@ -2,39 +2,151 @@
 #include "Debug.h"
 
 // external
-#include <iomanip>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
 
 namespace Isonia::Debug
 {
-    char* PerformanceTracker::logFrameTime(float frame_time_s)
+    static int compareFrameTimes(const void* a, const void* b)
     {
-        // Convert frame_time_s to ms
-        float frame_time_ms = frame_time_s * 1'000.0f;
+        const float lhs = *static_cast<const float*>(a);
+        const float rhs = *static_cast<const float*>(b);
+        return (lhs > rhs) - (lhs < rhs);
+    }
 
-        // New frame
-        m_frame_count++;
+    // nearest rank on the sorted samples
+    static float percentile(const float* sorted, unsigned int count, float fraction)
+    {
+        const unsigned int rank = static_cast<unsigned int>(ceilf(fraction * count));
+        return sorted[rank > 0u ? rank - 1u : 0u];
+    }
 
-        // Calculate and update average frame time
-        m_total_frame_time_ms += frame_time_ms;
-        m_average_frame_time_ms = m_total_frame_time_ms / m_frame_count;
+    const char* PerformanceTracker::logFrameTime(float frame_time_s)
+    {
+        const float frame_time_ms = frame_time_s * 1'000.0f;
 
-        // Update highest frame time
+        m_frame_times_ms[m_frame_count % ring_size] = frame_time_ms;
+        m_frame_count++;
+        m_total_frame_time_ms += frame_time_ms;
         m_highest_frame_time_ms = Math::maxf(m_highest_frame_time_ms, frame_time_ms);
 
-        // Create a buffer to hold the performance statistics
-        char buffer[128];
+        const float octaves = log2f(Math::maxf(frame_time_ms, histogram_min_ms) / histogram_min_ms);
+        const unsigned int bucket = static_cast<unsigned int>(octaves * histogram_buckets_per_octave);
+        m_histogram[bucket < histogram_bucket_count ? bucket : histogram_bucket_count - 1u]++;
+
+        if (frame_time_ms > m_stutter_threshold_ms)
+        {
+            m_stutter_count++;
+        }
+
+        m_time_since_refresh_s += frame_time_s;
+        if (m_time_since_refresh_s >= stats_refresh_s)
+        {
+            m_time_since_refresh_s = 0.0f;
+            updateStats();
+        }
+
+        snprintf(m_text, max_text_length,
+            "Frame Time: %.4f ms\nAverage Frame Time: %.4f ms\nHighest Frame Time: %.4f ms\nP50 %.2f P90 %.2f P99 %.2f P99.9 %.2f ms\nStutters: %u over %.1f ms",
+            frame_time_ms, m_stats.average_ms, m_stats.highest_ms,
+            m_stats.p50_ms, m_stats.p90_ms, m_stats.p99_ms, m_stats.p999_ms,
+            m_stats.stutter_count, m_stutter_threshold_ms);
+        return m_text;
+    }
+
+    const FrameTimeStats* PerformanceTracker::getStats() const
+    {
+        return &m_stats;
+    }
+
+    void PerformanceTracker::setStutterThreshold(float stutter_threshold_ms)
+    {
+        assert(m_frame_count == 0u && "Stutter threshold has to be set before the first frame");
+        m_stutter_threshold_ms = stutter_threshold_ms;
+    }
+
+    void PerformanceTracker::exportCsv(const char* path)
+    {
+        FILE* file = fopen(path, "w");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Failed to open frame time csv!");
+        }
+
+        const unsigned int sample_count = m_frame_count < ring_size ? m_frame_count : ring_size;
+        const unsigned int first_frame = m_frame_count - sample_count;
+        fprintf(file, "frame,frame_time_ms\n");
+        for (unsigned int frame = first_frame; frame < m_frame_count; frame++)
+        {
+            fprintf(file, "%u,%.4f\n", frame, m_frame_times_ms[frame % ring_size]);
+        }
+        fclose(file);
+    }
+
+    void PerformanceTracker::exportJson(const char* path, const char* extra_members)
+    {
+        FILE* file = fopen(path, "w");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Failed to open frame time json!");
+        }
+
+        updateStats();
+        fprintf(file, "{\n");
+        fprintf(file, "  \"frame_count\": %u,\n", m_stats.frame_count);
+        fprintf(file, "  \"sample_count\": %u,\n", m_stats.sample_count);
+        fprintf(file, "  \"average_ms\": %.4f,\n", m_stats.average_ms);
+        fprintf(file, "  \"highest_ms\": %.4f,\n", m_stats.highest_ms);
+        fprintf(file, "  \"p50_ms\": %.4f,\n", m_stats.p50_ms);
+        fprintf(file, "  \"p90_ms\": %.4f,\n", m_stats.p90_ms);
+        fprintf(file, "  \"p99_ms\": %.4f,\n", m_stats.p99_ms);
+        fprintf(file, "  \"p99_9_ms\": %.4f,\n", m_stats.p999_ms);
+        fprintf(file, "  \"stutter_threshold_ms\": %.4f,\n", m_stutter_threshold_ms);
+        fprintf(file, "  \"stutter_count\": %u,\n", m_stats.stutter_count);
+        fprintf(file, "  \"histogram\": [\n");
+        for (unsigned int i = 0u; i < histogram_bucket_count; i++)
+        {
+            fprintf(file, "    { \"min_ms\": %.4f, \"max_ms\": %.4f, \"count\": %u }%s\n",
+                getHistogramBucketMin(i), getHistogramBucketMin(i + 1u), m_histogram[i], i + 1u < histogram_bucket_count ? "," : "");
+        }
+        fprintf(file, "  ]%s\n", extra_members != nullptr ? "," : "");
+        if (extra_members != nullptr)
+        {
+            fprintf(file, "%s\n", extra_members);
+        }
+        fprintf(file, "}\n");
+        fclose(file);
+    }
 
-        // Format the string
-        int length = sprintf(buffer, "Frame Time: %.4f ms\nAverage Frame Time: %.4f ms\nHighest Frame Time: %.4f ms", frame_time_ms, m_average_frame_time_ms, m_highest_frame_time_ms);
+    void PerformanceTracker::updateStats()
+    {
+        const unsigned int sample_count = m_frame_count < ring_size ? m_frame_count : ring_size;
 
-        // Allocate memory for the char* to be returned
-        char* cstr = (char*)malloc((length + 1) * sizeof(char));
-        if (cstr != NULL)
+        m_stats.frame_count = m_frame_count;
+        m_stats.sample_count = sample_count;
+        m_stats.average_ms = m_frame_count > 0u ? static_cast<float>(m_total_frame_time_ms / m_frame_count) : 0.0f;
+        m_stats.highest_ms = m_highest_frame_time_ms;
+        m_stats.stutter_count = m_stutter_count;
+        if (sample_count == 0u)
         {
-            strcpy(cstr, buffer);
+            return;
         }
 
-        // Return the allocated char*
-        return cstr;
+        // the ring is not in order once it wrapped, which does not matter for sorting
+        memcpy(m_sorted_frame_times_ms, m_frame_times_ms, sample_count * sizeof(float));
+        qsort(m_sorted_frame_times_ms, sample_count, sizeof(float), compareFrameTimes);
+        m_stats.p50_ms = percentile(m_sorted_frame_times_ms, sample_count, 0.5f);
+        m_stats.p90_ms = percentile(m_sorted_frame_times_ms, sample_count, 0.9f);
+        m_stats.p99_ms = percentile(m_sorted_frame_times_ms, sample_count, 0.99f);
+        m_stats.p999_ms = percentile(m_sorted_frame_times_ms, sample_count, 0.999f);
+    }
+
+    float PerformanceTracker::getHistogramBucketMin(unsigned int bucket) const
+    {
+        return histogram_min_ms * exp2f(static_cast<float>(bucket) / histogram_buckets_per_octave);
     }
 }
@@ -0,0 +1,119 @@
+#if PROFILING
+
+// internal
+#include "Debug.h"
+
+// external
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+
+namespace Isonia::Debug
+{
+    static const std::chrono::steady_clock::time_point profiler_epoch = std::chrono::steady_clock::now();
+
+    static std::mutex profiler_mutex;
+    static ProfileThread* profiler_threads[Profiler::max_threads];
+    static unsigned int profiler_thread_count = 0u;
+    // null once all threads are taken, zones on further threads are dropped
+    static thread_local ProfileThread* profiler_thread = nullptr;
+    static thread_local bool profiler_thread_registered = false;
+
+    static ProfileThread* getProfileThread()
+    {
+        if (!profiler_thread_registered)
+        {
+            profiler_thread_registered = true;
+
+            // once per thread, the buffers are never freed so threads that exited still export
+            std::lock_guard<std::mutex> lock(profiler_mutex);
+            if (profiler_thread_count < Profiler::max_threads)
+            {
+                ProfileThread* thread = new ProfileThread;
+                thread->name = nullptr;
+                thread->id = profiler_thread_count;
+                thread->event_count.store(0u, std::memory_order_relaxed);
+                profiler_threads[profiler_thread_count++] = thread;
+                profiler_thread = thread;
+            }
+        }
+        return profiler_thread;
+    }
+
+    long long Profiler::now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profiler_epoch).count();
+    }
+
+    void Profiler::record(const char* name, long long begin_ns, long long end_ns)
+    {
+        ProfileThread* thread = getProfileThread();
+        if (thread == nullptr)
+        {
+            return;
+        }
+
+        const unsigned int event_count = thread->event_count.load(std::memory_order_relaxed);
+        ProfileEvent* event = &thread->events[event_count % ProfileThread::max_events];
+        event->name = name;
+        event->begin_ns = begin_ns;
+        event->end_ns = end_ns;
+        thread->event_count.store(event_count + 1u, std::memory_order_release);
+    }
+
+    void Profiler::setThreadName(const char* name)
+    {
+        ProfileThread* thread = getProfileThread();
+        if (thread != nullptr)
+        {
+            thread->name = name;
+        }
+    }
+
+    void Profiler::exportChromeTrace(const char* path)
+    {
+        FILE* file = fopen(path, "w");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Failed to open chrome trace!");
+        }
+
+        std::lock_guard<std::mutex> lock(profiler_mutex);
+        fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        bool is_first = true;
+        for (unsigned int i = 0u; i < profiler_thread_count; i++)
+        {
+            const ProfileThread* thread = profiler_threads[i];
+            if (thread->name != nullptr)
+            {
+                fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", is_first ? "" : ",\n", thread->id, thread->name);
+                is_first = false;
+            }
+
+            const unsigned int event_count = thread->event_count.load(std::memory_order_acquire);
+            const unsigned int first_event = event_count > ProfileThread::max_events ? event_count - ProfileThread::max_events : 0u;
+            for (unsigned int j = first_event; j < event_count; j++)
+            {
+                const ProfileEvent* event = &thread->events[j % ProfileThread::max_events];
+                fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    is_first ? "" : ",\n", event->name, thread->id, event->begin_ns / 1'000.0, (event->end_ns - event->begin_ns) / 1'000.0);
+                is_first = false;
+            }
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+    }
+
+    ProfileZone::ProfileZone(const char* name)
+        : m_name{ name }, m_begin_ns{ Profiler::now() }
+    {
+    }
+
+    ProfileZone::~ProfileZone()
+    {
+        Profiler::record(m_name, m_begin_ns, Profiler::now());
+    }
+}
+
+#endif
@@ -3,26 +3,59 @@
 
 // external
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
 
 namespace Isonia
 {
-	Isonia::Isonia()
+	Isonia::Isonia(const HeadlessSettings* headless_settings, const ReplaySettings* replay_settings)
+		: m_is_headless(headless_settings != nullptr), m_window{ width, height, name, headless_settings != nullptr }
 	{
+		if (m_is_headless)
+		{
+			m_headless_settings = *headless_settings;
+		}
+
 		initializeDescriptorPools();
 		initializeRenderSystems();
+		initializeRenderGraph();
 		initializeEntities();
 		initializePlayer();
+
+		if (replay_settings != nullptr)
+		{
+			if (replay_settings->record_path != nullptr)
+			{
+				m_input_recorder = new Controllers::InputRecorder(replay_settings->record_path);
+			}
+			if (replay_settings->input_path != nullptr)
+			{
+				m_input_replay = new Controllers::InputReplay(replay_settings->input_path);
+			}
+			if (replay_settings->camera_path != nullptr)
+			{
+				m_camera_path = new Controllers::CameraPath(replay_settings->camera_path);
+			}
+
+			// the clouds are the only work that depends on a thread's timing
+			m_cloud->setLockstep(m_input_replay != nullptr || m_camera_path != nullptr);
+		}
 	}
 
 	Isonia::~Isonia()
 	{
+		delete m_camera_path;
+		delete m_input_replay;
+		delete m_input_recorder;
+
 		delete m_text;
 		delete m_wind;
 		delete m_cloud;
+		delete m_cloud_texture_factory;
 		delete m_debugger;
 		delete m_grass;
-		delete m_grass_day_palette;
-		delete m_water_day_palette;
+		delete m_palettes;
 
 		/*
 		delete m_sphere_model;
@@ -41,24 +74,25 @@ namespace Isonia
 
 		delete m_weather_descriptor_manager;
 		delete m_ground_descriptor_manager;
-		delete m_water_descriptor_manager;
 		delete m_text_descriptor_manager;
 		delete m_debugger_descriptor_manager;
-
-		for (Pipeline::Buffer* buffer : m_clock_buffers) {
-			delete buffer;
-		}
-		for (Pipeline::Buffer* buffer : m_ubo_buffers) {
-			delete buffer;
-		}
+		delete m_texture_heap;
 	}
 
-	void Isonia::run()
+	void Isonia::run(const char* stats_path)
 	{
-		Debug::PerformanceTracker performance_tracker;
+		if (m_is_headless)
+		{
+			runHeadless();
+			exportFrameTimes(stats_path);
+			return;
+		}
+
+		ISONIA_PROFILE_THREAD("Main");
 		std::chrono::time_point current_time_s = std::chrono::high_resolution_clock::now();
 		while (!m_window.m_should_close)
 		{
+			ISONIA_PROFILE_ZONE("Frame");
 			m_window.pollEvents();
 			if (m_window.m_should_close)
 			{
@@ -66,78 +100,279 @@ namespace Isonia
 			}
 
 			std::chrono::time_point new_time_s = std::chrono::high_resolution_clock::now();
-			float frame_time_s = std::chrono::duration<float, std::chrono::seconds::period>(new_time_s - current_time_s).count(); // 10.0f / 1'000.0f
+			const float measured_frame_time_s = std::chrono::duration<float, std::chrono::seconds::period>(new_time_s - current_time_s).count(); // 10.0f / 1'000.0f
 			current_time_s = new_time_s;
 
-			m_player.act(&m_window, frame_time_s);
+			// scripted runs take the fixed step of headless runs so they simulate the same frames, a replay brings its recorded steps
+			float frame_time_s = m_camera_path != nullptr || m_input_replay != nullptr ? m_headless_settings.frame_time_s : measured_frame_time_s;
+			if (!updatePlayer(&frame_time_s))
+			{
+				break;
+			}
 
-			char* performance_text = performance_tracker.logFrameTime(frame_time_s);
-			m_ui_render_system->update(m_renderer.getExtent(), performance_text);
-			delete performance_text;
+			const char* performance_text = m_performance_tracker.logFrameTime(measured_frame_time_s);
+			drawFrame(frame_time_s, performance_text);
+		}
+
+		vkDeviceWaitIdle(m_device.getDevice());
+		exportFrameTimes(stats_path);
+	}
+
+	void Isonia::runHeadless()
+	{
+		const VkExtent2D extent = m_renderer.getPixelSwapChain()->getPixelSwapChainExtent();
+		unsigned char* rgb = m_headless_settings.dump_path != nullptr ? (unsigned char*)malloc(extent.width * extent.height * 3u) : nullptr;
+
+		// the gpu times trail the frames by the frames in flight, each row has the latest read back and the frame it was measured on
+		FILE* csv = nullptr;
+		unsigned int* drawn_frames = nullptr;
+		unsigned int drawn_count = 0u;
+		if (m_headless_settings.csv_path != nullptr)
+		{
+			csv = fopen(m_headless_settings.csv_path, "w");
+			if (csv == nullptr)
+			{
+				throw std::runtime_error("Failed to open headless csv!");
+			}
+			// frames the renderer skipped are not counted by the gpu timer
+			drawn_frames = (unsigned int*)malloc(m_headless_settings.frame_count * sizeof(unsigned int));
+			fprintf(csv, "frame,cpu_ms,gpu_frame");
+			for (unsigned int i = 0u; i < Pipeline::RenderScopes::count; i++)
+			{
+				fprintf(csv, ",gpu %s ms", Pipeline::RenderScopes::names[i]);
+			}
+			fprintf(csv, "\n");
+		}
+
+		// of the frame before
+		float cpu_frame_time_s = 0.0f;
+		ISONIA_PROFILE_THREAD("Main");
+		for (unsigned int frame = 0u; frame < m_headless_settings.frame_count; frame++)
+		{
+			ISONIA_PROFILE_ZONE("Frame");
+			std::chrono::time_point start_time_s = std::chrono::high_resolution_clock::now();
+
+			m_window.pollEvents();
+			float frame_time_s = m_headless_settings.frame_time_s;
+			if (!updatePlayer(&frame_time_s))
+			{
+				break;
+			}
+
+			// the overlay shows measured times, the simulation only sees the fixed step
+			const char* performance_text = m_performance_tracker.logFrameTime(cpu_frame_time_s);
+			const int frame_index = drawFrame(frame_time_s, performance_text);
+
+			cpu_frame_time_s = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - start_time_s).count();
+			if (csv != nullptr)
+			{
+				if (frame_index >= 0)
+				{
+					drawn_frames[drawn_count++] = frame;
+				}
+
+				const Pipeline::GpuTimer* gpu_timer = m_renderer.getGpuTimer();
+				const Pipeline::GpuTimingStats* gpu_timing_stats = gpu_timer->getStats();
+				fprintf(csv, "%u,%.4f,", frame, cpu_frame_time_s * 1'000.0f);
+				if (gpu_timer->getStatsFrame() != Pipeline::GpuTimer::invalid_frame)
+				{
+					fprintf(csv, "%u", drawn_frames[gpu_timer->getStatsFrame()]);
+				}
+				for (unsigned int i = 0u; i < Pipeline::RenderScopes::count; i++)
+				{
+					fprintf(csv, ",%.4f", gpu_timing_stats->milliseconds[i]);
+				}
+				fprintf(csv, "\n");
+			}
 
-			if (VkCommandBuffer command_buffer = m_renderer.beginFrame())
+			if (rgb != nullptr && frame_index >= 0)
 			{
-				int frame_index = m_renderer.getFrameIndex();
-				State::FrameInfo frame_info{
-					frame_index,
-					frame_time_s,
-					command_buffer,
-					*m_global_descriptor_manager->getDescriptorSets(frame_index),
-					*m_global_swapchain_descriptor_manager->getDescriptorSets(frame_index)
-				};
-
-				// update
-				m_ubo.projection = *m_player.m_camera.getProjection();
-				m_ubo.view = *m_player.m_camera.getView();
-				m_ubo.inverse_view = *m_player.m_camera.getInverseView();
-				m_ubo.sub_pixel_offset = m_player.m_camera.m_sub_pixel_offset;
-
-				m_ubo_buffers[frame_index]->writeToBuffer(&m_ubo);
-				m_ubo_buffers[frame_index]->flush();
-
-				m_clock.frame_time_s = frame_time_s;
-				m_clock.time_s += frame_time_s;
-
-				m_clock_buffers[frame_index]->writeToBuffer(&m_clock);
-				m_clock_buffers[frame_index]->flush();
-
-				// render
-				m_renderer.beginSwapChainRenderPass(command_buffer, 0u);
-				m_ground_render_system->render(
-					m_ground_descriptor_manager->getDescriptorSets(frame_index),
-					m_weather_descriptor_manager->getDescriptorSets(frame_index),
-					&frame_info,
-					&m_player.m_camera
-				);
-				m_debugger_render_system->render(m_debugger_descriptor_manager->getDescriptorSets(frame_index), &frame_info);
-				m_renderer.endSwapChainRenderPass(command_buffer);
-
-				m_renderer.copyToIntermediates(command_buffer);
-
-				m_renderer.beginSwapChainRenderPass(command_buffer, 1u);
-				m_water_render_system->render(
-					m_water_descriptor_manager->getDescriptorSets(frame_index),
-					&frame_info,
-					&m_player.m_camera
-				);
-				m_ui_render_system->render(m_text_descriptor_manager->getDescriptorSets(frame_index), &frame_info, &m_player.m_camera);
-				m_renderer.endSwapChainRenderPass(command_buffer);
-
-				m_renderer.blit(command_buffer, m_player.m_camera.m_sub_pixel_offset);
-				m_renderer.endFrame();
+				m_renderer.getPixelSwapChain()->readSwapChainImage(frame_index, rgb);
+				writeFrame(frame, rgb);
 			}
 		}
 
 		vkDeviceWaitIdle(m_device.getDevice());
+		free(rgb);
+		if (csv != nullptr)
+		{
+			free(drawn_frames);
+			fclose(csv);
+		}
+	}
+
+	void Isonia::exportFrameTimes(const char* stats_path)
+	{
+		if (stats_path == nullptr)
+		{
+			return;
+		}
+
+		char path[256];
+		snprintf(path, sizeof(path), "%s.csv", stats_path);
+		m_performance_tracker.exportCsv(path);
+		snprintf(path, sizeof(path), "%s.json", stats_path);
+
+		// the workload as per frame averages, render systems that drew nothing are left out
+		const Pipeline::FrameWorkloadStats* totals = m_renderer.getWorkloadTotals();
+		const double frame_count = static_cast<double>(m_renderer.getFinishedFrameCount() > 0u ? m_renderer.getFinishedFrameCount() : 1u);
+		char workload[4096];
+		int length = snprintf(
+			workload,
+			sizeof(workload),
+			"  \"workload_per_frame\": {\n    \"buffer_bytes_uploaded\": %.1f,\n    \"image_bytes_copied\": %.1f,\n    \"scopes\": [",
+			totals->transfers.buffer_bytes_uploaded / frame_count,
+			totals->transfers.image_bytes_copied / frame_count
+		);
+		for (unsigned int i = 0u; i < Pipeline::RenderScopes::count; i++)
+		{
+			const Pipeline::CommandRecorderStats* scope = i == Pipeline::RenderScopes::frame ? &totals->total : &totals->scopes[i];
+			if (i != Pipeline::RenderScopes::frame && scope->issued[Pipeline::CommandTypes::draw] == 0u)
+			{
+				continue;
+			}
+			length += snprintf(
+				workload + length,
+				sizeof(workload) - length,
+				"%s\n      { \"name\": \"%s\", \"draws\": %.1f, \"vertices\": %.1f, \"instances\": %.1f, \"pipeline_binds\": %.1f, \"descriptor_binds\": %.1f, \"push_constant_bytes\": %.1f }",
+				i == Pipeline::RenderScopes::frame ? "" : ",",
+				Pipeline::RenderScopes::names[i],
+				scope->issued[Pipeline::CommandTypes::draw] / frame_count,
+				scope->vertices / frame_count,
+				scope->instances / frame_count,
+				scope->issued[Pipeline::CommandTypes::pipeline] / frame_count,
+				scope->issued[Pipeline::CommandTypes::descriptor_sets] / frame_count,
+				scope->push_constant_bytes / frame_count
+			);
+			if (length >= static_cast<int>(sizeof(workload)))
+			{
+				// snprintf returns the length it wanted, the scopes that did not fit are dropped
+				length = sizeof(workload) - 1;
+				break;
+			}
+		}
+		snprintf(workload + length, sizeof(workload) - length, "\n    ]\n  }");
+		m_performance_tracker.exportJson(path, workload);
+	}
+
+	bool Isonia::updatePlayer(float* frame_time_s)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		if (m_input_replay != nullptr && !m_input_replay->play(&m_window, frame_time_s))
+		{
+			return false;
+		}
+		if (m_input_recorder != nullptr)
+		{
+			m_input_recorder->record(&m_window, *frame_time_s);
+		}
+
+		if (m_camera_path != nullptr)
+		{
+			if (m_camera_path_time_s > m_camera_path->getDuration())
+			{
+				return false;
+			}
+			m_player.follow(m_camera_path, m_camera_path_time_s);
+			m_camera_path_time_s += *frame_time_s;
+			return true;
+		}
+
+		m_player.act(&m_window, *frame_time_s);
+		return true;
+	}
+
+	int Isonia::drawFrame(float frame_time_s, const char* performance_text)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		if (m_window.getKey(Pipeline::KeyCodes::f3) == Pipeline::KeyActions::press)
+		{
+			const Pipeline::ResourceStats resource_stats = m_device.getResourceStats();
+			m_ui_render_system->update(m_renderer.getExtent(), performance_text, &resource_stats, m_renderer.getWorkloadStats(), m_renderer.getGpuTimer()->getStats());
+		}
+		else
+		{
+			m_ui_render_system->update(m_renderer.getExtent(), performance_text);
+		}
+
+		VkCommandBuffer command_buffer = m_renderer.beginFrame();
+		if (command_buffer == nullptr)
+		{
+			return -1;
+		}
+
+		int frame_index = m_renderer.getFrameIndex();
+
+		// update
+		m_ubo.projection = *m_player.m_camera.getProjection();
+		m_ubo.view = *m_player.m_camera.getView();
+		m_ubo.inverse_view = *m_player.m_camera.getInverseView();
+		m_ubo.sub_pixel_offset = m_player.m_camera.m_sub_pixel_offset;
+
+		m_clock.frame_time_s = frame_time_s;
+		m_clock.time_s += frame_time_s;
+
+		Pipeline::UniformRing* uniform_ring = m_device.getUniformRing();
+		State::FrameInfo frame_info{
+			frame_index,
+			frame_time_s,
+			command_buffer,
+			m_renderer.getCommandRecorder(),
+			*m_global_descriptor_manager->getDescriptorSets(frame_index),
+			*m_global_swapchain_descriptor_manager->getDescriptorSets(frame_index),
+			uniform_ring->push(&m_ubo, sizeof(State::GlobalUbo)),
+			uniform_ring->push(&m_clock, sizeof(State::Clock))
+		};
+
+		if (m_cloud->update(command_buffer, frame_index, m_clock.time_s))
+		{
+			m_weather_descriptor_manager->getWriters(frame_index)->overwrite(m_weather_descriptor_manager->getDescriptorSets(frame_index));
+		}
+
+		// render
+		Pipeline::PixelSwapChain* swap_chain = m_renderer.getPixelSwapChain();
+		m_render_graph.setImage(m_color_resource, swap_chain->getImage(frame_index));
+		m_render_graph.setImage(m_depth_resource, swap_chain->getDepthImage(frame_index));
+		m_render_graph.setImage(m_swap_chain_image_resource, swap_chain->getSwapChainImage(frame_index));
+		m_render_graph.execute(command_buffer, &frame_info);
+
+		m_renderer.endFrame();
+		return frame_index;
+	}
+
+	void Isonia::writeFrame(unsigned int frame, const unsigned char* rgb) const
+	{
+		ISONIA_PROFILE_FUNCTION();
+		const VkExtent2D extent = m_renderer.getPixelSwapChain()->getPixelSwapChainExtent();
+
+		char path[512];
+		snprintf(path, sizeof(path), "%s%05u.ppm", m_headless_settings.dump_path, frame);
+
+		FILE* file = fopen(path, "wb");
+		if (file == nullptr)
+		{
+			throw std::runtime_error("Failed to write headless frame!");
+		}
+		fprintf(file, "P6\n%u %u\n255\n", extent.width, extent.height);
+		fwrite(rgb, 3u, extent.width * extent.height, file);
+		fclose(file);
 	}
 
 	void Isonia::initializeDescriptorPools()
 	{
+		// one ground descriptor set carries them for both the ground and the water
+		m_palettes = Renderable::createPalettes(&m_device);
+
+		// optional, textures registered here are bound once through a single set
+		if (Pipeline::Descriptors::TextureHeap::isSupported(&m_device))
+		{
+			m_texture_heap = new Pipeline::Descriptors::TextureHeap(&m_device);
+		}
+
 		initializeGlobalDescriptorPool();
 		initializeSwapChainDescriptorPool();
 		initializeWeatherDescriptorPool();
 		initializeGroundDescriptorPool();
-		initializeWaterDescriptorPool();
 		initializeTextDescriptorPool();
 		initializeDebuggerDescriptorPool();
 	}
@@ -148,40 +383,22 @@ namespace Isonia
 
 		m_global_descriptor_manager = new Pipeline::Descriptors::DescriptorManager(&m_device, 2u);
 		m_global_descriptor_manager->getPool()
-			->addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frames_in_flight)
-			->addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, frames_in_flight)
+			->addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, frames_in_flight)
+			->addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, frames_in_flight)
 			->build(frames_in_flight);
 		m_global_descriptor_manager->getSetLayout()
-			->addBinding(0u, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-			->addBinding(1u, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			->addBinding(0u, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+			->addBinding(1u, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
 			->build();
 
+		// both bindings point into the uniform ring, the frame's data is picked by dynamic offset
+		const VkDescriptorBufferInfo ubo_buffer_info = m_device.getUniformRing()->getDescriptorInfo(sizeof(State::GlobalUbo));
+		const VkDescriptorBufferInfo clock_buffer_info = m_device.getUniformRing()->getDescriptorInfo(sizeof(State::Clock));
 		for (int i = 0; i < frames_in_flight; i++)
 		{
-			m_ubo_buffers[i] = new Pipeline::Buffer(
-				&m_device,
-				sizeof(State::GlobalUbo),
-				1,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-			);
-			m_ubo_buffers[i]->map();
-
-			m_clock_buffers[i] = new Pipeline::Buffer(
-				&m_device,
-				sizeof(State::Clock),
-				1,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-			);
-			m_clock_buffers[i]->map();
-
-			const VkDescriptorBufferInfo* ubo_buffer_info = m_ubo_buffers[i]->getDescriptorInfo();
-			const VkDescriptorBufferInfo* clock_buffer_info = m_clock_buffers[i]->getDescriptorInfo();
-
 			m_global_descriptor_manager->getWriters(i)
-				->writeBuffer(0u, ubo_buffer_info)
-				->writeBuffer(1u, clock_buffer_info)
+				->writeBuffer(0u, &ubo_buffer_info)
+				->writeBuffer(1u, &clock_buffer_info)
 				->build(m_global_descriptor_manager->getDescriptorSets(i));
 		}
 	}
@@ -190,24 +407,20 @@ namespace Isonia
 	{
 		const unsigned int frames_in_flight = m_renderer.getPixelSwapChain()->getImageCount();
 
-		m_global_swapchain_descriptor_manager = new Pipeline::Descriptors::DescriptorManager(&m_device, 2u);
+		m_global_swapchain_descriptor_manager = new Pipeline::Descriptors::DescriptorManager(&m_device, 1u);
 		m_global_swapchain_descriptor_manager->getPool()
-			->addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frames_in_flight)
 			->addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frames_in_flight)
 			->build(frames_in_flight);
 		m_global_swapchain_descriptor_manager->getSetLayout()
 			->addBinding(0u, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
-			->addBinding(1u, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
 			->build();
 
 		for (int i = 0; i < frames_in_flight; i++)
 		{
-			const VkDescriptorImageInfo* intermediate_color_buffer_image_info = m_renderer.getPixelSwapChain()->getIntermediateImageInfo(i);
-			const VkDescriptorImageInfo* intermediate_depth_buffer_image_info = m_renderer.getPixelSwapChain()->getIntermediateDepthImageInfo(i);
+			const VkDescriptorImageInfo* depth_buffer_image_info = m_renderer.getPixelSwapChain()->getDepthImageInfo(i);
 
 			m_global_swapchain_descriptor_manager->getWriters(i)
-				->writeImage(0u, intermediate_color_buffer_image_info)
-				->writeImage(1u, intermediate_depth_buffer_image_info)
+				->writeImage(0u, depth_buffer_image_info)
 				->build(m_global_swapchain_descriptor_manager->getDescriptorSets(i));
 		}
 	}
@@ -226,16 +439,15 @@ namespace Isonia
 			->addBinding(1u, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
 			->build();
 
-		Noise::ConstantScalarWarpNoise cloud_warp_noise{ 5.0f };
-		Noise::FractalPerlinNoise cloud_noise{ 69, 3, 2.0f, 0.5f, 0.0f };
-		Renderable::Noise4DTextureFactory cloudTextureFactory = Renderable::Noise4DTextureFactory{ &cloud_warp_noise, &cloud_noise, 128u, 128u, 1u };
-		m_cloud = cloudTextureFactory.instantiateTexture(&m_device, VK_FORMAT_R8_UNORM, VK_FILTER_LINEAR);
+		// clouds keep evolving, the factory and its noise are sampled by the texture's worker thread
+		m_cloud_texture_factory = new Renderable::Noise4DTextureFactory{ &m_cloud_warp_noise, &m_cloud_noise, 128u, 128u, 1u };
+		m_cloud = new Renderable::AnimatedNoiseTexture(&m_device, m_cloud_texture_factory, VK_FORMAT_R8_UNORM, frames_in_flight, 8u, 0.01f);
 
 		Noise::ConstantScalarWarpNoise wind_w{ 5.0f };
 		Noise::PerlinNoise wind_n{ 69 };
 		Noise::CurlNoise wind_noise{ &wind_n, &wind_w };
 		Renderable::WarpNoiseTextureFactory windTextureFactory = Renderable::WarpNoiseTextureFactory{ &wind_noise, 128u, 128u, 2u };
-		m_wind = windTextureFactory.instantiateTexture(&m_device, VK_FORMAT_R8G8_SNORM, VK_FILTER_LINEAR);
+		m_wind = windTextureFactory.instantiateCompressedTexture(&m_device, VK_FORMAT_R8G8_SNORM, VK_FILTER_LINEAR);
 
 		const VkDescriptorImageInfo* cloud_info = m_cloud->getImageInfo();
 		const VkDescriptorImageInfo* wind_info = m_wind->getImageInfo();
@@ -250,6 +462,7 @@ namespace Isonia
 
 	void Isonia::initializeGroundDescriptorPool()
 	{
+		// also bound by the water, which only reads the palettes
 		const unsigned int frames_in_flight = m_renderer.getPixelSwapChain()->getImageCount();
 
 		m_ground_descriptor_manager = new Pipeline::Descriptors::DescriptorManager(&m_device, 2u);
@@ -262,45 +475,30 @@ namespace Isonia
 			->addBinding(1u, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
 			->build();
 
-		Renderable::GrassTextureAtlasFactory grassTextureAtlasFactory = Renderable::GrassTextureAtlasFactory{ 9u, 9u, 16u, 16u, 1u };
-		m_grass = grassTextureAtlasFactory.instantiateTexture(&m_device, VK_FORMAT_R8_UNORM);
-		m_grass_day_palette = Renderable::createGrassDayPalette(&m_device);
-
-		const VkDescriptorImageInfo* grass_day_palette_info = m_grass_day_palette->getImageInfo();
+		const unsigned int grass_samples = 4u;
+		Renderable::GrassTextureAtlasFactory grassTextureAtlasFactory = Renderable::GrassTextureAtlasFactory{ 9u, 9u, 16u * grass_samples, 16u * grass_samples, 1u };
+		Renderable::SupersampledTextureAtlasFactory grassSupersampledFactory = Renderable::SupersampledTextureAtlasFactory{ &grassTextureAtlasFactory, grass_samples };
+		m_grass = grassSupersampledFactory.instantiateTexture(&m_device, VK_FORMAT_R8_UNORM);
+		const VkDescriptorImageInfo* palettes_info = m_palettes->getImageInfo();
 		const VkDescriptorImageInfo* grass_info = m_grass->getImageInfo();
 		for (int i = 0; i < frames_in_flight; i++)
 		{
 			m_ground_descriptor_manager->getWriters(i)
-				->writeImage(0u, grass_day_palette_info)
+				->writeImage(0u, palettes_info)
 				->writeImage(1u, grass_info)
 				->build(m_ground_descriptor_manager->getDescriptorSets(i));
 		}
 	}
 
-	void Isonia::initializeWaterDescriptorPool()
+	void Isonia::initializeTextDescriptorPool()
 	{
-		const unsigned int frames_in_flight = m_renderer.getPixelSwapChain()->getImageCount();
-
-		m_water_descriptor_manager = new Pipeline::Descriptors::DescriptorManager(&m_device, 1u);
-		m_water_descriptor_manager->getPool()
-			->addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frames_in_flight)
-			->build(frames_in_flight);
-		m_water_descriptor_manager->getSetLayout()
-			->addBinding(0u, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
-			->build();
-
-		m_water_day_palette = Renderable::createWaterDayPalette(&m_device);
-		const VkDescriptorImageInfo* water_day_palette_info = m_water_day_palette->getImageInfo();
-		for (int i = 0; i < frames_in_flight; i++)
+		m_text = Renderable::Font::pixelFont3x6(&m_device);
+		if (m_texture_heap != nullptr)
 		{
-			m_water_descriptor_manager->getWriters(i)
-				->writeImage(0u, water_day_palette_info)
-				->build(m_water_descriptor_manager->getDescriptorSets(i));
+			m_text_texture_index = m_texture_heap->registerTexture(m_text->getTexture()->getImageInfo());
+			return;
 		}
-	}
 
-	void Isonia::initializeTextDescriptorPool()
-	{
 		const unsigned int frames_in_flight = m_renderer.getPixelSwapChain()->getImageCount();
 
 		m_text_descriptor_manager = new Pipeline::Descriptors::DescriptorManager(&m_device, 1u);
@@ -311,8 +509,6 @@ namespace Isonia
 			->addBinding(0u, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
 			->build();
 
-		m_text = Renderable::Font::pixelFont3x6(&m_device);
-
 		const VkDescriptorImageInfo* text_info = m_text->getTexture()->getImageInfo();
 		for (int i = 0; i < frames_in_flight; i++)
 		{
@@ -324,6 +520,13 @@ namespace Isonia
 
 	void Isonia::initializeDebuggerDescriptorPool()
 	{
+		m_debugger = Renderable::createDebugTexture(&m_device);
+		if (m_texture_heap != nullptr)
+		{
+			m_debugger_texture_index = m_texture_heap->registerTexture(m_debugger->getImageInfo());
+			return;
+		}
+
 		const unsigned int frames_in_flight = m_renderer.getPixelSwapChain()->getImageCount();
 
 		m_debugger_descriptor_manager = new Pipeline::Descriptors::DescriptorManager(&m_device, 1u);
@@ -334,8 +537,6 @@ namespace Isonia
 			->addBinding(0u, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS)
 			->build();
 
-		m_debugger = Renderable::createDebugTexture(&m_device);
-
 		const VkDescriptorImageInfo* debugger_info = m_debugger->getImageInfo();
 		for (int i = 0; i < frames_in_flight; i++)
 		{
@@ -360,7 +561,8 @@ namespace Isonia
 			&m_device,
 			m_renderer.getSwapChainRenderPass(0u),
 			m_global_descriptor_manager->getSetLayout()->getDescriptorSetLayout(),
-			m_debugger_descriptor_manager->getSetLayout()->getDescriptorSetLayout()
+			m_texture_heap != nullptr ? m_texture_heap->getSetLayout() : m_debugger_descriptor_manager->getSetLayout()->getDescriptorSetLayout(),
+			m_debugger_texture_index
 		};
 
 		m_water_render_system = new Pipeline::RenderSystems::WaterRenderSystem{
@@ -368,19 +570,147 @@ namespace Isonia
 			m_renderer.getSwapChainRenderPass(1u),
 			m_global_descriptor_manager->getSetLayout()->getDescriptorSetLayout(),
 			m_global_swapchain_descriptor_manager->getSetLayout()->getDescriptorSetLayout(),
-			m_water_descriptor_manager->getSetLayout()->getDescriptorSetLayout()
+			m_ground_descriptor_manager->getSetLayout()->getDescriptorSetLayout()
 		};
 
 		m_ui_render_system = new Pipeline::RenderSystems::UIRenderSystem{
 			&m_device,
 			m_renderer.getSwapChainRenderPass(1u),
 			m_global_descriptor_manager->getSetLayout()->getDescriptorSetLayout(),
-			m_text_descriptor_manager->getSetLayout()->getDescriptorSetLayout(),
+			m_texture_heap != nullptr ? m_texture_heap->getSetLayout() : m_text_descriptor_manager->getSetLayout()->getDescriptorSetLayout(),
 			m_text,
-			128u
+			4096u,
+			m_text_texture_index
 		};
 	}
 
+	void Isonia::initializeRenderGraph()
+	{
+		// the depth format survives swap chain recreation, so the aspect only has to be looked up once
+		const Pipeline::PixelSwapChain* swap_chain = m_renderer.getPixelSwapChain();
+		const VkImageAspectFlags depth_aspect = swap_chain->getDepthAspect();
+
+		m_color_resource = m_render_graph.importImage("Color", VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED);
+		m_depth_resource = m_render_graph.importImage("Depth", depth_aspect, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED);
+		// available once the acquire semaphore's wait stage is reached, the blit keeps the border from earlier frames
+		// headless the image is left for the read back instead of presented
+		m_swap_chain_image_resource = m_render_graph.importImage("Swap Chain", VK_IMAGE_ASPECT_COLOR_BIT, swap_chain->getPresentLayout(), swap_chain->getPresentLayout(), swap_chain->getImageAvailableStage());
+		m_render_graph.markOutput(m_swap_chain_image_resource);
+
+		const unsigned int scene_pass = m_render_graph.addPass("Scene", RecordScenePass, this);
+		m_render_graph.write(scene_pass, m_color_resource, Pipeline::RenderGraphUsages::color_attachment, true)
+			->write(scene_pass, m_depth_resource, Pipeline::RenderGraphUsages::depth_attachment, true);
+
+		// the water blends over the scene color and samples the depth it tests against, nothing is copied
+		const unsigned int water_pass = m_render_graph.addPass("Water", RecordWaterPass, this);
+		m_render_graph.read(water_pass, m_depth_resource, Pipeline::RenderGraphUsages::depth_read_only)
+			->write(water_pass, m_color_resource, Pipeline::RenderGraphUsages::color_attachment);
+
+		const unsigned int blit_pass = m_render_graph.addPass("Blit", RecordBlitPass, this);
+		m_render_graph.read(blit_pass, m_color_resource, Pipeline::RenderGraphUsages::transfer_src)
+			->write(blit_pass, m_swap_chain_image_resource, Pipeline::RenderGraphUsages::transfer_dst, false);
+
+		m_render_graph.compile();
+	}
+
+	void Isonia::RecordScenePass(VkCommandBuffer command_buffer, void* isonia, void* frame_info)
+	{
+		Isonia* self = static_cast<Isonia*>(isonia);
+		const State::FrameInfo* info = static_cast<const State::FrameInfo*>(frame_info);
+
+		// culling touches every chunk, so it runs once before the ranges are handed out
+		self->m_ground_render_system->frustumCull(&self->m_player.m_camera);
+
+		Pipeline::GpuTimer* gpu_timer = self->m_renderer.getGpuTimer();
+		const unsigned int query = gpu_timer->begin(command_buffer, Pipeline::RenderScopes::scene_pass);
+		Pipeline::ParallelRecorder* parallel_recorder = self->m_renderer.beginParallelRenderPass(command_buffer, 0u, frame_info);
+		// grass is recorded after the ground of the same chunks, so it keeps the ground's viewport and descriptor sets
+		parallel_recorder->addJobs(RecordGroundJob, self, Pipeline::RenderScopes::ground, self->m_ground_render_system->getChunkCount());
+		parallel_recorder->addJob(RecordDebuggerJob, self, Pipeline::RenderScopes::debugger);
+		parallel_recorder->execute(info->recorder);
+		self->m_renderer.endSwapChainRenderPass(command_buffer);
+		gpu_timer->end(command_buffer, query);
+	}
+
+	void Isonia::RecordWaterPass(VkCommandBuffer command_buffer, void* isonia, void* frame_info)
+	{
+		Isonia* self = static_cast<Isonia*>(isonia);
+		const State::FrameInfo* info = static_cast<const State::FrameInfo*>(frame_info);
+
+		Pipeline::GpuTimer* gpu_timer = self->m_renderer.getGpuTimer();
+		const unsigned int query = gpu_timer->begin(command_buffer, Pipeline::RenderScopes::water_pass);
+		Pipeline::ParallelRecorder* parallel_recorder = self->m_renderer.beginParallelRenderPass(command_buffer, 1u, frame_info);
+		parallel_recorder->addJob(RecordWaterJob, self, Pipeline::RenderScopes::water);
+		parallel_recorder->addJob(RecordUIJob, self, Pipeline::RenderScopes::ui);
+		parallel_recorder->execute(info->recorder);
+		self->m_renderer.endSwapChainRenderPass(command_buffer);
+		gpu_timer->end(command_buffer, query);
+	}
+
+	void Isonia::RecordGroundJob(Pipeline::CommandRecorder* recorder, void* isonia, void* frame_info, unsigned int first, unsigned int last)
+	{
+		Isonia* self = static_cast<Isonia*>(isonia);
+		const State::FrameInfo job_info{ static_cast<const State::FrameInfo*>(frame_info), recorder->getCommandBuffer(), recorder };
+		Pipeline::GpuTimer* gpu_timer = self->m_renderer.getGpuTimer();
+		const VkDescriptorSet* ground_descriptor_set = self->m_ground_descriptor_manager->getDescriptorSets(job_info.frame_index);
+		const VkDescriptorSet* weather_descriptor_set = self->m_weather_descriptor_manager->getDescriptorSets(job_info.frame_index);
+
+		const unsigned int ground_query = gpu_timer->begin(job_info.command_buffer, Pipeline::RenderScopes::ground);
+		self->m_ground_render_system->renderGround(ground_descriptor_set, weather_descriptor_set, &job_info, first, last);
+		gpu_timer->end(job_info.command_buffer, ground_query);
+
+		// the grass is opaque and depth tested, drawing it between ground ranges does not change the image
+		const unsigned int grass_query = gpu_timer->begin(job_info.command_buffer, Pipeline::RenderScopes::grass);
+		self->m_ground_render_system->renderGrass(ground_descriptor_set, weather_descriptor_set, &job_info, first, last);
+		gpu_timer->end(job_info.command_buffer, grass_query);
+	}
+
+	void Isonia::RecordDebuggerJob(Pipeline::CommandRecorder* recorder, void* isonia, void* frame_info, unsigned int first, unsigned int last)
+	{
+		Isonia* self = static_cast<Isonia*>(isonia);
+		const State::FrameInfo job_info{ static_cast<const State::FrameInfo*>(frame_info), recorder->getCommandBuffer(), recorder };
+		Pipeline::GpuTimer* gpu_timer = self->m_renderer.getGpuTimer();
+		const unsigned int query = gpu_timer->begin(job_info.command_buffer, Pipeline::RenderScopes::debugger);
+
+		self->m_debugger_render_system->render(self->m_texture_heap != nullptr ? self->m_texture_heap->getDescriptorSet() : self->m_debugger_descriptor_manager->getDescriptorSets(job_info.frame_index), &job_info);
+		gpu_timer->end(job_info.command_buffer, query);
+	}
+
+	void Isonia::RecordWaterJob(Pipeline::CommandRecorder* recorder, void* isonia, void* frame_info, unsigned int first, unsigned int last)
+	{
+		Isonia* self = static_cast<Isonia*>(isonia);
+		const State::FrameInfo job_info{ static_cast<const State::FrameInfo*>(frame_info), recorder->getCommandBuffer(), recorder };
+		Pipeline::GpuTimer* gpu_timer = self->m_renderer.getGpuTimer();
+		const unsigned int query = gpu_timer->begin(job_info.command_buffer, Pipeline::RenderScopes::water);
+
+		self->m_water_render_system->render(
+			self->m_ground_descriptor_manager->getDescriptorSets(job_info.frame_index),
+			&job_info,
+			&self->m_player.m_camera
+		);
+		gpu_timer->end(job_info.command_buffer, query);
+	}
+
+	void Isonia::RecordUIJob(Pipeline::CommandRecorder* recorder, void* isonia, void* frame_info, unsigned int first, unsigned int last)
+	{
+		Isonia* self = static_cast<Isonia*>(isonia);
+		const State::FrameInfo job_info{ static_cast<const State::FrameInfo*>(frame_info), recorder->getCommandBuffer(), recorder };
+		Pipeline::GpuTimer* gpu_timer = self->m_renderer.getGpuTimer();
+		const unsigned int query = gpu_timer->begin(job_info.command_buffer, Pipeline::RenderScopes::ui);
+
+		self->m_ui_render_system->render(self->m_texture_heap != nullptr ? self->m_texture_heap->getDescriptorSet() : self->m_text_descriptor_manager->getDescriptorSets(job_info.frame_index), &job_info, &self->m_player.m_camera);
+		gpu_timer->end(job_info.command_buffer, query);
+	}
+
+	void Isonia::RecordBlitPass(VkCommandBuffer command_buffer, void* isonia, void* frame_info)
+	{
+		Isonia* self = static_cast<Isonia*>(isonia);
+		Pipeline::GpuTimer* gpu_timer = self->m_renderer.getGpuTimer();
+		const unsigned int query = gpu_timer->begin(command_buffer, Pipeline::RenderScopes::blit_pass);
+		self->m_renderer.blit(command_buffer, self->m_player.m_camera.m_sub_pixel_offset);
+		gpu_timer->end(command_buffer, query);
+	}
+
 	void Isonia::initializeEntities()
 	{
 	}
@@ -392,12 +722,10 @@ namespace Isonia
 		Pipeline::Descriptors::DescriptorManager* m_global_swapchain_descriptor_manager = static_cast<Pipeline::Descriptors::DescriptorManager*>(descriptor_manager);
 		for (int i = 0; i < frames_in_flight; i++)
 		{
-			const VkDescriptorImageInfo* intermediate_color_buffer_image_info = renderer->getPixelSwapChain()->getIntermediateImageInfo(i);
-			const VkDescriptorImageInfo* intermediate_depth_buffer_image_info = renderer->getPixelSwapChain()->getIntermediateDepthImageInfo(i);
+			const VkDescriptorImageInfo* depth_buffer_image_info = renderer->getPixelSwapChain()->getDepthImageInfo(i);
 
 			m_global_swapchain_descriptor_manager->getWriters(i)
-				->writeImage(0u, intermediate_color_buffer_image_info)
-				->writeImage(1u, intermediate_depth_buffer_image_info)
+				->writeImage(0u, depth_buffer_image_info)
 				->overwrite(m_global_swapchain_descriptor_manager->getDescriptorSets(i));
 		}
 	}
@@ -16,6 +16,27 @@
 
 namespace Isonia
 {
+	struct HeadlessSettings
+	{
+		unsigned int frame_count = 600u;
+		// fixed, so every run simulates the same frames, a replayed recording brings its own
+		float frame_time_s = 1.0f / 60.0f;
+		// frames are written to "<dump_path><frame>.ppm" when set, reading them back stalls the gpu
+		const char* dump_path = nullptr;
+		// per frame cpu and gpu timings are written here as csv when set, kept off stdout as that is the log
+		const char* csv_path = nullptr;
+	};
+
+	struct ReplaySettings
+	{
+		// the session's keyboard input and frame times are recorded here when set
+		const char* record_path = nullptr;
+		// replays a recording, its frame times replace the clock and the run ends with it
+		const char* input_path = nullptr;
+		// flies the camera along keyframed transforms instead of the keyboard, the run ends with the path
+		const char* camera_path = nullptr;
+	};
+
 	struct Isonia
 	{
 	public:
@@ -23,65 +44,103 @@ namespace Isonia
 		static constexpr const unsigned int height = 576;
 		static constexpr const char* name = "Isonia";
 
-		Isonia();
+		// without headless settings a window is opened, otherwise the frames are rendered offscreen
+		Isonia(const HeadlessSettings* headless_settings = nullptr, const ReplaySettings* replay_settings = nullptr);
 		~Isonia();
 
 		Isonia(const Isonia&) = delete;
 		Isonia& operator=(const Isonia&) = delete;
 
-		void run();
+		// frame time stats are written to "<stats_path>.csv" and "<stats_path>.json" on exit when set
+		void run(const char* stats_path = nullptr);
 
 		State::GlobalUbo m_ubo{};
 		State::Clock m_clock{};
 
 	private:
+		void runHeadless();
+		// moves the player by recorded, scripted or live input, false once a replay ran out
+		bool updatePlayer(float* frame_time_s);
+		// the frame index rendered to, -1 when the frame was skipped
+		int drawFrame(float frame_time_s, const char* performance_text);
+		void writeFrame(unsigned int frame, const unsigned char* rgb) const;
+		void exportFrameTimes(const char* stats_path);
+
 		void initializeDescriptorPools();
 		void initializeGlobalDescriptorPool();
 		void initializeSwapChainDescriptorPool();
 		void initializeWeatherDescriptorPool();
 		void initializeGroundDescriptorPool();
-		void initializeWaterDescriptorPool();
 		void initializeTextDescriptorPool();
 		void initializeDebuggerDescriptorPool();
 
 		void initializeRenderSystems();
+		void initializeRenderGraph();
 		void initializeEntities();
 		void initializePlayer();
 
 		static void OverwriteSwapChainDescriptorSets(Pipeline::PixelRenderer* renderer, void* descriptor_manager);
 
+		static void RecordScenePass(VkCommandBuffer command_buffer, void* isonia, void* frame_info);
+		static void RecordWaterPass(VkCommandBuffer command_buffer, void* isonia, void* frame_info);
+		static void RecordBlitPass(VkCommandBuffer command_buffer, void* isonia, void* frame_info);
+
+		static void RecordGroundJob(Pipeline::CommandRecorder* recorder, void* isonia, void* frame_info, unsigned int first, unsigned int last);
+		static void RecordDebuggerJob(Pipeline::CommandRecorder* recorder, void* isonia, void* frame_info, unsigned int first, unsigned int last);
+		static void RecordWaterJob(Pipeline::CommandRecorder* recorder, void* isonia, void* frame_info, unsigned int first, unsigned int last);
+		static void RecordUIJob(Pipeline::CommandRecorder* recorder, void* isonia, void* frame_info, unsigned int first, unsigned int last);
+
 		Pipeline::Descriptors::DescriptorManager* m_global_swapchain_descriptor_manager;
 		Pipeline::Descriptors::DescriptorManager* m_global_descriptor_manager;
 
 		Pipeline::Descriptors::DescriptorManager* m_weather_descriptor_manager;
-		Pipeline::Descriptors::DescriptorManager* m_water_descriptor_manager;
 		Pipeline::Descriptors::DescriptorManager* m_ground_descriptor_manager;		
-		Pipeline::Descriptors::DescriptorManager* m_text_descriptor_manager;
-		Pipeline::Descriptors::DescriptorManager* m_debugger_descriptor_manager;
+		Pipeline::Descriptors::DescriptorManager* m_text_descriptor_manager = nullptr;
+		Pipeline::Descriptors::DescriptorManager* m_debugger_descriptor_manager = nullptr;
 
-		Pipeline::Buffer* m_ubo_buffers[Pipeline::max_frames_in_flight];
-		Pipeline::Buffer* m_clock_buffers[Pipeline::max_frames_in_flight];
+		// null without descriptor indexing, the text and debugger textures then keep their own descriptor managers
+		Pipeline::Descriptors::TextureHeap* m_texture_heap = nullptr;
+		unsigned int m_text_texture_index = Pipeline::Descriptors::TextureHeap::invalid_index;
+		unsigned int m_debugger_texture_index = Pipeline::Descriptors::TextureHeap::invalid_index;
 
 		Pipeline::RenderSystems::GroundRenderSystem* m_ground_render_system;
 		Pipeline::RenderSystems::WaterRenderSystem* m_water_render_system;
 		Pipeline::RenderSystems::DebuggerRenderSystem* m_debugger_render_system;
 		Pipeline::RenderSystems::UIRenderSystem* m_ui_render_system;
 
-		Renderable::Texture* m_grass_day_palette;
-		Renderable::Texture* m_water_day_palette;
+		// the swap chain's images are set on the graph every frame
+		Pipeline::RenderGraph m_render_graph{};
+		unsigned int m_color_resource;
+		unsigned int m_depth_resource;
+		unsigned int m_swap_chain_image_resource;
+
+		Renderable::TextureArray* m_palettes;
 		Renderable::Texture* m_grass;
 		Renderable::Texture* m_debugger;
-		Renderable::Texture* m_cloud;
+		Noise::ConstantScalarWarpNoise m_cloud_warp_noise{ 5.0f };
+		Noise::FractalPerlinNoise m_cloud_noise{ 69, 3, 2.0f, 0.5f, 0.0f };
+		Renderable::Noise4DTextureFactory* m_cloud_texture_factory;
+		Renderable::AnimatedNoiseTexture* m_cloud;
 		Renderable::Texture* m_wind;
 		Renderable::Font* m_text;
 
 		Renderable::Model* m_sphere_model;
 		Renderable::Model* m_prism_models[20];
 
+		Debug::PerformanceTracker m_performance_tracker{};
+
 		//Controllers::Player m_player{};
 		Controllers::PlayerIsometric m_player{};
 
-		Pipeline::Window m_window{ width, height, name };
+		bool m_is_headless;
+		HeadlessSettings m_headless_settings{};
+
+		Controllers::InputRecorder* m_input_recorder = nullptr;
+		Controllers::InputReplay* m_input_replay = nullptr;
+		Controllers::CameraPath* m_camera_path = nullptr;
+		float m_camera_path_time_s = 0.0f;
+
+		Pipeline::Window m_window;
 		Pipeline::Device m_device{ &m_window };
 		//Pipeline::Renderer m_renderer{ &m_window, &m_device };
 		Pipeline::PixelRenderer m_renderer{ &m_window, &m_device };
@@ -3,10 +3,75 @@
 // internal
 #include "Isonia.h"
 
-int main()
+// external
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv)
 {
-    Isonia::Isonia isonia{};
-    isonia.run();
+    // --headless <frames> renders offscreen without a window, --csv <file> writes its per frame timings
+    Isonia::HeadlessSettings headless_settings{};
+    bool is_headless = false;
+    // --record <file>, --replay <file> and --camera-path <file> make runs reproducible
+    Isonia::ReplaySettings replay_settings{};
+    // --stats <prefix> exports the frame time percentiles and histogram on exit
+    const char* stats_path = nullptr;
+#if PROFILING
+    // --trace <file> writes the profiling zones as chrome trace events on exit
+    const char* trace_path = nullptr;
+#endif
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+        {
+            is_headless = true;
+            headless_settings.frame_count = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--frame-time") == 0 && i + 1 < argc)
+        {
+            headless_settings.frame_time_s = strtof(argv[++i], nullptr);
+        }
+        else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc)
+        {
+            headless_settings.dump_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+        {
+            headless_settings.csv_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            replay_settings.record_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            replay_settings.input_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--camera-path") == 0 && i + 1 < argc)
+        {
+            replay_settings.camera_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc)
+        {
+            stats_path = argv[++i];
+        }
+#if PROFILING
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            trace_path = argv[++i];
+        }
+#endif
+    }
+
+    Isonia::Isonia isonia{ is_headless ? &headless_settings : nullptr, &replay_settings };
+    isonia.run(stats_path);
+
+#if PROFILING
+    if (trace_path != nullptr)
+    {
+        Isonia::Debug::Profiler::exportChromeTrace(trace_path);
+    }
+#endif
 }
 
 #endif
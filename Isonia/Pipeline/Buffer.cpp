@@ -6,12 +6,12 @@
 
 namespace Isonia::Pipeline
 {
-    Buffer::Buffer(Device* device, VkDeviceSize instance_size, unsigned int instance_count, VkBufferUsageFlags usage_flags, VkMemoryPropertyFlags memory_property_flags, VkDeviceSize min_offset_alignment)
+    Buffer::Buffer(Device* device, VkDeviceSize instance_size, unsigned int instance_count, VkBufferUsageFlags usage_flags, VkMemoryPropertyFlags memory_property_flags, VkDeviceSize min_offset_alignment, unsigned int category)
         : m_device(device), m_instance_size(instance_size), m_instance_count(instance_count), m_usage_flags(usage_flags), m_memory_property_flags(memory_property_flags)
     {
         m_alignment_size = getAlignment(instance_size, min_offset_alignment);
         m_buffer_size = m_alignment_size * instance_count;
-        device->createBuffer(m_buffer_size, usage_flags, memory_property_flags, &m_buffer, &m_memory);
+        device->createBuffer(m_buffer_size, usage_flags, memory_property_flags, &m_buffer, &m_allocation, category);
         m_buffer_info = VkDescriptorBufferInfo{
             m_buffer,
             //m_buffer_size, m_alignment_size
@@ -23,27 +23,30 @@ namespace Isonia::Pipeline
     Buffer::~Buffer()
     {
         unmap();
-        vkDestroyBuffer(m_device->getDevice(), m_buffer, nullptr);
-        vkFreeMemory(m_device->getDevice(), m_memory, nullptr);
+        // frames in flight may still read the buffer
+        m_device->getDeletionQueue()->destroyBuffer(m_buffer, &m_allocation);
     }
 
     VkResult Buffer::map(VkDeviceSize size, VkDeviceSize offset)
     {
-        assert(m_buffer && m_memory && "Called map on buffer before create");
-        return vkMapMemory(m_device->getDevice(), m_memory, offset, size, 0, &m_mapped);
+        assert(m_buffer && m_allocation.memory && "Called map on buffer before create");
+        // host visible memory is persistently mapped by the allocator
+        if (m_allocation.mapped == nullptr)
+        {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        m_mapped = static_cast<char*>(m_allocation.mapped) + offset;
+        return VK_SUCCESS;
     }
 
     void Buffer::unmap()
     {
-        if (m_mapped)
-        {
-            vkUnmapMemory(m_device->getDevice(), m_memory);
-            m_mapped = nullptr;
-        }
+        m_mapped = nullptr;
     }
 
-    void Buffer::writeToBuffer(void* data, VkDeviceSize size, VkDeviceSize offset)
+    void Buffer::writeToBuffer(const void* data, VkDeviceSize size, VkDeviceSize offset)
     {
+        ISONIA_PROFILE_FUNCTION();
         assert(m_mapped && "Cannot copy to unmapped buffer");
 
         if (size == VK_WHOLE_SIZE)
@@ -60,22 +63,13 @@ namespace Isonia::Pipeline
 
     VkResult Buffer::flush(VkDeviceSize size, VkDeviceSize offset)
     {
-        VkMappedMemoryRange mapped_range = {};
-        mapped_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mapped_range.memory = m_memory;
-        mapped_range.offset = offset;
-        mapped_range.size = size;
-        return vkFlushMappedMemoryRanges(m_device->getDevice(), 1, &mapped_range);
+        ISONIA_PROFILE_FUNCTION();
+        return m_device->getAllocator()->flush(&m_allocation, size, offset);
     }
 
     VkResult Buffer::invalidate(VkDeviceSize size, VkDeviceSize offset)
     {
-        VkMappedMemoryRange mapped_range = {};
-        mapped_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mapped_range.memory = m_memory;
-        mapped_range.offset = offset;
-        mapped_range.size = size;
-        return vkInvalidateMappedMemoryRanges(m_device->getDevice(), 1, &mapped_range);
+        return m_device->getAllocator()->invalidate(&m_allocation, size, offset);
     }
 
     const VkDescriptorBufferInfo* Buffer::getDescriptorInfo() const
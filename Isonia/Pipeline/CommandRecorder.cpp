@@ -0,0 +1,211 @@
+// internal
+#include "Pipeline.h"
+
+// external
+#include <cassert>
+#include <cstring>
+
+namespace Isonia::Pipeline
+{
+	CommandRecorder::CommandRecorder()
+	{
+	}
+
+	void CommandRecorder::begin(VkCommandBuffer command_buffer)
+	{
+		m_command_buffer = command_buffer;
+		m_frame_stats = m_stats;
+		m_stats = {};
+		memset(m_scope_stats, 0, sizeof(m_scope_stats));
+		invalidate();
+	}
+
+	void CommandRecorder::invalidate()
+	{
+		m_pipeline = nullptr;
+		m_descriptor_layout = nullptr;
+		memset(m_descriptor_sets, 0, sizeof(m_descriptor_sets));
+		memset(m_vertex_buffers, 0, sizeof(m_vertex_buffers));
+		m_index_buffer = nullptr;
+		m_push_constant_layout = nullptr;
+		m_push_constants_begin = 0u;
+		m_push_constants_end = 0u;
+	}
+
+	VkCommandBuffer CommandRecorder::getCommandBuffer() const
+	{
+		return m_command_buffer;
+	}
+
+	const CommandRecorderStats* CommandRecorder::getFrameStats() const
+	{
+		return &m_frame_stats;
+	}
+
+	const CommandRecorderStats* CommandRecorder::getStats() const
+	{
+		return &m_stats;
+	}
+
+	void CommandRecorder::addStats(CommandRecorderStats* stats, const CommandRecorderStats* other)
+	{
+		for (unsigned int i = 0u; i < CommandTypes::count; i++)
+		{
+			stats->issued[i] += other->issued[i];
+			stats->elided[i] += other->elided[i];
+		}
+		stats->vertices += other->vertices;
+		stats->instances += other->instances;
+		stats->push_constant_bytes += other->push_constant_bytes;
+	}
+
+	void CommandRecorder::accumulate(const CommandRecorderStats* stats, unsigned int scope)
+	{
+		assert(scope < RenderScopes::count && "Render scope out of range");
+
+		addStats(&m_stats, stats);
+		addStats(&m_scope_stats[scope], stats);
+	}
+
+	const CommandRecorderStats* CommandRecorder::getScopeStats(unsigned int scope) const
+	{
+		return &m_scope_stats[scope];
+	}
+
+	void CommandRecorder::bindPipeline(VkPipeline pipeline)
+	{
+		if (pipeline == m_pipeline)
+		{
+			m_stats.elided[CommandTypes::pipeline]++;
+			return;
+		}
+
+		vkCmdBindPipeline(m_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		m_pipeline = pipeline;
+		m_stats.issued[CommandTypes::pipeline]++;
+	}
+
+	void CommandRecorder::bindDescriptorSets(VkPipelineLayout layout, unsigned int first_set, unsigned int set_count, const VkDescriptorSet* descriptor_sets, unsigned int dynamic_offset_count, const unsigned int* dynamic_offsets)
+	{
+		assert(first_set + set_count <= max_descriptor_sets && "Too many descriptor sets for the command recorder");
+		assert(dynamic_offset_count <= max_dynamic_offsets && "Too many dynamic offsets for the command recorder");
+
+		// compatibility is only assumed for the same layout, any other layout may disturb every set
+		if (layout != m_descriptor_layout)
+		{
+			memset(m_descriptor_sets, 0, sizeof(m_descriptor_sets));
+			m_descriptor_layout = layout;
+		}
+
+		bool is_bound = true;
+		for (unsigned int i = 0u; i < set_count && is_bound; i++)
+		{
+			const BoundDescriptorSet* bound = &m_descriptor_sets[first_set + i];
+			const unsigned int offset_count = i == 0u ? dynamic_offset_count : 0u;
+			is_bound = bound->descriptor_set == descriptor_sets[i] &&
+				bound->dynamic_offset_count == offset_count &&
+				(offset_count == 0u || memcmp(bound->dynamic_offsets, dynamic_offsets, offset_count * sizeof(unsigned int)) == 0);
+		}
+		if (is_bound)
+		{
+			m_stats.elided[CommandTypes::descriptor_sets]++;
+			return;
+		}
+
+		vkCmdBindDescriptorSets(m_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, first_set, set_count, descriptor_sets, dynamic_offset_count, dynamic_offsets);
+		for (unsigned int i = 0u; i < set_count; i++)
+		{
+			BoundDescriptorSet* bound = &m_descriptor_sets[first_set + i];
+			bound->descriptor_set = descriptor_sets[i];
+			bound->dynamic_offset_count = i == 0u ? dynamic_offset_count : 0u;
+			if (bound->dynamic_offset_count != 0u)
+			{
+				memcpy(bound->dynamic_offsets, dynamic_offsets, dynamic_offset_count * sizeof(unsigned int));
+			}
+		}
+		m_stats.issued[CommandTypes::descriptor_sets]++;
+	}
+
+	void CommandRecorder::bindVertexBuffers(unsigned int first_binding, unsigned int binding_count, const VkBuffer* buffers, const VkDeviceSize* offsets)
+	{
+		assert(first_binding + binding_count <= max_vertex_buffers && "Too many vertex buffers for the command recorder");
+
+		bool is_bound = true;
+		for (unsigned int i = 0u; i < binding_count && is_bound; i++)
+		{
+			is_bound = m_vertex_buffers[first_binding + i] == buffers[i] && m_vertex_offsets[first_binding + i] == offsets[i];
+		}
+		if (is_bound)
+		{
+			m_stats.elided[CommandTypes::vertex_buffers]++;
+			return;
+		}
+
+		vkCmdBindVertexBuffers(m_command_buffer, first_binding, binding_count, buffers, offsets);
+		memcpy(&m_vertex_buffers[first_binding], buffers, binding_count * sizeof(VkBuffer));
+		memcpy(&m_vertex_offsets[first_binding], offsets, binding_count * sizeof(VkDeviceSize));
+		m_stats.issued[CommandTypes::vertex_buffers]++;
+	}
+
+	void CommandRecorder::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType index_type)
+	{
+		if (buffer == m_index_buffer && offset == m_index_offset && index_type == m_index_type)
+		{
+			m_stats.elided[CommandTypes::index_buffer]++;
+			return;
+		}
+
+		vkCmdBindIndexBuffer(m_command_buffer, buffer, offset, index_type);
+		m_index_buffer = buffer;
+		m_index_offset = offset;
+		m_index_type = index_type;
+		m_stats.issued[CommandTypes::index_buffer]++;
+	}
+
+	void CommandRecorder::pushConstants(VkPipelineLayout layout, VkShaderStageFlags stage_flags, unsigned int offset, unsigned int size, const void* values)
+	{
+		assert(offset + size <= max_push_constants_size && "Push constants are larger than the command recorder tracks");
+
+		const bool is_same_range = layout == m_push_constant_layout && stage_flags == m_push_constant_stages;
+		if (is_same_range && offset >= m_push_constants_begin && offset + size <= m_push_constants_end && memcmp(m_push_constants + offset, values, size) == 0)
+		{
+			m_stats.elided[CommandTypes::push_constants]++;
+			return;
+		}
+
+		vkCmdPushConstants(m_command_buffer, layout, stage_flags, offset, size, values);
+
+		// known bytes only grow while the pushes stay contiguous, anything else starts over
+		if (is_same_range && offset <= m_push_constants_end && offset + size >= m_push_constants_begin)
+		{
+			m_push_constants_begin = offset < m_push_constants_begin ? offset : m_push_constants_begin;
+			m_push_constants_end = offset + size > m_push_constants_end ? offset + size : m_push_constants_end;
+		}
+		else
+		{
+			m_push_constant_layout = layout;
+			m_push_constant_stages = stage_flags;
+			m_push_constants_begin = offset;
+			m_push_constants_end = offset + size;
+		}
+		memcpy(m_push_constants + offset, values, size);
+		m_stats.issued[CommandTypes::push_constants]++;
+		m_stats.push_constant_bytes += size;
+	}
+
+	void CommandRecorder::draw(unsigned int vertex_count, unsigned int instance_count, unsigned int first_vertex, unsigned int first_instance)
+	{
+		vkCmdDraw(m_command_buffer, vertex_count, instance_count, first_vertex, first_instance);
+		m_stats.issued[CommandTypes::draw]++;
+		m_stats.vertices += static_cast<unsigned long long>(vertex_count) * instance_count;
+		m_stats.instances += instance_count;
+	}
+
+	void CommandRecorder::drawIndexed(unsigned int index_count, unsigned int instance_count, unsigned int first_index, int vertex_offset, unsigned int first_instance)
+	{
+		vkCmdDrawIndexed(m_command_buffer, index_count, instance_count, first_index, vertex_offset, first_instance);
+		m_stats.issued[CommandTypes::draw]++;
+		m_stats.vertices += static_cast<unsigned long long>(index_count) * instance_count;
+		m_stats.instances += instance_count;
+	}
+}
@@ -0,0 +1,128 @@
+// internal
+#include "Pipeline.h"
+
+// external
+#include <cstdlib>
+
+namespace Isonia::Pipeline
+{
+	DeletionQueue::DeletionQueue(Device* device) : m_device{ device }
+	{
+		m_entries = (DeferredDestruction*)malloc(m_capacity * sizeof(DeferredDestruction));
+	}
+
+	DeletionQueue::~DeletionQueue()
+	{
+		flush();
+		free(m_entries);
+	}
+
+	void DeletionQueue::destroyBuffer(VkBuffer buffer, MemoryAllocation* allocation)
+	{
+		DeferredDestruction entry{};
+		entry.buffer = buffer;
+		entry.allocation = *allocation;
+		*allocation = MemoryAllocation{};
+		enqueue(&entry);
+	}
+
+	void DeletionQueue::destroyImage(VkImage image, MemoryAllocation* allocation)
+	{
+		DeferredDestruction entry{};
+		entry.image = image;
+		entry.allocation = *allocation;
+		*allocation = MemoryAllocation{};
+		enqueue(&entry);
+	}
+
+	void DeletionQueue::destroyImageView(VkImageView image_view)
+	{
+		DeferredDestruction entry{};
+		entry.image_view = image_view;
+		enqueue(&entry);
+	}
+
+	void DeletionQueue::destroySampler(VkSampler sampler)
+	{
+		DeferredDestruction entry{};
+		entry.sampler = sampler;
+		enqueue(&entry);
+	}
+
+	void DeletionQueue::retire()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// frame n is covered by the n-th end of frame fence, which the caller has waited
+		// for once max_frames_in_flight more frames have ended
+		while (m_count > 0u && m_entries[m_head].frame + max_frames_in_flight <= m_frame)
+		{
+			destroy(&m_entries[m_head]);
+			m_head = (m_head + 1u) % m_capacity;
+			m_count--;
+		}
+	}
+
+	void DeletionQueue::endFrame()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_frame++;
+	}
+
+	void DeletionQueue::flush()
+	{
+		vkDeviceWaitIdle(m_device->getDevice());
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		while (m_count > 0u)
+		{
+			destroy(&m_entries[m_head]);
+			m_head = (m_head + 1u) % m_capacity;
+			m_count--;
+		}
+	}
+
+	void DeletionQueue::enqueue(const DeferredDestruction* entry)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_count == m_capacity)
+		{
+			// unwrap into the grown array so entries stay in frame order
+			DeferredDestruction* entries = (DeferredDestruction*)malloc(m_capacity * 2u * sizeof(DeferredDestruction));
+			for (unsigned int i = 0u; i < m_count; i++)
+			{
+				entries[i] = m_entries[(m_head + i) % m_capacity];
+			}
+			free(m_entries);
+			m_entries = entries;
+			m_head = 0u;
+			m_capacity *= 2u;
+		}
+
+		DeferredDestruction* slot = &m_entries[(m_head + m_count) % m_capacity];
+		*slot = *entry;
+		slot->frame = m_frame;
+		m_count++;
+	}
+
+	void DeletionQueue::destroy(DeferredDestruction* entry)
+	{
+		if (entry->sampler != nullptr)
+		{
+			vkDestroySampler(m_device->getDevice(), entry->sampler, nullptr);
+		}
+		if (entry->image_view != nullptr)
+		{
+			vkDestroyImageView(m_device->getDevice(), entry->image_view, nullptr);
+		}
+		if (entry->image != nullptr)
+		{
+			m_device->destroyImage(entry->image, &entry->allocation);
+		}
+		if (entry->buffer != nullptr)
+		{
+			m_device->destroyBuffer(entry->buffer, &entry->allocation);
+		}
+	}
+}
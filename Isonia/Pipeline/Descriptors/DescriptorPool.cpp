@@ -12,6 +12,7 @@ namespace Isonia::Pipeline::Descriptors
 	}
 	DescriptorPool::~DescriptorPool()
 	{
+		m_device->trackDescriptorSets(-static_cast<int>(m_allocated_count));
 		vkDestroyDescriptorPool(m_device->getDevice(), m_descriptor_pool, nullptr);
 		free(m_pool_sizes);
 	}
@@ -39,7 +40,7 @@ namespace Isonia::Pipeline::Descriptors
 		return this;
 	}
 
-	bool DescriptorPool::allocateDescriptor(const VkDescriptorSetLayout descriptor_set_layout, VkDescriptorSet* descriptor) const
+	bool DescriptorPool::allocateDescriptor(const VkDescriptorSetLayout descriptor_set_layout, VkDescriptorSet* descriptor)
 	{
 		VkDescriptorSetAllocateInfo alloc_info{};
 		alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -51,10 +52,12 @@ namespace Isonia::Pipeline::Descriptors
 		{
 			return false;
 		}
+		m_allocated_count++;
+		m_device->trackDescriptorSets(1);
 		return true;
 	}
 
-	void DescriptorPool::freeDescriptors(const VkDescriptorSet* descriptors, const unsigned int descriptors_count) const
+	void DescriptorPool::freeDescriptors(const VkDescriptorSet* descriptors, const unsigned int descriptors_count)
 	{
 		vkFreeDescriptorSets(
 			m_device->getDevice(),
@@ -62,10 +65,14 @@ namespace Isonia::Pipeline::Descriptors
 			descriptors_count,
 			descriptors
 		);
+		m_allocated_count -= descriptors_count;
+		m_device->trackDescriptorSets(-static_cast<int>(descriptors_count));
 	}
 
 	void DescriptorPool::resetPool()
 	{
 		vkResetDescriptorPool(m_device->getDevice(), m_descriptor_pool, 0);
+		m_device->trackDescriptorSets(-static_cast<int>(m_allocated_count));
+		m_allocated_count = 0u;
 	}
 }
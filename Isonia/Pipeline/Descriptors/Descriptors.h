@@ -46,8 +46,8 @@ namespace Isonia::Pipeline::Descriptors
 		DescriptorPool* addPoolSize(const VkDescriptorType descriptor_type, const unsigned int count);
 		DescriptorPool* build(const unsigned int max_sets = 1024, const VkDescriptorPoolCreateFlags pool_flags = 0);
 
-		bool allocateDescriptor(const VkDescriptorSetLayout descriptor_set_layout, VkDescriptorSet* descriptor) const;
-		void freeDescriptors(const VkDescriptorSet* descriptors, const unsigned int descriptors_count) const;
+		bool allocateDescriptor(const VkDescriptorSetLayout descriptor_set_layout, VkDescriptorSet* descriptor);
+		void freeDescriptors(const VkDescriptorSet* descriptors, const unsigned int descriptors_count);
 		void resetPool();
 
 	private:
@@ -57,6 +57,7 @@ namespace Isonia::Pipeline::Descriptors
 		unsigned int m_pool_sizes_index = 0;
 
 		VkDescriptorPool m_descriptor_pool;
+		unsigned int m_allocated_count = 0u;
 
 		friend struct DescriptorWriter;
 	};
@@ -87,6 +88,44 @@ namespace Isonia::Pipeline::Descriptors
 		const unsigned int m_writes_count;
 	};
 
+	struct TextureHeap
+	{
+	public:
+		static constexpr const unsigned int max_textures = 4096u;
+		static constexpr const unsigned int invalid_index = ~0u;
+
+		TextureHeap(Device* device, const unsigned int capacity = max_textures);
+		~TextureHeap();
+
+		TextureHeap() = delete;
+		TextureHeap(const TextureHeap&) = delete;
+		TextureHeap& operator=(const TextureHeap&) = delete;
+
+		static bool isSupported(const Device* device);
+
+		// the returned index is what shaders use to sample the texture, typically through a push constant
+		unsigned int registerTexture(const VkDescriptorImageInfo* image_info);
+		void updateTexture(const unsigned int index, const VkDescriptorImageInfo* image_info);
+		// frames still in flight may sample the slot, release it only once they have finished
+		void unregisterTexture(const unsigned int index);
+
+		VkDescriptorSetLayout getSetLayout() const;
+		const VkDescriptorSet* getDescriptorSet() const;
+
+	private:
+		void write(const unsigned int index, const VkDescriptorImageInfo* image_info);
+
+		Device* m_device;
+		const unsigned int m_capacity;
+		unsigned int m_count = 0u;
+		unsigned int* m_free_indices;
+		unsigned int m_free_count = 0u;
+
+		VkDescriptorPool m_descriptor_pool;
+		VkDescriptorSetLayout m_descriptor_set_layout;
+		VkDescriptorSet m_descriptor_set;
+	};
+
 	struct DescriptorManager
 	{
 	public:
@@ -0,0 +1,135 @@
+// internal
+#include "Descriptors.h"
+
+// external
+#include <cassert>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace Isonia::Pipeline::Descriptors
+{
+	TextureHeap::TextureHeap(Device* device, const unsigned int capacity)
+		: m_device(device), m_capacity(Math::clampui(capacity, 1u, device->m_max_bindless_textures)), m_free_indices((unsigned int*)malloc(m_capacity * sizeof(unsigned int)))
+	{
+		assert(isSupported(device) && "Cannot create a texture heap without descriptor indexing");
+
+		// unwritten slots are never sampled, so the array may stay partially bound and grow while frames are in flight
+		const VkDescriptorBindingFlagsEXT binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_info{};
+		binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+		binding_flags_info.bindingCount = 1u;
+		binding_flags_info.pBindingFlags = &binding_flags;
+
+		VkDescriptorSetLayoutBinding layout_binding{};
+		layout_binding.binding = 0u;
+		layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		layout_binding.descriptorCount = m_capacity;
+		layout_binding.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+
+		VkDescriptorSetLayoutCreateInfo descriptor_set_layout_info{};
+		descriptor_set_layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		descriptor_set_layout_info.pNext = &binding_flags_info;
+		descriptor_set_layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		descriptor_set_layout_info.bindingCount = 1u;
+		descriptor_set_layout_info.pBindings = &layout_binding;
+
+		if (vkCreateDescriptorSetLayout(m_device->getDevice(), &descriptor_set_layout_info, nullptr, &m_descriptor_set_layout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create texture heap descriptor set layout!");
+		}
+
+		const VkDescriptorPoolSize pool_size{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_capacity };
+		VkDescriptorPoolCreateInfo descriptor_pool_info{};
+		descriptor_pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		descriptor_pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+		descriptor_pool_info.poolSizeCount = 1u;
+		descriptor_pool_info.pPoolSizes = &pool_size;
+		descriptor_pool_info.maxSets = 1u;
+
+		if (vkCreateDescriptorPool(m_device->getDevice(), &descriptor_pool_info, nullptr, &m_descriptor_pool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create texture heap descriptor pool!");
+		}
+
+		VkDescriptorSetAllocateInfo alloc_info{};
+		alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		alloc_info.descriptorPool = m_descriptor_pool;
+		alloc_info.pSetLayouts = &m_descriptor_set_layout;
+		alloc_info.descriptorSetCount = 1u;
+
+		if (vkAllocateDescriptorSets(m_device->getDevice(), &alloc_info, &m_descriptor_set) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate texture heap descriptor set!");
+		}
+		m_device->trackDescriptorSets(1);
+	}
+
+	TextureHeap::~TextureHeap()
+	{
+		m_device->trackDescriptorSets(-1);
+		vkDestroyDescriptorPool(m_device->getDevice(), m_descriptor_pool, nullptr);
+		vkDestroyDescriptorSetLayout(m_device->getDevice(), m_descriptor_set_layout, nullptr);
+		free(m_free_indices);
+	}
+
+	bool TextureHeap::isSupported(const Device* device)
+	{
+		return device->m_descriptor_indexing && device->m_max_bindless_textures != 0u;
+	}
+
+	unsigned int TextureHeap::registerTexture(const VkDescriptorImageInfo* image_info)
+	{
+		unsigned int index;
+		if (m_free_count != 0u)
+		{
+			index = m_free_indices[--m_free_count];
+		}
+		else
+		{
+			if (m_count == m_capacity)
+			{
+				throw std::runtime_error("Texture heap is full!");
+			}
+			index = m_count++;
+		}
+
+		write(index, image_info);
+		return index;
+	}
+
+	void TextureHeap::updateTexture(const unsigned int index, const VkDescriptorImageInfo* image_info)
+	{
+		assert(index < m_count && "Cannot update a texture that was never registered");
+		write(index, image_info);
+	}
+
+	void TextureHeap::unregisterTexture(const unsigned int index)
+	{
+		assert(index < m_count && "Cannot unregister a texture that was never registered");
+		m_free_indices[m_free_count++] = index;
+	}
+
+	VkDescriptorSetLayout TextureHeap::getSetLayout() const
+	{
+		return m_descriptor_set_layout;
+	}
+
+	const VkDescriptorSet* TextureHeap::getDescriptorSet() const
+	{
+		return &m_descriptor_set;
+	}
+
+	void TextureHeap::write(const unsigned int index, const VkDescriptorImageInfo* image_info)
+	{
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_descriptor_set;
+		write.dstBinding = 0u;
+		write.dstArrayElement = index;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.descriptorCount = 1u;
+		write.pImageInfo = image_info;
+
+		vkUpdateDescriptorSets(m_device->getDevice(), 1u, &write, 0u, nullptr);
+	}
+}
@@ -2,6 +2,8 @@
 #include "Pipeline.h"
 
 // external
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <stdexcept>
 #include <iostream>
@@ -18,16 +20,35 @@ namespace Isonia::Pipeline
 		pickPhysicalDevice();
 		createLogicalDevice();
 		createCommandPool();
+		m_transient_command_pools = new TransientCommandPools(this);
+		m_deletion_queue = new DeletionQueue(this);
+		findHostVisibleDeviceMemory();
+		createPipelineCache();
+		m_pipeline_compiler = new PipelineCompiler(this);
+		m_allocator = new MemoryAllocator(m_device, m_physical_device, m_properties.limits.nonCoherentAtomSize);
+		m_upload_context = new UploadContext(this);
+		m_uniform_ring = new UniformRing(this);
 	}
 
 	Device::~Device()
 	{
+		delete m_uniform_ring;
+		delete m_upload_context;
+		delete m_deletion_queue;
+		delete m_allocator;
+		delete m_pipeline_compiler;
+		savePipelineCache();
+		vkDestroyPipelineCache(m_device, m_pipeline_cache, nullptr);
+		delete m_transient_command_pools;
 		vkDestroyCommandPool(m_device, m_command_pool, nullptr);
 		vkDestroyDevice(m_device, nullptr);
 #ifdef DEBUG
 		destroyDebugUtilsMessengerEXT(m_instance, m_debug_messenger, nullptr);
 #endif
-		vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+		if (m_surface != nullptr)
+		{
+			vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+		}
 		vkDestroyInstance(m_instance, nullptr);
 	}
 
@@ -35,6 +56,37 @@ namespace Isonia::Pipeline
 	{
 		return m_command_pool;
 	}
+	TransientCommandPools* Device::getTransientCommandPools() const
+	{
+		return m_transient_command_pools;
+	}
+	UniformRing* Device::getUniformRing() const
+	{
+		return m_uniform_ring;
+	}
+	DeletionQueue* Device::getDeletionQueue() const
+	{
+		return m_deletion_queue;
+	}
+	VkPipelineCache Device::getPipelineCache() const
+	{
+		return m_pipeline_cache;
+	}
+	PipelineCompiler* Device::getPipelineCompiler() const
+	{
+		return m_pipeline_compiler;
+	}
+	PipelineCacheStats Device::getPipelineCacheStats()
+	{
+		std::lock_guard<std::mutex> lock(m_pipeline_cache_mutex);
+		return m_pipeline_cache_stats;
+	}
+	void Device::addPipelineCreationTime(unsigned long long microseconds)
+	{
+		std::lock_guard<std::mutex> lock(m_pipeline_cache_mutex);
+		m_pipeline_cache_stats.pipeline_count++;
+		m_pipeline_cache_stats.creation_time_us += microseconds;
+	}
 	VkDevice Device::getDevice() const
 	{
 		return m_device;
@@ -51,6 +103,10 @@ namespace Isonia::Pipeline
 	{
 		return m_present_queue;
 	}
+	bool Device::isHeadless() const
+	{
+		return m_window->isHeadless();
+	}
 	SwapChainSupportDetails Device::getSwapChainSupport()
 	{
 		return findSwapChainSupport(m_physical_device);
@@ -59,6 +115,14 @@ namespace Isonia::Pipeline
 	{
 		return findQueueFamilies(m_physical_device);
 	}
+	MemoryAllocator* Device::getAllocator() const
+	{
+		return m_allocator;
+	}
+	UploadContext* Device::getUploadContext() const
+	{
+		return m_upload_context;
+	}
 
 	VkFormat Device::findSupportedFormat(const VkFormat* candidates, const unsigned int candidates_count, VkImageTiling tiling, VkFormatFeatureFlags features) const
 	{
@@ -79,6 +143,23 @@ namespace Isonia::Pipeline
 		throw std::runtime_error("Failed to find supported format!");
 	}
 
+	bool Device::isFormatSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features) const
+	{
+		VkFormatProperties props;
+		vkGetPhysicalDeviceFormatProperties(m_physical_device, format, &props);
+
+		if (tiling == VK_IMAGE_TILING_LINEAR)
+		{
+			return (props.linearTilingFeatures & features) == features;
+		}
+		return (props.optimalTilingFeatures & features) == features;
+	}
+
+	bool Device::hasHostVisibleDeviceMemory() const
+	{
+		return m_host_visible_device_memory;
+	}
+
 	unsigned int Device::findMemoryType(unsigned int type_filter, VkMemoryPropertyFlags properties) const
 	{
 		VkPhysicalDeviceMemoryProperties mem_properties;
@@ -94,7 +175,7 @@ namespace Isonia::Pipeline
 		throw std::runtime_error("Failed to find suitable memory type!");
 	}
 
-	void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, VkDeviceMemory* buffer_memory)
+	void Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, MemoryAllocation* buffer_allocation, unsigned int category)
 	{
 		VkBufferCreateInfo buffer_info{};
 		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -110,36 +191,103 @@ namespace Isonia::Pipeline
 		VkMemoryRequirements mem_requirements;
 		vkGetBufferMemoryRequirements(m_device, *buffer, &mem_requirements);
 
-		VkMemoryAllocateInfo alloc_info{};
-		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		alloc_info.allocationSize = mem_requirements.size;
-		alloc_info.memoryTypeIndex = findMemoryType(mem_requirements.memoryTypeBits, properties);
+		m_allocator->allocate(&mem_requirements, findMemoryType(mem_requirements.memoryTypeBits, properties), false, buffer_allocation);
 
-		if (vkAllocateMemory(m_device, &alloc_info, nullptr, buffer_memory) != VK_SUCCESS)
+		if (vkBindBufferMemory(m_device, *buffer, buffer_allocation->memory, buffer_allocation->offset) != VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed to allocate vertex buffer memory!");
+			throw std::runtime_error("Failed to bind buffer memory!");
 		}
 
-		vkBindBufferMemory(m_device, *buffer, *buffer_memory, 0);
+		buffer_allocation->category = category;
+		trackAllocation(&m_resource_stats.buffers, buffer_allocation, 1);
 	}
 
-	VkCommandBuffer Device::beginSingleTimeCommands()
+	void Device::destroyBuffer(VkBuffer buffer, MemoryAllocation* buffer_allocation)
+	{
+		trackAllocation(&m_resource_stats.buffers, buffer_allocation, -1);
+		vkDestroyBuffer(m_device, buffer, nullptr);
+		m_allocator->deallocate(buffer_allocation);
+	}
+
+	static void addToCounter(ResourceCounter* counter, int count, long long bytes)
+	{
+		counter->count += count;
+		counter->bytes += bytes;
+		if (counter->count > counter->peak_count)
+		{
+			counter->peak_count = counter->count;
+		}
+		if (counter->bytes > counter->peak_bytes)
+		{
+			counter->peak_bytes = counter->bytes;
+		}
+	}
+
+	void Device::trackAllocation(ResourceCounter* counter, const MemoryAllocation* allocation, int count)
+	{
+		const long long bytes = static_cast<long long>(allocation->size) * count;
+
+		std::lock_guard<std::mutex> lock(m_resource_mutex);
+		addToCounter(counter, count, bytes);
+		addToCounter(&m_resource_stats.categories[allocation->category], count, bytes);
+	}
+
+	void Device::trackDescriptorSets(int count)
 	{
-		VkCommandBufferAllocateInfo alloc_info{};
-		alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		alloc_info.commandPool = m_command_pool;
-		alloc_info.commandBufferCount = 1;
+		std::lock_guard<std::mutex> lock(m_resource_mutex);
+		addToCounter(&m_resource_stats.descriptor_sets, count, 0);
+	}
+
+	void Device::trackPipelines(int count)
+	{
+		std::lock_guard<std::mutex> lock(m_resource_mutex);
+		addToCounter(&m_resource_stats.pipelines, count, 0);
+	}
 
-		VkCommandBuffer command_buffer;
-		vkAllocateCommandBuffers(m_device, &alloc_info, &command_buffer);
+	void Device::trackTransfer(VkDeviceSize buffer_bytes, VkDeviceSize image_bytes)
+	{
+		std::lock_guard<std::mutex> lock(m_resource_mutex);
+		m_transfer_stats.buffer_bytes_uploaded += buffer_bytes;
+		m_transfer_stats.image_bytes_copied += image_bytes;
+	}
 
-		VkCommandBufferBeginInfo begin_info{};
-		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	TransferStats Device::getTransferStats()
+	{
+		std::lock_guard<std::mutex> lock(m_resource_mutex);
+		return m_frame_transfer_stats;
+	}
 
-		vkBeginCommandBuffer(command_buffer, &begin_info);
-		return command_buffer;
+	ResourceStats Device::getResourceStats()
+	{
+		ResourceStats stats;
+		{
+			std::lock_guard<std::mutex> lock(m_resource_mutex);
+			stats = m_resource_stats;
+		}
+		stats.memory = m_allocator->getStats();
+		return stats;
+	}
+
+	void Device::beginFrame(unsigned int frame, VkFence frame_fence)
+	{
+		// waits for the slot's previous frame, everything keyed by the slot is free to reuse after
+		m_transient_command_pools->beginFrame(frame, frame_fence);
+		m_uniform_ring->beginFrame(frame);
+		m_deletion_queue->retire();
+	}
+
+	void Device::endFrame()
+	{
+		m_deletion_queue->endFrame();
+
+		std::lock_guard<std::mutex> lock(m_resource_mutex);
+		m_frame_transfer_stats = m_transfer_stats;
+		m_transfer_stats = {};
+	}
+
+	VkCommandBuffer Device::beginSingleTimeCommands()
+	{
+		return m_transient_command_pools->beginPrimary();
 	}
 
 	void Device::endSingleTimeCommands(VkCommandBuffer command_buffer)
@@ -153,30 +301,20 @@ namespace Isonia::Pipeline
 
 		vkQueueSubmit(m_graphics_queue, 1, &submit_info, nullptr);
 		vkQueueWaitIdle(m_graphics_queue);
-
-		vkFreeCommandBuffers(m_device, m_command_pool, 1, &command_buffer);
 	}
 
-	void Device::copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size)
+	void Device::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, unsigned int mip_levels, unsigned int layer_count)
 	{
 		VkCommandBuffer command_buffer = beginSingleTimeCommands();
-
-		VkBufferCopy copy_region{};
-		copy_region.srcOffset = 0; // Optional
-		copy_region.dstOffset = 0; // Optional
-		copy_region.size = size;
-		vkCmdCopyBuffer(command_buffer, src_buffer, dst_buffer, 1, &copy_region);
-
+		recordTransitionImageLayout(command_buffer, image, format, old_layout, new_layout, mip_levels, layer_count);
 		endSingleTimeCommands(command_buffer);
 	}
 
-	void Device::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, unsigned int mip_levels, unsigned int layer_count)
+	void Device::recordTransitionImageLayout(VkCommandBuffer command_buffer, VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, unsigned int mip_levels, unsigned int layer_count)
 	{
 		// uses an image memory barrier transition image layouts and transfer queue
 		// family ownership when VK_SHARING_MODE_EXCLUSIVE is used. There is an
 		// equivalent buffer memory barrier to do this for buffers
-		VkCommandBuffer command_buffer = beginSingleTimeCommands();
-
 		VkImageMemoryBarrier barrier{};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 		barrier.oldLayout = old_layout;
@@ -280,41 +418,9 @@ namespace Isonia::Pipeline
 			1,
 			&barrier
 		);
-
-		endSingleTimeCommands(command_buffer);
 	}
 
-
-	void Device::copyBufferToImage(VkBuffer buffer, VkImage image, unsigned int width, unsigned int height, unsigned int layer_count)
-	{
-		VkCommandBuffer command_buffer = beginSingleTimeCommands();
-
-		VkBufferImageCopy region{};
-		region.bufferOffset = 0;
-		region.bufferRowLength = 0;
-		region.bufferImageHeight = 0;
-
-		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		region.imageSubresource.mipLevel = 0;
-		region.imageSubresource.baseArrayLayer = 0;
-		region.imageSubresource.layerCount = layer_count;
-
-		region.imageOffset = { 0, 0, 0 };
-		region.imageExtent = { width, height, 1 };
-
-		vkCmdCopyBufferToImage(
-			command_buffer,
-			buffer,
-			image,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1,
-			&region
-		);
-
-		endSingleTimeCommands(command_buffer);
-	}
-
-	void Device::createImageWithInfo(const VkImageCreateInfo* image_info, VkMemoryPropertyFlags properties, VkImage* image, VkDeviceMemory* image_memory)
+	void Device::createImageWithInfo(const VkImageCreateInfo* image_info, VkMemoryPropertyFlags properties, VkImage* image, MemoryAllocation* image_allocation, unsigned int category)
 	{
 		if (vkCreateImage(m_device, image_info, nullptr, image) != VK_SUCCESS)
 		{
@@ -324,20 +430,24 @@ namespace Isonia::Pipeline
 		VkMemoryRequirements mem_requirements;
 		vkGetImageMemoryRequirements(m_device, *image, &mem_requirements);
 
-		VkMemoryAllocateInfo alloc_info{};
-		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		alloc_info.allocationSize = mem_requirements.size;
-		alloc_info.memoryTypeIndex = findMemoryType(mem_requirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(m_device, &alloc_info, nullptr, image_memory) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to allocate image memory!");
-		}
+		// linear images follow the same granularity rules as buffers
+		const bool is_optimal = image_info->tiling == VK_IMAGE_TILING_OPTIMAL;
+		m_allocator->allocate(&mem_requirements, findMemoryType(mem_requirements.memoryTypeBits, properties), is_optimal, image_allocation);
 
-		if (vkBindImageMemory(m_device, *image, *image_memory, 0) != VK_SUCCESS)
+		if (vkBindImageMemory(m_device, *image, image_allocation->memory, image_allocation->offset) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to bind image memory!");
 		}
+
+		image_allocation->category = category;
+		trackAllocation(&m_resource_stats.images, image_allocation, 1);
+	}
+
+	void Device::destroyImage(VkImage image, MemoryAllocation* image_allocation)
+	{
+		trackAllocation(&m_resource_stats.images, image_allocation, -1);
+		vkDestroyImage(m_device, image, nullptr);
+		m_allocator->deallocate(image_allocation);
 	}
 
 #ifdef DEBUG
@@ -420,6 +530,17 @@ namespace Isonia::Pipeline
 
 	const char** Device::getRequiredExtensions(unsigned int* count)
 	{
+		if (isHeadless())
+		{
+#ifdef DEBUG
+			*count = 1;
+			return new const char*[] { VK_EXT_DEBUG_UTILS_EXTENSION_NAME };
+#else
+			*count = 0;
+			return nullptr;
+#endif
+		}
+
 #ifdef DEBUG
 		*count = 3;
 #else
@@ -500,6 +621,27 @@ namespace Isonia::Pipeline
 		return supported;
 	}
 
+	bool Device::isDeviceExtensionSupported(VkPhysicalDevice device, const char* extension) const
+	{
+		unsigned int extension_count;
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
+		VkExtensionProperties* available_extensions = (VkExtensionProperties*)malloc(extension_count * sizeof(VkExtensionProperties));
+		vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions);
+
+		bool found = false;
+		for (unsigned int av_i = 0; av_i < extension_count; av_i++)
+		{
+			if (strcmp(extension, available_extensions[av_i].extensionName) == 0)
+			{
+				found = true;
+				break;
+			}
+		}
+
+		free(available_extensions);
+		return found;
+	}
+
 	QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) const
 	{
 		QueueFamilyIndices indices;
@@ -516,8 +658,12 @@ namespace Isonia::Pipeline
 				indices.graphics_family = i;
 				indices.graphics_family_has_value = true;
 			}
-			VkBool32 present_support = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface, &present_support);
+			// nothing is presented without a surface, the graphics queue stands in
+			VkBool32 present_support = m_surface == nullptr && indices.graphics_family_has_value ? VK_TRUE : VK_FALSE;
+			if (m_surface != nullptr)
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface, &present_support);
+			}
 			if (queue_families[i].queueCount > 0 && present_support)
 			{
 				indices.present_family = i;
@@ -574,7 +720,7 @@ namespace Isonia::Pipeline
 		app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		app_info.pEngineName = "Isonia";
 		app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		app_info.apiVersion = VK_API_VERSION_1_0;
+		app_info.apiVersion = VK_API_VERSION_1_1;
 
 		VkInstanceCreateInfo create_info = {};
 		create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -677,18 +823,36 @@ namespace Isonia::Pipeline
 			};
 		}
 
+		VkPhysicalDeviceFeatures supported_features;
+		vkGetPhysicalDeviceFeatures(m_physical_device, &supported_features);
+
 		VkPhysicalDeviceFeatures device_features = {};
 		device_features.geometryShader = VK_TRUE;
+		// optional, block compressed textures fall back to uncompressed when missing
+		device_features.textureCompressionBC = supported_features.textureCompressionBC;
+
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features{};
+		indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		findDescriptorIndexingSupport(&indexing_features);
+
+		unsigned int device_extensions_count = isHeadless() ? 0u : m_device_extensions_count;
+		const char* device_extensions[m_device_extensions_count + 1u];
+		memcpy(device_extensions, m_device_extensions, device_extensions_count * sizeof(const char*));
+		if (m_descriptor_indexing)
+		{
+			device_extensions[device_extensions_count++] = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+		}
 
 		VkDeviceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = m_descriptor_indexing ? &indexing_features : nullptr;
 
 		createInfo.queueCreateInfoCount = queue_create_infos_count;
 		createInfo.pQueueCreateInfos = queue_create_infos;
 
 		createInfo.pEnabledFeatures = &device_features;
-		createInfo.enabledExtensionCount = m_device_extensions_count;
-		createInfo.ppEnabledExtensionNames = m_device_extensions;
+		createInfo.enabledExtensionCount = device_extensions_count;
+		createInfo.ppEnabledExtensionNames = device_extensions;
 
 #ifdef DEBUG
 		// might not really be necessary anymore because device specific validation layers have been deprecated
@@ -702,11 +866,57 @@ namespace Isonia::Pipeline
 		{
 			throw std::runtime_error("Failed to create logical device!");
 		}
+		m_enabled_features = device_features;
 
 		vkGetDeviceQueue(m_device, indices.graphics_family, 0, &m_graphics_queue);
 		vkGetDeviceQueue(m_device, indices.present_family, 0, &m_present_queue);
 	}
 
+	void Device::findDescriptorIndexingSupport(VkPhysicalDeviceDescriptorIndexingFeaturesEXT* indexing_features)
+	{
+		// the features2 queries are core from 1.1, maintenance3 which the extension depends on as well
+		if (m_properties.apiVersion < VK_API_VERSION_1_1 || !isDeviceExtensionSupported(m_physical_device, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME))
+		{
+			return;
+		}
+
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported_indexing_features{};
+		supported_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		VkPhysicalDeviceFeatures2 supported_features{};
+		supported_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supported_features.pNext = &supported_indexing_features;
+		vkGetPhysicalDeviceFeatures2(m_physical_device, &supported_features);
+
+		// indices come from push constants, dynamically uniform, so non uniform indexing is not needed
+		if (!supported_indexing_features.runtimeDescriptorArray ||
+			!supported_indexing_features.descriptorBindingPartiallyBound ||
+			!supported_indexing_features.descriptorBindingSampledImageUpdateAfterBind ||
+			!supported_indexing_features.descriptorBindingUpdateUnusedWhilePending)
+		{
+			return;
+		}
+
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexing_properties{};
+		indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &indexing_properties;
+		vkGetPhysicalDeviceProperties2(m_physical_device, &properties);
+
+		// a combined image sampler counts against both the sampler and the sampled image limits
+		m_max_bindless_textures = Math::clampui(indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers, 0u, indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+		m_max_bindless_textures = Math::clampui(m_max_bindless_textures, 0u, indexing_properties.maxDescriptorSetUpdateAfterBindSamplers);
+		m_max_bindless_textures = Math::clampui(m_max_bindless_textures, 0u, indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages);
+
+		indexing_features->runtimeDescriptorArray = VK_TRUE;
+		indexing_features->descriptorBindingPartiallyBound = VK_TRUE;
+		indexing_features->descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		indexing_features->descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		m_descriptor_indexing = true;
+
+		std::cout << "Descriptor indexing: " << m_max_bindless_textures << " bindless textures\n";
+	}
+
 	void Device::createCommandPool()
 	{
 		QueueFamilyIndices queue_family_indices = getPhysicalQueueFamilies();
@@ -722,8 +932,133 @@ namespace Isonia::Pipeline
 		}
 	}
 
+	void Device::findHostVisibleDeviceMemory()
+	{
+		VkPhysicalDeviceMemoryProperties mem_properties;
+		vkGetPhysicalDeviceMemoryProperties(m_physical_device, &mem_properties);
+
+		VkDeviceSize device_local_size = 0;
+		for (unsigned int i = 0u; i < mem_properties.memoryHeapCount; i++)
+		{
+			if ((mem_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && mem_properties.memoryHeaps[i].size > device_local_size)
+			{
+				device_local_size = mem_properties.memoryHeaps[i].size;
+			}
+		}
+
+		// only unified memory or a resizable bar, a small bar window would run out
+		const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		for (unsigned int i = 0u; i < mem_properties.memoryTypeCount; i++)
+		{
+			if ((mem_properties.memoryTypes[i].propertyFlags & properties) == properties && mem_properties.memoryHeaps[mem_properties.memoryTypes[i].heapIndex].size >= device_local_size)
+			{
+				m_host_visible_device_memory = true;
+				break;
+			}
+		}
+
+		std::cout << "Host visible device memory: " << (m_host_visible_device_memory ? "yes" : "no") << '\n';
+	}
+
+	struct PipelineCacheFileHeader
+	{
+		unsigned int magic;
+		unsigned int driver_version;
+		unsigned int vendor_id;
+		unsigned int device_id;
+		unsigned char cache_uuid[VK_UUID_SIZE];
+		unsigned long long data_size;
+	};
+
+	static constexpr unsigned int pipeline_cache_magic = 0x43505349u; // "ISPC"
+
+	void Device::createPipelineCache()
+	{
+		void* data = nullptr;
+		size_t data_size = 0;
+
+		FILE* file = fopen(m_pipeline_cache_path, "rb");
+		if (file != nullptr)
+		{
+			// a driver update or another gpu invalidates the blob, the driver is not trusted to reject it
+			PipelineCacheFileHeader header;
+			VkPipelineCacheHeaderVersionOne cache_header;
+			if (fread(&header, sizeof(header), 1, file) == 1
+				&& header.magic == pipeline_cache_magic
+				&& header.driver_version == m_properties.driverVersion
+				&& header.vendor_id == m_properties.vendorID
+				&& header.device_id == m_properties.deviceID
+				&& memcmp(header.cache_uuid, m_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0
+				&& header.data_size >= sizeof(cache_header))
+			{
+				data = malloc(header.data_size);
+				if (fread(data, header.data_size, 1, file) == 1)
+				{
+					memcpy(&cache_header, data, sizeof(cache_header));
+					if (cache_header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+						&& cache_header.vendorID == m_properties.vendorID
+						&& cache_header.deviceID == m_properties.deviceID
+						&& memcmp(cache_header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0)
+					{
+						data_size = static_cast<size_t>(header.data_size);
+					}
+				}
+			}
+			fclose(file);
+		}
+
+		VkPipelineCacheCreateInfo cache_info{};
+		cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cache_info.initialDataSize = data_size;
+		cache_info.pInitialData = data_size == 0 ? nullptr : data;
+
+		if (vkCreatePipelineCache(m_device, &cache_info, nullptr, &m_pipeline_cache) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create pipeline cache!");
+		}
+		free(data);
+
+		m_pipeline_cache_stats.loaded_bytes = data_size;
+		std::cout << "Pipeline cache: " << (data_size == 0 ? "empty" : "loaded") << ", " << data_size << " bytes" << '\n';
+	}
+
+	void Device::savePipelineCache()
+	{
+		size_t data_size = 0;
+		if (vkGetPipelineCacheData(m_device, m_pipeline_cache, &data_size, nullptr) != VK_SUCCESS || data_size == 0)
+		{
+			return;
+		}
+
+		void* data = malloc(data_size);
+		if (vkGetPipelineCacheData(m_device, m_pipeline_cache, &data_size, data) == VK_SUCCESS)
+		{
+			PipelineCacheFileHeader header{};
+			header.magic = pipeline_cache_magic;
+			header.driver_version = m_properties.driverVersion;
+			header.vendor_id = m_properties.vendorID;
+			header.device_id = m_properties.deviceID;
+			memcpy(header.cache_uuid, m_properties.pipelineCacheUUID, VK_UUID_SIZE);
+			header.data_size = data_size;
+
+			// a failed save only costs the next start its warm cache
+			FILE* file = fopen(m_pipeline_cache_path, "wb");
+			if (file != nullptr)
+			{
+				fwrite(&header, sizeof(header), 1, file);
+				fwrite(data, data_size, 1, file);
+				fclose(file);
+			}
+		}
+		free(data);
+	}
+
 	void Device::createSurface()
 	{
+		if (isHeadless())
+		{
+			return;
+		}
 		m_window->createWindowSurface(m_instance, &m_surface);
 	}
 
@@ -731,10 +1066,11 @@ namespace Isonia::Pipeline
 	{
 		QueueFamilyIndices indices = findQueueFamilies(device);
 
-		bool extensions_supported = checkDeviceExtensionSupport(device);
+		// software drivers without presentation support are fine offscreen
+		bool extensions_supported = isHeadless() || checkDeviceExtensionSupport(device);
 
-		bool swap_chain_adequate = false;
-		if (extensions_supported)
+		bool swap_chain_adequate = isHeadless();
+		if (!swap_chain_adequate && extensions_supported)
 		{
 			SwapChainSupportDetails swap_chain_support = findSwapChainSupport(device);
 			swap_chain_adequate = swap_chain_support.formats_count != 0u && swap_chain_support.present_modes_count != 0u;
@@ -0,0 +1,148 @@
+// internal
+#include "Pipeline.h"
+
+// external
+#include <stdexcept>
+
+namespace Isonia::Pipeline
+{
+	GpuTimer::GpuTimer(Device* device) : m_device{ device }
+	{
+		// optional, every scope stays zero without it
+		if (!m_device->m_properties.limits.timestampComputeAndGraphics)
+		{
+			return;
+		}
+
+		VkQueryPoolCreateInfo pool_info{};
+		pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		pool_info.queryCount = max_frames_in_flight * max_queries * 2u;
+
+		if (vkCreateQueryPool(m_device->getDevice(), &pool_info, nullptr, &m_query_pool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create timestamp query pool!");
+		}
+		m_period_ms = m_device->m_properties.limits.timestampPeriod / 1'000'000.0f;
+	}
+
+	GpuTimer::~GpuTimer()
+	{
+		if (m_query_pool != nullptr)
+		{
+			vkDestroyQueryPool(m_device->getDevice(), m_query_pool, nullptr);
+		}
+	}
+
+	void GpuTimer::beginFrame(VkCommandBuffer command_buffer, unsigned int frame)
+	{
+		if (m_query_pool == nullptr)
+		{
+			return;
+		}
+
+		// the slot's command buffer is only reused once its last submission finished, so its results are frames behind but in
+		readResults(frame);
+
+		m_frame = frame;
+		m_query_frames[frame] = m_frames_begun++;
+		m_query_count.store(0u, std::memory_order_relaxed);
+		vkCmdResetQueryPool(command_buffer, m_query_pool, frame * max_queries * 2u, max_queries * 2u);
+	}
+
+	unsigned int GpuTimer::begin(VkCommandBuffer command_buffer, unsigned int scope)
+	{
+		if (m_query_pool == nullptr)
+		{
+			return invalid_query;
+		}
+
+		const unsigned int query = m_query_count.fetch_add(1u, std::memory_order_relaxed);
+		if (query >= max_queries)
+		{
+			return invalid_query;
+		}
+
+		m_query_scopes[m_frame][query] = scope;
+		vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_query_pool, (m_frame * max_queries + query) * 2u);
+		return query;
+	}
+
+	void GpuTimer::end(VkCommandBuffer command_buffer, unsigned int query)
+	{
+		if (query == invalid_query)
+		{
+			return;
+		}
+
+		vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_query_pool, (m_frame * max_queries + query) * 2u + 1u);
+	}
+
+	void GpuTimer::endFrame()
+	{
+		if (m_query_pool == nullptr)
+		{
+			return;
+		}
+
+		// queries past the pool were never written, they are left out of the read back
+		m_query_counts[m_frame] = Math::clampui(m_query_count.load(std::memory_order_relaxed), 0u, max_queries);
+	}
+
+	const GpuTimingStats* GpuTimer::getStats() const
+	{
+		return &m_stats;
+	}
+
+	unsigned int GpuTimer::getStatsFrame() const
+	{
+		return m_stats_frame;
+	}
+
+	void GpuTimer::readResults(unsigned int frame)
+	{
+		const unsigned int query_count = m_query_counts[frame];
+		if (query_count == 0u)
+		{
+			return;
+		}
+
+		unsigned long long timestamps[max_queries * 2u];
+		if (vkGetQueryPoolResults(m_device->getDevice(), m_query_pool, frame * max_queries * 2u, query_count * 2u, query_count * 2u * sizeof(unsigned long long), timestamps, sizeof(unsigned long long), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+		{
+			// not ready, the previous results are kept rather than waited on
+			return;
+		}
+
+		// jobs of one scope overlap on the gpu, summing their spans would count the overlap once per job
+		unsigned long long scope_begins[RenderScopes::count];
+		unsigned long long scope_ends[RenderScopes::count]{};
+		for (unsigned int i = 0u; i < RenderScopes::count; i++)
+		{
+			scope_begins[i] = ~0ull;
+		}
+		for (unsigned int i = 0u; i < query_count; i++)
+		{
+			const unsigned int scope = m_query_scopes[frame][i];
+			if (timestamps[i * 2u] < scope_begins[scope])
+			{
+				scope_begins[scope] = timestamps[i * 2u];
+			}
+			if (timestamps[i * 2u + 1u] > scope_ends[scope])
+			{
+				scope_ends[scope] = timestamps[i * 2u + 1u];
+			}
+		}
+
+		GpuTimingStats stats{};
+		for (unsigned int i = 0u; i < RenderScopes::count; i++)
+		{
+			if (scope_ends[i] > scope_begins[i])
+			{
+				stats.milliseconds[i] = static_cast<float>(scope_ends[i] - scope_begins[i]) * m_period_ms;
+			}
+		}
+		m_stats = stats;
+		m_stats_frame = m_query_frames[frame];
+	}
+}
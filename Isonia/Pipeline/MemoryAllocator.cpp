@@ -0,0 +1,384 @@
+// internal
+#include "Pipeline.h"
+
+// external
+#include <cstdlib>
+#include <stdexcept>
+#include <iostream>
+
+namespace Isonia::Pipeline
+{
+	struct FreeRange
+	{
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		FreeRange* next;
+	};
+
+	struct MemoryBlock
+	{
+		VkDeviceMemory memory;
+		VkDeviceSize size;
+		VkDeviceSize used;
+		void* mapped;
+		unsigned int memory_type;
+		bool is_dedicated;
+		bool is_image;
+		// sorted by offset so neighbours can be merged on free
+		FreeRange* free_ranges;
+		MemoryBlock* next;
+	};
+
+	static constexpr VkDeviceSize alignUp(const VkDeviceSize value, const VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	static constexpr VkDeviceSize alignDown(const VkDeviceSize value, const VkDeviceSize alignment)
+	{
+		return value / alignment * alignment;
+	}
+
+	static bool allocateFromBlock(MemoryBlock* block, const VkDeviceSize size, const VkDeviceSize alignment, MemoryAllocation* allocation)
+	{
+		// first fit
+		for (FreeRange** link = &block->free_ranges; *link != nullptr; link = &(*link)->next)
+		{
+			FreeRange* range = *link;
+			const VkDeviceSize offset = alignUp(range->offset, alignment);
+			const VkDeviceSize padding = offset - range->offset;
+			if (padding + size > range->size)
+			{
+				continue;
+			}
+
+			const VkDeviceSize tail_offset = offset + size;
+			const VkDeviceSize tail_size = range->offset + range->size - tail_offset;
+			if (padding > 0)
+			{
+				// keep the alignment padding free and split off the tail
+				range->size = padding;
+				if (tail_size > 0)
+				{
+					FreeRange* tail = (FreeRange*)malloc(sizeof(FreeRange));
+					tail->offset = tail_offset;
+					tail->size = tail_size;
+					tail->next = range->next;
+					range->next = tail;
+				}
+			}
+			else if (tail_size > 0)
+			{
+				range->offset = tail_offset;
+				range->size = tail_size;
+			}
+			else
+			{
+				*link = range->next;
+				free(range);
+			}
+
+			block->used += size;
+			allocation->memory = block->memory;
+			allocation->offset = offset;
+			allocation->size = size;
+			allocation->mapped = block->mapped == nullptr ? nullptr : static_cast<unsigned char*>(block->mapped) + offset;
+			allocation->block = block;
+			return true;
+		}
+		return false;
+	}
+
+	static void freeToBlock(MemoryBlock* block, const VkDeviceSize offset, const VkDeviceSize size)
+	{
+		FreeRange* previous = nullptr;
+		FreeRange* next = block->free_ranges;
+		while (next != nullptr && next->offset < offset)
+		{
+			previous = next;
+			next = next->next;
+		}
+
+		const bool merge_previous = previous != nullptr && previous->offset + previous->size == offset;
+		const bool merge_next = next != nullptr && offset + size == next->offset;
+		if (merge_previous && merge_next)
+		{
+			previous->size += size + next->size;
+			previous->next = next->next;
+			free(next);
+		}
+		else if (merge_previous)
+		{
+			previous->size += size;
+		}
+		else if (merge_next)
+		{
+			next->offset = offset;
+			next->size += size;
+		}
+		else
+		{
+			FreeRange* range = (FreeRange*)malloc(sizeof(FreeRange));
+			range->offset = offset;
+			range->size = size;
+			range->next = next;
+			if (previous == nullptr)
+			{
+				block->free_ranges = range;
+			}
+			else
+			{
+				previous->next = range;
+			}
+		}
+		block->used -= size;
+	}
+
+	MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize non_coherent_atom_size, VkDeviceSize block_size)
+		: m_device{ device }, m_non_coherent_atom_size{ non_coherent_atom_size }, m_block_size{ block_size }
+	{
+		vkGetPhysicalDeviceMemoryProperties(physical_device, &m_memory_properties);
+	}
+
+	MemoryAllocator::~MemoryAllocator()
+	{
+		if (m_stats.allocation_count != 0u)
+		{
+			std::cout << "Device memory leaked: " << m_stats.allocation_count << " allocations" << '\n';
+		}
+
+		for (unsigned int type = 0u; type < VK_MAX_MEMORY_TYPES; type++)
+		{
+			for (unsigned int kind = 0u; kind < 2u; kind++)
+			{
+				MemoryBlock* block = m_pools[type][kind];
+				while (block != nullptr)
+				{
+					MemoryBlock* next = block->next;
+					destroyBlock(block);
+					block = next;
+				}
+			}
+		}
+	}
+
+	void MemoryAllocator::allocate(const VkMemoryRequirements* requirements, unsigned int memory_type, bool is_image, MemoryAllocation* allocation)
+	{
+		VkDeviceSize size = requirements->size;
+		VkDeviceSize alignment = requirements->alignment;
+		if ((m_memory_properties.memoryTypes[memory_type].propertyFlags & (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) == VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			// atom aligned allocations keep flush and invalidate ranges inside the allocation
+			size = alignUp(size, m_non_coherent_atom_size);
+			alignment = alignUp(alignment, m_non_coherent_atom_size);
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// large resources such as render targets get their own memory object
+		if (size > m_block_size / 2)
+		{
+			MemoryBlock* block = createBlock(memory_type, size, true);
+			block->is_image = is_image;
+			allocateFromBlock(block, size, alignment, allocation);
+			m_stats.allocation_count++;
+			m_stats.used_bytes += size;
+			return;
+		}
+
+		MemoryBlock** pool = &m_pools[memory_type][is_image ? 1u : 0u];
+		for (MemoryBlock* block = *pool; block != nullptr; block = block->next)
+		{
+			if (allocateFromBlock(block, size, alignment, allocation))
+			{
+				m_stats.allocation_count++;
+				m_stats.used_bytes += size;
+				return;
+			}
+		}
+
+		MemoryBlock* block = createBlock(memory_type, m_block_size, false);
+		block->is_image = is_image;
+		block->next = *pool;
+		*pool = block;
+		allocateFromBlock(block, size, alignment, allocation);
+		m_stats.allocation_count++;
+		m_stats.used_bytes += size;
+	}
+
+	void MemoryAllocator::deallocate(MemoryAllocation* allocation)
+	{
+		if (allocation->block == nullptr)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		MemoryBlock* block = allocation->block;
+		freeToBlock(block, allocation->offset, allocation->size);
+		m_stats.allocation_count--;
+		m_stats.used_bytes -= allocation->size;
+		*allocation = MemoryAllocation{};
+
+		if (block->used != 0)
+		{
+			return;
+		}
+		if (block->is_dedicated)
+		{
+			destroyBlock(block);
+			return;
+		}
+
+		// keep one empty block per pool around so a free and allocate pair does not hit the driver
+		MemoryBlock** pool = &m_pools[block->memory_type][block->is_image ? 1u : 0u];
+		bool has_other_empty = false;
+		for (MemoryBlock* other = *pool; other != nullptr; other = other->next)
+		{
+			if (other != block && other->used == 0)
+			{
+				has_other_empty = true;
+				break;
+			}
+		}
+		if (!has_other_empty)
+		{
+			return;
+		}
+
+		for (MemoryBlock** link = pool; *link != nullptr; link = &(*link)->next)
+		{
+			if (*link == block)
+			{
+				*link = block->next;
+				break;
+			}
+		}
+		destroyBlock(block);
+	}
+
+	VkMappedMemoryRange MemoryAllocator::getAtomRange(const MemoryAllocation* allocation, VkDeviceSize size, VkDeviceSize offset) const
+	{
+		if (size == VK_WHOLE_SIZE)
+		{
+			size = allocation->size - offset;
+		}
+		const VkDeviceSize begin = alignDown(allocation->offset + offset, m_non_coherent_atom_size);
+		const VkDeviceSize end = alignUp(allocation->offset + offset + size, m_non_coherent_atom_size);
+
+		VkMappedMemoryRange mapped_range = {};
+		mapped_range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		mapped_range.memory = allocation->memory;
+		mapped_range.offset = begin;
+		// dedicated blocks are not atom sized, whole size covers their tail
+		mapped_range.size = end > allocation->block->size ? VK_WHOLE_SIZE : end - begin;
+		return mapped_range;
+	}
+
+	VkResult MemoryAllocator::flush(const MemoryAllocation* allocation, VkDeviceSize size, VkDeviceSize offset) const
+	{
+		// coherent writes are visible at submit without a driver call
+		if (isHostCoherent(allocation))
+		{
+			return VK_SUCCESS;
+		}
+		VkMappedMemoryRange mapped_range = getAtomRange(allocation, size, offset);
+		return vkFlushMappedMemoryRanges(m_device, 1, &mapped_range);
+	}
+
+	VkResult MemoryAllocator::invalidate(const MemoryAllocation* allocation, VkDeviceSize size, VkDeviceSize offset) const
+	{
+		if (isHostCoherent(allocation))
+		{
+			return VK_SUCCESS;
+		}
+		VkMappedMemoryRange mapped_range = getAtomRange(allocation, size, offset);
+		return vkInvalidateMappedMemoryRanges(m_device, 1, &mapped_range);
+	}
+
+	bool MemoryAllocator::isHostCoherent(const MemoryAllocation* allocation) const
+	{
+		return (m_memory_properties.memoryTypes[allocation->block->memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	}
+
+	MemoryAllocatorStats MemoryAllocator::getStats()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+	MemoryBlock* MemoryAllocator::createBlock(unsigned int memory_type, VkDeviceSize size, bool is_dedicated)
+	{
+		VkMemoryAllocateInfo alloc_info{};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = size;
+		alloc_info.memoryTypeIndex = memory_type;
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(m_device, &alloc_info, nullptr, &memory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate device memory!");
+		}
+
+		// host visible blocks stay mapped for their whole lifetime
+		void* mapped = nullptr;
+		if (m_memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			if (vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to map device memory!");
+			}
+		}
+
+		FreeRange* range = (FreeRange*)malloc(sizeof(FreeRange));
+		range->offset = 0;
+		range->size = size;
+		range->next = nullptr;
+
+		MemoryBlock* block = (MemoryBlock*)malloc(sizeof(MemoryBlock));
+		block->memory = memory;
+		block->size = size;
+		block->used = 0;
+		block->mapped = mapped;
+		block->memory_type = memory_type;
+		block->is_dedicated = is_dedicated;
+		block->is_image = false;
+		block->free_ranges = range;
+		block->next = nullptr;
+
+		m_stats.device_memory_count++;
+		m_stats.allocate_calls++;
+		m_stats.reserved_bytes += size;
+		if (m_stats.device_memory_count > m_stats.peak_device_memory_count)
+		{
+			m_stats.peak_device_memory_count = m_stats.device_memory_count;
+		}
+		if (m_stats.reserved_bytes > m_stats.peak_reserved_bytes)
+		{
+			m_stats.peak_reserved_bytes = m_stats.reserved_bytes;
+		}
+		return block;
+	}
+
+	void MemoryAllocator::destroyBlock(MemoryBlock* block)
+	{
+		FreeRange* range = block->free_ranges;
+		while (range != nullptr)
+		{
+			FreeRange* next = range->next;
+			free(range);
+			range = next;
+		}
+
+		if (block->mapped != nullptr)
+		{
+			vkUnmapMemory(m_device, block->memory);
+		}
+		vkFreeMemory(m_device, block->memory, nullptr);
+
+		m_stats.device_memory_count--;
+		m_stats.reserved_bytes -= block->size;
+		free(block);
+	}
+}
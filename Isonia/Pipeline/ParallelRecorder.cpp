@@ -0,0 +1,168 @@
+// internal
+#include "Pipeline.h"
+
+// external
+#include <cassert>
+#include <stdexcept>
+
+namespace Isonia::Pipeline
+{
+	ParallelRecorder::ParallelRecorder(Device* device)
+		: m_device{ device }
+	{
+		// the calling thread records too, so one less worker than hardware threads
+		const unsigned int hardware_threads = std::thread::hardware_concurrency();
+		m_worker_count = Math::clampui(hardware_threads > 1u ? hardware_threads - 1u : 1u, 1u, max_workers);
+		m_workers = new std::thread[m_worker_count];
+		for (unsigned int i = 0u; i < m_worker_count; i++)
+		{
+			m_workers[i] = std::thread(&ParallelRecorder::workerLoop, this);
+		}
+
+		m_inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		m_inheritance_info.subpass = 0u;
+	}
+
+	ParallelRecorder::~ParallelRecorder()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_condition.notify_all();
+		for (unsigned int i = 0u; i < m_worker_count; i++)
+		{
+			m_workers[i].join();
+		}
+		delete[] m_workers;
+	}
+
+	void ParallelRecorder::begin(VkRenderPass render_pass, VkFramebuffer framebuffer, VkExtent2D extent, void* frame_data)
+	{
+		assert(m_jobs_count == 0u && "Parallel recorder jobs were added but never executed");
+
+		m_inheritance_info.renderPass = render_pass;
+		m_inheritance_info.framebuffer = framebuffer;
+		m_extent = extent;
+		m_frame_data = frame_data;
+	}
+
+	void ParallelRecorder::addJob(RecordCallback callback, void* user_data, unsigned int scope, unsigned int first, unsigned int last)
+	{
+		assert(m_jobs_count < max_jobs && "Too many parallel recorder jobs");
+
+		Job* job = &m_jobs[m_jobs_count++];
+		job->callback = callback;
+		job->user_data = user_data;
+		job->scope = scope;
+		job->first = first;
+		job->last = last;
+		job->command_buffer = nullptr;
+	}
+
+	void ParallelRecorder::addJobs(RecordCallback callback, void* user_data, unsigned int scope, unsigned int count)
+	{
+		const unsigned int jobs_count = Math::clampui(count, 0u, m_worker_count + 1u);
+		for (unsigned int i = 0u; i < jobs_count; i++)
+		{
+			addJob(callback, user_data, scope, count * i / jobs_count, count * (i + 1u) / jobs_count);
+		}
+	}
+
+	void ParallelRecorder::execute(CommandRecorder* primary)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		if (m_jobs_count == 0u)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_next_job = 0u;
+			m_finished_jobs = 0u;
+			m_is_recording = true;
+		}
+		m_condition.notify_all();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (m_next_job < m_jobs_count)
+		{
+			Job* job = &m_jobs[m_next_job++];
+			lock.unlock();
+			recordJob(job);
+			lock.lock();
+			m_finished_jobs++;
+		}
+		m_finished_condition.wait(lock, [this] { return m_finished_jobs == m_jobs_count; });
+		m_is_recording = false;
+		lock.unlock();
+
+		VkCommandBuffer command_buffers[max_jobs];
+		for (unsigned int i = 0u; i < m_jobs_count; i++)
+		{
+			command_buffers[i] = m_jobs[i].command_buffer;
+			primary->accumulate(&m_jobs[i].stats, m_jobs[i].scope);
+		}
+		vkCmdExecuteCommands(primary->getCommandBuffer(), m_jobs_count, command_buffers);
+
+		// nothing bound by the secondaries carries over to the primary
+		primary->invalidate();
+		m_jobs_count = 0u;
+	}
+
+	void ParallelRecorder::workerLoop()
+	{
+		ISONIA_PROFILE_THREAD("Recorder");
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true)
+		{
+			m_condition.wait(lock, [this] { return m_stop || (m_is_recording && m_next_job < m_jobs_count); });
+			if (m_stop)
+			{
+				return;
+			}
+
+			Job* job = &m_jobs[m_next_job++];
+			lock.unlock();
+			recordJob(job);
+			lock.lock();
+
+			if (++m_finished_jobs == m_jobs_count)
+			{
+				m_finished_condition.notify_one();
+			}
+		}
+	}
+
+	void ParallelRecorder::recordJob(Job* job)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		// every thread records from its own transient pool
+		VkCommandBuffer command_buffer = m_device->getTransientCommandPools()->beginSecondary(&m_inheritance_info);
+
+		// dynamic state is not inherited from the primary
+		VkViewport viewport{
+			.x = 0.0f,
+			.y = 0.0f,
+			.width = static_cast<float>(m_extent.width),
+			.height = static_cast<float>(m_extent.height),
+			.minDepth = 0.0f,
+			.maxDepth = 1.0f
+		};
+		VkRect2D scissor{ { 0, 0 }, m_extent };
+		vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+		vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+		CommandRecorder recorder;
+		recorder.begin(command_buffer);
+		job->callback(&recorder, job->user_data, m_frame_data, job->first, job->last);
+		job->stats = *recorder.getStats();
+
+		if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record secondary command buffer!");
+		}
+		job->command_buffer = command_buffer;
+	}
+}
@@ -4,61 +4,77 @@
 
 // external
 #include <stdexcept>
+#include <chrono>
 
 namespace Isonia::Pipeline
 {
 	Pipeline::Pipeline(Device* device, const unsigned int shader_stages_count)
 		: m_device(device), m_shader_stages_count(shader_stages_count), m_shader_stages((VkPipelineShaderStageCreateInfo*)malloc(shader_stages_count * sizeof(VkPipelineShaderStageCreateInfo)))
 	{
+		m_shader_codes = (const unsigned char**)malloc(shader_stages_count * sizeof(const unsigned char*));
+		m_shader_sizes = (unsigned int*)malloc(shader_stages_count * sizeof(unsigned int));
 	}
 	Pipeline::~Pipeline()
 	{
-		for (unsigned int i = 0; i < m_shader_stages_count; i++)
+		if (m_config != nullptr)
 		{
-			vkDestroyShaderModule(m_device->getDevice(), m_shader_stages[i].module, nullptr);
+			// a build may still be running on a compiler worker
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] { return m_is_built.load(std::memory_order_acquire); });
 		}
-		vkDestroyPipeline(m_device->getDevice(), m_graphics_pipeline, nullptr);
+
+		for (unsigned int i = 0; i < m_shader_stages_index; i++)
+		{
+			if (m_shader_stages[i].module != nullptr)
+			{
+				vkDestroyShaderModule(m_device->getDevice(), m_shader_stages[i].module, nullptr);
+			}
+		}
+		if (m_graphics_pipeline != nullptr)
+		{
+			m_device->trackPipelines(-1);
+			vkDestroyPipeline(m_device->getDevice(), m_graphics_pipeline, nullptr);
+		}
+		delete m_config;
+		free(m_shader_stages);
+		free(m_shader_codes);
+		free(m_shader_sizes);
 	}
 
 	Pipeline* Pipeline::addShaderModule(VkShaderStageFlagBits stage, const unsigned char* const code, const unsigned int size)
 	{
-		VkShaderModule shader_module = createShaderModule(code, size);
+		assert(m_config == nullptr && "Cannot add shader modules after the pipeline is queued");
+		assert(m_shader_stages_index < m_shader_stages_count && "Too many shader modules for pipeline");
+
+		// modules are created with the pipeline on a compiler worker, shader code is static
+		m_shader_codes[m_shader_stages_index] = code;
+		m_shader_sizes[m_shader_stages_index] = size;
 		m_shader_stages[m_shader_stages_index++] = VkPipelineShaderStageCreateInfo{
 			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
 			nullptr,
 			0,
 			stage,
-			shader_module,
+			nullptr,
 			"main",
 			nullptr
 		};
+		m_stage_flags |= stage;
 
 		return this;
 	}
 
-	VkShaderModule Pipeline::createShaderModule(const unsigned char* const code, const unsigned int size)
-	{
-		VkShaderModuleCreateInfo create_info{};
-		create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		create_info.codeSize = size;
-		create_info.pCode = reinterpret_cast<const unsigned int*>(code);
-
-		VkShaderModule shader_module{};
-		if (vkCreateShaderModule(m_device->getDevice(), &create_info, nullptr, &shader_module) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to create shader module");
-		}
-		return shader_module;
-	}
-
 	VkShaderStageFlags Pipeline::getStageFlags() const
 	{
 		return m_stage_flags;
 	}
 
-	void Pipeline::bind(VkCommandBuffer command_buffer)
+	void Pipeline::bind(CommandRecorder* recorder)
 	{
-		vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphics_pipeline);
+		if (!m_is_built.load(std::memory_order_acquire))
+		{
+			wait();
+		}
+		recorder->bindPipeline(m_graphics_pipeline);
 	}
 
 	void Pipeline::defaultPipelineConfigInfo(PipelineConfigInfo* config_info)
@@ -156,6 +172,11 @@ namespace Isonia::Pipeline
 		config_info->color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
 	}
 
+	void Pipeline::makeReadOnlyDepthConfigInfo(PipelineConfigInfo* config_info)
+	{
+		config_info->depth_stencil_info.depthWriteEnable = VK_FALSE;
+	}
+
 	void Pipeline::makeTriangleStripConfigInfo(PipelineConfigInfo* config_info)
 	{
 		config_info->input_assembly_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
@@ -196,44 +217,99 @@ namespace Isonia::Pipeline
 	{
 		assert(config_info->pipeline_layout != nullptr && "Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
 		assert(config_info->render_pass != nullptr && "Cannot create graphics pipeline: no renderPass provided in configInfo");
+		assert(m_config == nullptr && "Graphics pipeline already created");
+
+		// callers keep their config on the stack, the worker builds from a copy
+		m_config = new PipelineConfigInfo{};
+		m_config->binding_descriptions = config_info->binding_descriptions;
+		m_config->binding_descriptions_count = config_info->binding_descriptions_count;
+		m_config->attribute_descriptions = config_info->attribute_descriptions;
+		m_config->attribute_descriptions_count = config_info->attribute_descriptions_count;
+		m_config->viewport_info = config_info->viewport_info;
+		m_config->input_assembly_info = config_info->input_assembly_info;
+		m_config->rasterization_info = config_info->rasterization_info;
+		m_config->multisample_info = config_info->multisample_info;
+		m_config->color_blend_attachment = config_info->color_blend_attachment;
+		m_config->color_blend_info = config_info->color_blend_info;
+		m_config->color_blend_info.pAttachments = &m_config->color_blend_attachment;
+		m_config->depth_stencil_info = config_info->depth_stencil_info;
+		m_config->dynamic_state_enables = config_info->dynamic_state_enables;
+		m_config->dynamic_state_enables_count = config_info->dynamic_state_enables_count;
+		m_config->dynamic_state_info = config_info->dynamic_state_info;
+		m_config->pipeline_layout = config_info->pipeline_layout;
+		m_config->render_pass = config_info->render_pass;
+		m_config->subpass = config_info->subpass;
+
+		m_device->getPipelineCompiler()->enqueue(this);
+		return this;
+	}
 
-		VkPipelineVertexInputStateCreateInfo vertex_input_info{};
-		vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertex_input_info.vertexAttributeDescriptionCount = config_info->attribute_descriptions_count;
-		vertex_input_info.vertexBindingDescriptionCount = config_info->binding_descriptions_count;
-		vertex_input_info.pVertexAttributeDescriptions = config_info->attribute_descriptions;
-		vertex_input_info.pVertexBindingDescriptions = config_info->binding_descriptions;
+	void Pipeline::wait()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_condition.wait(lock, [this] { return m_is_built.load(std::memory_order_acquire); });
+		if (m_result != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create graphics pipeline");
+		}
+	}
+
+	void Pipeline::build()
+	{
+		const auto start_time = std::chrono::high_resolution_clock::now();
 
-		for (unsigned int i = 0; i < m_shader_stages_count; i++)
+		VkResult result = VK_SUCCESS;
+		for (unsigned int i = 0; i < m_shader_stages_index && result == VK_SUCCESS; i++)
 		{
-			m_stage_flags |= m_shader_stages[i].stage;
+			VkShaderModuleCreateInfo create_info{};
+			create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			create_info.codeSize = m_shader_sizes[i];
+			create_info.pCode = reinterpret_cast<const unsigned int*>(m_shader_codes[i]);
+			result = vkCreateShaderModule(m_device->getDevice(), &create_info, nullptr, &m_shader_stages[i].module);
 		}
 
-		VkGraphicsPipelineCreateInfo pipeline_info{};
-		pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipeline_info.stageCount = m_shader_stages_count;
-		pipeline_info.pStages = m_shader_stages;
-		pipeline_info.pVertexInputState = &vertex_input_info;
-		pipeline_info.pInputAssemblyState = &config_info->input_assembly_info;
-		pipeline_info.pViewportState = &config_info->viewport_info;
-		pipeline_info.pRasterizationState = &config_info->rasterization_info;
-		pipeline_info.pMultisampleState = &config_info->multisample_info;
-		pipeline_info.pColorBlendState = &config_info->color_blend_info;
-		pipeline_info.pDepthStencilState = &config_info->depth_stencil_info;
-		pipeline_info.pDynamicState = &config_info->dynamic_state_info;
-
-		pipeline_info.layout = config_info->pipeline_layout;
-		pipeline_info.renderPass = config_info->render_pass;
-		pipeline_info.subpass = config_info->subpass;
-
-		pipeline_info.basePipelineIndex = -1;
-		pipeline_info.basePipelineHandle = nullptr;
-
-		if (vkCreateGraphicsPipelines(m_device->getDevice(), nullptr, 1, &pipeline_info, nullptr, &m_graphics_pipeline) != VK_SUCCESS)
+		if (result == VK_SUCCESS)
 		{
-			throw std::runtime_error("Failed to create graphics pipeline");
+			VkPipelineVertexInputStateCreateInfo vertex_input_info{};
+			vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			vertex_input_info.vertexAttributeDescriptionCount = m_config->attribute_descriptions_count;
+			vertex_input_info.vertexBindingDescriptionCount = m_config->binding_descriptions_count;
+			vertex_input_info.pVertexAttributeDescriptions = m_config->attribute_descriptions;
+			vertex_input_info.pVertexBindingDescriptions = m_config->binding_descriptions;
+
+			VkGraphicsPipelineCreateInfo pipeline_info{};
+			pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			pipeline_info.stageCount = m_shader_stages_index;
+			pipeline_info.pStages = m_shader_stages;
+			pipeline_info.pVertexInputState = &vertex_input_info;
+			pipeline_info.pInputAssemblyState = &m_config->input_assembly_info;
+			pipeline_info.pViewportState = &m_config->viewport_info;
+			pipeline_info.pRasterizationState = &m_config->rasterization_info;
+			pipeline_info.pMultisampleState = &m_config->multisample_info;
+			pipeline_info.pColorBlendState = &m_config->color_blend_info;
+			pipeline_info.pDepthStencilState = &m_config->depth_stencil_info;
+			pipeline_info.pDynamicState = &m_config->dynamic_state_info;
+
+			pipeline_info.layout = m_config->pipeline_layout;
+			pipeline_info.renderPass = m_config->render_pass;
+			pipeline_info.subpass = m_config->subpass;
+
+			pipeline_info.basePipelineIndex = -1;
+			pipeline_info.basePipelineHandle = nullptr;
+
+			// the device cache is internally synchronized, workers share it without a lock
+			result = vkCreateGraphicsPipelines(m_device->getDevice(), m_device->getPipelineCache(), 1, &pipeline_info, nullptr, &m_graphics_pipeline);
+		}
+		m_device->addPipelineCreationTime(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start_time).count());
+		if (result == VK_SUCCESS)
+		{
+			m_device->trackPipelines(1);
 		}
 
-		return this;
+		// notified under the lock, a waiter that sees the flag may destroy the pipeline
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_result = result;
+		m_is_built.store(true, std::memory_order_release);
+		m_condition.notify_all();
 	}
 }
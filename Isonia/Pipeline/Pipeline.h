@@ -1,11 +1,17 @@
 #pragma once
 
 // internal
+#include "../Debug/Debug.h"
 #include "../Math/Math.h"
 #include "../State/State.h"
 
 // external
 #include <vulkan/vulkan.h>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
 
 namespace Isonia::Pipeline
 {
@@ -26,6 +32,7 @@ namespace Isonia::Pipeline
         static const constexpr unsigned int right_shift = 0x036;
         static const constexpr unsigned int right_control = 0x11D;
         static const constexpr unsigned int tab = 0x00F;
+        static const constexpr unsigned int f3 = 0x03D;
 
         static const constexpr unsigned int left = 0x14B;
         static const constexpr unsigned int right = 0x14D;
@@ -50,7 +57,8 @@ namespace Isonia::Pipeline
     struct Window
     {
     public:
-        Window(unsigned int width, unsigned int height, const char* name);
+        // a headless window never opens, it only carries the extent and an idle keyboard
+        Window(unsigned int width, unsigned int height, const char* name, bool headless = false);
         ~Window();
 
         Window() = delete;
@@ -64,6 +72,7 @@ namespace Isonia::Pipeline
         void pollEvents();
 
         void createWindowSurface(VkInstance instance, VkSurfaceKHR* surface);
+        bool isHeadless() const;
 
         typedef void (*EventHandler)(Window*);
         void registerCallback(EventHandler handler);
@@ -76,8 +85,9 @@ namespace Isonia::Pipeline
     private:
         void createWindow();
 
-        void* m_window_instance;
-        void* m_window;
+        // native handles, null when headless
+        void* m_window_instance = nullptr;
+        void* m_window = nullptr;
 
         State::Keyboard m_input{};
 
@@ -85,6 +95,7 @@ namespace Isonia::Pipeline
         EventHandler m_handlers[4];
 
         const char* m_name;
+        bool m_headless;
     };
 
     struct SwapChainSupportDetails
@@ -112,6 +123,122 @@ namespace Isonia::Pipeline
         }
     };
 
+    struct MemoryBlock;
+
+    struct ResourceCategories
+    {
+        static const constexpr unsigned int general = 0u;
+        static const constexpr unsigned int terrain = 1u;
+        static const constexpr unsigned int grass = 2u;
+        static const constexpr unsigned int textures = 3u;
+        static const constexpr unsigned int ui = 4u;
+        static const constexpr unsigned int swap_chain = 5u;
+        static const constexpr unsigned int staging = 6u;
+        static const constexpr unsigned int uniform = 7u;
+
+        static const constexpr unsigned int count = 8u;
+        static const constexpr char* names[count] = { "General", "Terrain", "Grass", "Textures", "UI", "Swap chain", "Staging", "Uniform" };
+    };
+
+    struct ResourceCounter
+    {
+        unsigned int count;
+        unsigned int peak_count;
+        VkDeviceSize bytes;
+        VkDeviceSize peak_bytes;
+    };
+
+    struct MemoryAllocation
+    {
+        VkDeviceMemory memory = nullptr;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        // persistently mapped pointer to offset, null for device local memory
+        void* mapped = nullptr;
+        MemoryBlock* block = nullptr;
+        unsigned int category = ResourceCategories::general;
+    };
+
+    struct MemoryAllocatorStats
+    {
+        unsigned int device_memory_count;
+        unsigned int allocation_count;
+        unsigned long long allocate_calls;
+        VkDeviceSize reserved_bytes;
+        VkDeviceSize used_bytes;
+        unsigned int peak_device_memory_count;
+        VkDeviceSize peak_reserved_bytes;
+    };
+
+    struct MemoryAllocator
+    {
+    public:
+        static constexpr const VkDeviceSize default_block_size = 32ull * 1024ull * 1024ull;
+
+        MemoryAllocator(VkDevice device, VkPhysicalDevice physical_device, VkDeviceSize non_coherent_atom_size, VkDeviceSize block_size = default_block_size);
+        ~MemoryAllocator();
+
+        MemoryAllocator() = delete;
+        MemoryAllocator(const MemoryAllocator&) = delete;
+        MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+        void allocate(const VkMemoryRequirements* requirements, unsigned int memory_type, bool is_image, MemoryAllocation* allocation);
+        void deallocate(MemoryAllocation* allocation);
+        VkResult flush(const MemoryAllocation* allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
+        VkResult invalidate(const MemoryAllocation* allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const;
+        bool isHostCoherent(const MemoryAllocation* allocation) const;
+        MemoryAllocatorStats getStats();
+
+    private:
+        MemoryBlock* createBlock(unsigned int memory_type, VkDeviceSize size, bool is_dedicated);
+        void destroyBlock(MemoryBlock* block);
+        VkMappedMemoryRange getAtomRange(const MemoryAllocation* allocation, VkDeviceSize size, VkDeviceSize offset) const;
+
+        VkDevice m_device;
+        VkPhysicalDeviceMemoryProperties m_memory_properties;
+        const VkDeviceSize m_non_coherent_atom_size;
+        const VkDeviceSize m_block_size;
+
+        // buffers and optimal tiling images never share a block, so bufferImageGranularity can be ignored
+        MemoryBlock* m_pools[VK_MAX_MEMORY_TYPES][2] = {};
+
+        std::mutex m_mutex;
+        MemoryAllocatorStats m_stats{};
+    };
+
+    struct UploadContext;
+    struct PipelineCompiler;
+    struct TransientCommandPools;
+    struct UniformRing;
+    struct DeletionQueue;
+
+    struct ResourceStats
+    {
+        // bytes are allocation sizes, including alignment padding
+        ResourceCounter categories[ResourceCategories::count];
+        ResourceCounter buffers;
+        ResourceCounter images;
+        ResourceCounter descriptor_sets;
+        ResourceCounter pipelines;
+        MemoryAllocatorStats memory;
+    };
+
+    struct TransferStats
+    {
+        // staged into device local buffers and written to the uniform ring
+        VkDeviceSize buffer_bytes_uploaded;
+        // copied from buffers into images and back
+        VkDeviceSize image_bytes_copied;
+    };
+
+    struct PipelineCacheStats
+    {
+        unsigned int pipeline_count;
+        unsigned long long creation_time_us;
+        // zero when the cache file was missing or rejected
+        size_t loaded_bytes;
+    };
+
 	struct Device
 	{
 	public:
@@ -127,24 +254,55 @@ namespace Isonia::Pipeline
         VkSurfaceKHR getSurface() const;
         VkQueue getGraphicsQueue() const;
         VkQueue getPresentQueue() const;
+        // without a surface, presentation is replaced by offscreen images
+        bool isHeadless() const;
         SwapChainSupportDetails getSwapChainSupport();
         QueueFamilyIndices getPhysicalQueueFamilies();
+        MemoryAllocator* getAllocator() const;
+        UploadContext* getUploadContext() const;
+        TransientCommandPools* getTransientCommandPools() const;
+        UniformRing* getUniformRing() const;
+        DeletionQueue* getDeletionQueue() const;
+        VkPipelineCache getPipelineCache() const;
+        PipelineCompiler* getPipelineCompiler() const;
+        PipelineCacheStats getPipelineCacheStats();
+        void addPipelineCreationTime(unsigned long long microseconds);
 
 		unsigned int findMemoryType(unsigned int type_filter, VkMemoryPropertyFlags properties) const;
 		VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer command_buffer);
-        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, VkDeviceMemory* buffer_memory);
-        void copyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size);
-        void copyBufferToImage(VkBuffer buffer, VkImage image, unsigned int width, unsigned int height, unsigned int layer_count);
-        void createImageWithInfo(const VkImageCreateInfo* image_info, VkMemoryPropertyFlags properties, VkImage* image, VkDeviceMemory* image_memory);
+        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* buffer, MemoryAllocation* buffer_allocation, unsigned int category = ResourceCategories::general);
+        void destroyBuffer(VkBuffer buffer, MemoryAllocation* buffer_allocation);
+        void createImageWithInfo(const VkImageCreateInfo* image_info, VkMemoryPropertyFlags properties, VkImage* image, MemoryAllocation* image_allocation, unsigned int category = ResourceCategories::general);
+        void destroyImage(VkImage image, MemoryAllocation* image_allocation);
         void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, unsigned int mip_levels, unsigned int layer_count);
+        void recordTransitionImageLayout(VkCommandBuffer command_buffer, VkImage image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout, unsigned int mip_levels, unsigned int layer_count);
         VkFormat findSupportedFormat(const VkFormat* candidates, const unsigned int candidates_count, VkImageTiling tiling, VkFormatFeatureFlags features) const;
+        bool isFormatSupported(VkFormat format, VkImageTiling tiling, VkFormatFeatureFlags features) const;
+        bool hasHostVisibleDeviceMemory() const;
+
+        ResourceStats getResourceStats();
+        void trackDescriptorSets(int count);
+        void trackPipelines(int count);
+        void trackTransfer(VkDeviceSize buffer_bytes, VkDeviceSize image_bytes);
+        // of the last finished frame
+        TransferStats getTransferStats();
+
+        // per frame resources, called by the renderer around the frame's recording with its frame slot
+        // and the swap chain fence that last covered the slot
+        void beginFrame(unsigned int frame, VkFence frame_fence);
+        void endFrame();
 
         VkPhysicalDeviceProperties m_properties;
+        VkPhysicalDeviceFeatures m_enabled_features{};
+        // optional, sampled images can be indexed from a single update after bind heap
+        bool m_descriptor_indexing = false;
+        unsigned int m_max_bindless_textures = 0u;
 
 	private:
 		const char** getRequiredExtensions(unsigned int* count);
 		bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+		bool isDeviceExtensionSupported(VkPhysicalDevice device, const char* extension) const;
 		QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device) const;
 		SwapChainSupportDetails findSwapChainSupport(VkPhysicalDevice device) const;
 
@@ -152,7 +310,12 @@ namespace Isonia::Pipeline
         void createSurface();
         void pickPhysicalDevice();
         void createLogicalDevice();
+        void findDescriptorIndexingSupport(VkPhysicalDeviceDescriptorIndexingFeaturesEXT* indexing_features);
 		void createCommandPool();
+		void findHostVisibleDeviceMemory();
+		void createPipelineCache();
+		void savePipelineCache();
+		void trackAllocation(ResourceCounter* counter, const MemoryAllocation* allocation, int count);
 
 		bool isDeviceSuitable(VkPhysicalDevice device);
 
@@ -164,9 +327,25 @@ namespace Isonia::Pipeline
 		VkPhysicalDevice m_physical_device = nullptr;
 		VkCommandPool m_command_pool;
 		VkDevice m_device;
-		VkSurfaceKHR m_surface;
+		VkSurfaceKHR m_surface = nullptr;
 		VkQueue m_graphics_queue;
 		VkQueue m_present_queue;
+		MemoryAllocator* m_allocator;
+		UploadContext* m_upload_context;
+		TransientCommandPools* m_transient_command_pools;
+		UniformRing* m_uniform_ring;
+		DeletionQueue* m_deletion_queue;
+		bool m_host_visible_device_memory = false;
+		VkPipelineCache m_pipeline_cache;
+		PipelineCompiler* m_pipeline_compiler;
+		PipelineCacheStats m_pipeline_cache_stats{};
+		std::mutex m_pipeline_cache_mutex;
+		ResourceStats m_resource_stats{};
+		TransferStats m_transfer_stats{};
+		TransferStats m_frame_transfer_stats{};
+		std::mutex m_resource_mutex;
+
+        static const constexpr char* m_pipeline_cache_path = "pipeline_cache.bin";
 
         static const constexpr unsigned int m_device_extensions_count = 1u;
         static const constexpr char* m_device_extensions[m_device_extensions_count] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
@@ -189,7 +368,7 @@ namespace Isonia::Pipeline
     struct Buffer
     {
     public:
-        Buffer(Device* device, VkDeviceSize instance_size, unsigned int instance_count, VkBufferUsageFlags usage_flags, VkMemoryPropertyFlags memory_property_flags, VkDeviceSize min_offset_alignment = 1);
+        Buffer(Device* device, VkDeviceSize instance_size, unsigned int instance_count, VkBufferUsageFlags usage_flags, VkMemoryPropertyFlags memory_property_flags, VkDeviceSize min_offset_alignment = 1, unsigned int category = ResourceCategories::general);
         ~Buffer();
 
         Buffer() = delete;
@@ -198,7 +377,7 @@ namespace Isonia::Pipeline
 
         VkResult map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
         void unmap();
-        void writeToBuffer(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        void writeToBuffer(const void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
         VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
         VkResult invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
         const VkDescriptorBufferInfo* getDescriptorInfo() const;
@@ -221,7 +400,7 @@ namespace Isonia::Pipeline
         Device* m_device;
         void* m_mapped = nullptr;
         VkBuffer m_buffer = nullptr;
-        VkDeviceMemory m_memory = nullptr;
+        MemoryAllocation m_allocation{};
 
         VkDescriptorBufferInfo m_buffer_info;
         VkDeviceSize m_buffer_size;
@@ -232,6 +411,523 @@ namespace Isonia::Pipeline
         VkMemoryPropertyFlags m_memory_property_flags;
     };
 
+    struct UploadBatch
+    {
+        VkCommandBuffer command_buffer;
+        VkFence fence;
+        unsigned long long ticket;
+        bool is_pending;
+        // first ring byte owned by the batch, everything up to the next batch is freed with it
+        bool has_staging;
+        VkDeviceSize staging_begin;
+        Buffer** released_buffers;
+        unsigned int released_count;
+        unsigned int released_capacity;
+    };
+
+    struct UploadContext
+    {
+    public:
+        static constexpr const unsigned int max_batches = 4u;
+        static constexpr const VkDeviceSize staging_ring_size = 64ull * 1024ull * 1024ull;
+        // satisfies buffer to image copies of every format in use, including 16 byte bc5 blocks
+        static constexpr const VkDeviceSize staging_alignment = 16ull;
+
+        UploadContext(Device* device);
+        ~UploadContext();
+
+        UploadContext() = delete;
+        UploadContext(const UploadContext&) = delete;
+        UploadContext& operator=(const UploadContext&) = delete;
+
+        // the returned staging memory must be filled before the next submit
+        void* stageBuffer(VkBuffer dst_buffer, VkDeviceSize size, VkDeviceSize dst_offset = 0, unsigned long long* ticket = nullptr);
+        void* stageImage(VkImage image, VkFormat format, unsigned int width, unsigned int height, unsigned int layer_count, VkDeviceSize size, unsigned long long* ticket = nullptr);
+        // device local buffer whose contents are written once through data, directly when the memory is host visible
+        Buffer* createBuffer(VkDeviceSize instance_size, unsigned int instance_count, VkBufferUsageFlags usage_flags, void** data, unsigned int category = ResourceCategories::general);
+
+        unsigned long long submit();
+        bool isComplete(unsigned long long ticket);
+        void wait(unsigned long long ticket);
+
+    private:
+        void* allocateStaging(VkDeviceSize size, VkBuffer* buffer, VkDeviceSize* offset);
+        void* allocateDedicatedStaging(VkDeviceSize size, VkBuffer* buffer, VkDeviceSize* offset);
+        bool findStagingSpace(VkDeviceSize size, VkDeviceSize* offset) const;
+        UploadBatch* getOldestStagingBatch() const;
+        void releaseBuffer(UploadBatch* batch, Buffer* buffer);
+
+        UploadBatch* beginBatch();
+        void submitBatch();
+        void pollBatches();
+        void retireBatch(UploadBatch* batch);
+
+        Device* m_device;
+        VkCommandPool m_command_pool;
+
+        UploadBatch m_batches[max_batches];
+        UploadBatch* m_recording = nullptr;
+        unsigned int m_next_batch = 0u;
+        unsigned long long m_next_ticket = 1ull;
+
+        Buffer* m_staging_ring;
+        VkDeviceSize m_staging_head = 0;
+
+        std::mutex m_mutex;
+    };
+
+    struct TransientCommandPool
+    {
+        VkCommandPool command_pool;
+        // indexed by primary and secondary level, buffers are kept across resets
+        VkCommandBuffer* command_buffers[2];
+        unsigned int allocated_counts[2];
+        unsigned int used_counts[2];
+    };
+
+    struct TransientCommandPools
+    {
+    public:
+        static constexpr const unsigned int max_threads = 16u;
+
+        TransientCommandPools(Device* device);
+        ~TransientCommandPools();
+
+        TransientCommandPools() = delete;
+        TransientCommandPools(const TransientCommandPools&) = delete;
+        TransientCommandPools& operator=(const TransientCommandPools&) = delete;
+
+        // returned buffers are recording and stay valid until their frame slot comes around again
+        VkCommandBuffer beginPrimary();
+        VkCommandBuffer beginSecondary(const VkCommandBufferInheritanceInfo* inheritance_info);
+
+        // frame is the renderer's frame slot and frame_fence the swap chain fence of its last submission, all recording
+        // into the slot's pools must happen after beginFrame and be submitted with the slot's frame
+        void beginFrame(unsigned int frame, VkFence frame_fence);
+
+    private:
+        TransientCommandPool* getThreadPool();
+        VkCommandBuffer acquire(unsigned int level, const VkCommandBufferBeginInfo* begin_info);
+
+        Device* m_device;
+        TransientCommandPool m_pools[max_frames_in_flight][max_threads];
+        std::thread::id m_thread_ids[max_threads];
+        unsigned int m_thread_count = 0u;
+        unsigned int m_frame = 0u;
+
+        std::mutex m_mutex;
+    };
+
+    struct DeferredDestruction
+    {
+        // frame recording when the handles were released, only the non null handles are destroyed
+        unsigned long long frame;
+        VkBuffer buffer;
+        VkImage image;
+        VkImageView image_view;
+        VkSampler sampler;
+        MemoryAllocation allocation;
+    };
+
+    struct DeletionQueue
+    {
+    public:
+        DeletionQueue(Device* device);
+        ~DeletionQueue();
+
+        DeletionQueue() = delete;
+        DeletionQueue(const DeletionQueue&) = delete;
+        DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+        // destroyed once every frame that could reference them has finished
+        void destroyBuffer(VkBuffer buffer, MemoryAllocation* allocation);
+        void destroyImage(VkImage image, MemoryAllocation* allocation);
+        void destroyImageView(VkImageView image_view);
+        void destroySampler(VkSampler sampler);
+
+        // retire runs after the oldest frame slot's fence is waited, endFrame after its submit
+        void retire();
+        void endFrame();
+        void flush();
+
+    private:
+        void enqueue(const DeferredDestruction* entry);
+        void destroy(DeferredDestruction* entry);
+
+        Device* m_device;
+        DeferredDestruction* m_entries;
+        unsigned int m_head = 0u;
+        unsigned int m_count = 0u;
+        unsigned int m_capacity = 64u;
+        unsigned long long m_frame = 0ull;
+
+        std::mutex m_mutex;
+    };
+
+    struct UniformRing
+    {
+    public:
+        static constexpr const VkDeviceSize frame_size = 256ull * 1024ull;
+
+        UniformRing(Device* device);
+        ~UniformRing();
+
+        UniformRing() = delete;
+        UniformRing(const UniformRing&) = delete;
+        UniformRing& operator=(const UniformRing&) = delete;
+
+        // memory is valid for the current frame only, bind with the returned dynamic offset
+        void* allocate(VkDeviceSize size, unsigned int* dynamic_offset);
+        unsigned int push(const void* data, VkDeviceSize size);
+        // for uniform buffer dynamic descriptors, range is the size of the bound struct
+        VkDescriptorBufferInfo getDescriptorInfo(VkDeviceSize range) const;
+
+        void beginFrame(unsigned int frame);
+        VkResult flush();
+
+    private:
+        Device* m_device;
+        Buffer* m_buffer;
+        VkDeviceSize m_alignment;
+        VkDeviceSize m_frame_begin = 0;
+        VkDeviceSize m_head = 0;
+
+        std::mutex m_mutex;
+    };
+
+    // what the frame's gpu time and workload are broken down by
+    struct RenderScopes
+    {
+        static const constexpr unsigned int frame = 0u;
+        static const constexpr unsigned int scene_pass = 1u;
+        static const constexpr unsigned int water_pass = 2u;
+        static const constexpr unsigned int blit_pass = 3u;
+        static const constexpr unsigned int ground = 4u;
+        // timed on its own, but recorded in the ground's jobs so its workload counts towards the ground
+        static const constexpr unsigned int grass = 5u;
+        static const constexpr unsigned int debugger = 6u;
+        static const constexpr unsigned int water = 7u;
+        static const constexpr unsigned int ui = 8u;
+
+        static const constexpr unsigned int count = 9u;
+        static const constexpr char* names[count] = { "Frame", "Scene Pass", "Water Pass", "Blit Pass", "Ground", "Grass", "Debugger", "Water", "UI" };
+    };
+
+    struct CommandTypes
+    {
+        static const constexpr unsigned int pipeline = 0u;
+        static const constexpr unsigned int descriptor_sets = 1u;
+        static const constexpr unsigned int vertex_buffers = 2u;
+        static const constexpr unsigned int index_buffer = 3u;
+        static const constexpr unsigned int push_constants = 4u;
+        static const constexpr unsigned int draw = 5u;
+
+        static const constexpr unsigned int count = 6u;
+        static const constexpr char* names[count] = { "Pipeline", "Descriptor Sets", "Vertex Buffers", "Index Buffer", "Push Constants", "Draw" };
+    };
+
+    struct CommandRecorderStats
+    {
+        unsigned int issued[CommandTypes::count];
+        unsigned int elided[CommandTypes::count];
+        // submitted by the issued draws, indices for indexed draws, every instance counted
+        unsigned long long vertices;
+        unsigned long long instances;
+        unsigned long long push_constant_bytes;
+    };
+
+    struct FrameWorkloadStats
+    {
+        CommandRecorderStats total;
+        // what each render system's jobs recorded, commands on the primary are only in the total
+        CommandRecorderStats scopes[RenderScopes::count];
+        // since the previous frame, so uploads made between frames count towards the next
+        TransferStats transfers;
+    };
+
+    struct CommandRecorder
+    {
+    public:
+        static constexpr const unsigned int max_descriptor_sets = 4u;
+        static constexpr const unsigned int max_dynamic_offsets = 8u;
+        static constexpr const unsigned int max_vertex_buffers = 4u;
+        static constexpr const unsigned int max_push_constants_size = 128u;
+
+        CommandRecorder();
+
+        CommandRecorder(const CommandRecorder&) = delete;
+        CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+        // forgets all bound state, the stats of the previous recording become the frame stats
+        void begin(VkCommandBuffer command_buffer);
+        // for commands recorded around the recorder that may have changed bound state
+        void invalidate();
+
+        VkCommandBuffer getCommandBuffer() const;
+        const CommandRecorderStats* getFrameStats() const;
+        // counts of the recording in progress
+        const CommandRecorderStats* getStats() const;
+        // folds in the counts of secondary command buffers executed by this one, kept apart per render scope too
+        void accumulate(const CommandRecorderStats* stats, unsigned int scope);
+        // counts of the recording in progress that were folded in for the scope
+        const CommandRecorderStats* getScopeStats(unsigned int scope) const;
+        static void addStats(CommandRecorderStats* stats, const CommandRecorderStats* other);
+
+        void bindPipeline(VkPipeline pipeline);
+        // sets are only kept across binds that use the same layout
+        void bindDescriptorSets(VkPipelineLayout layout, unsigned int first_set, unsigned int set_count, const VkDescriptorSet* descriptor_sets, unsigned int dynamic_offset_count, const unsigned int* dynamic_offsets);
+        void bindVertexBuffers(unsigned int first_binding, unsigned int binding_count, const VkBuffer* buffers, const VkDeviceSize* offsets);
+        void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType index_type);
+        void pushConstants(VkPipelineLayout layout, VkShaderStageFlags stage_flags, unsigned int offset, unsigned int size, const void* values);
+        void draw(unsigned int vertex_count, unsigned int instance_count, unsigned int first_vertex, unsigned int first_instance);
+        void drawIndexed(unsigned int index_count, unsigned int instance_count, unsigned int first_index, int vertex_offset, unsigned int first_instance);
+
+    private:
+        struct BoundDescriptorSet
+        {
+            VkDescriptorSet descriptor_set;
+            // a bind's dynamic offsets are all kept on its first set
+            unsigned int dynamic_offset_count;
+            unsigned int dynamic_offsets[max_dynamic_offsets];
+        };
+
+        VkCommandBuffer m_command_buffer = nullptr;
+
+        VkPipeline m_pipeline = nullptr;
+        VkPipelineLayout m_descriptor_layout = nullptr;
+        BoundDescriptorSet m_descriptor_sets[max_descriptor_sets]{};
+        VkBuffer m_vertex_buffers[max_vertex_buffers]{};
+        VkDeviceSize m_vertex_offsets[max_vertex_buffers]{};
+        VkBuffer m_index_buffer = nullptr;
+        VkDeviceSize m_index_offset = 0;
+        VkIndexType m_index_type = VK_INDEX_TYPE_UINT32;
+
+        // only the bytes between begin and end are known
+        VkPipelineLayout m_push_constant_layout = nullptr;
+        VkShaderStageFlags m_push_constant_stages = 0;
+        unsigned int m_push_constants_begin = 0u;
+        unsigned int m_push_constants_end = 0u;
+        unsigned char m_push_constants[max_push_constants_size];
+
+        CommandRecorderStats m_stats{};
+        CommandRecorderStats m_frame_stats{};
+        CommandRecorderStats m_scope_stats[RenderScopes::count]{};
+    };
+
+    struct ParallelRecorder
+    {
+    public:
+        static constexpr const unsigned int max_workers = 4u;
+        static constexpr const unsigned int max_jobs = 32u;
+
+        typedef void (*RecordCallback)(CommandRecorder* recorder, void* user_data, void* frame_data, unsigned int first, unsigned int last);
+
+        ParallelRecorder(Device* device);
+        ~ParallelRecorder();
+
+        ParallelRecorder() = delete;
+        ParallelRecorder(const ParallelRecorder&) = delete;
+        ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+        // the render pass must have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+        void begin(VkRenderPass render_pass, VkFramebuffer framebuffer, VkExtent2D extent, void* frame_data);
+        // jobs are executed in the order they were added, whichever thread recorded them
+        // the job's counts are folded into the primary under the render scope
+        void addJob(RecordCallback callback, void* user_data, unsigned int scope, unsigned int first = 0u, unsigned int last = 0u);
+        // splits [0, count) into about one range per thread
+        void addJobs(RecordCallback callback, void* user_data, unsigned int scope, unsigned int count);
+        // the calling thread records alongside the workers, then the secondaries are executed into the primary
+        void execute(CommandRecorder* primary);
+
+    private:
+        struct Job
+        {
+            RecordCallback callback;
+            void* user_data;
+            unsigned int scope;
+            unsigned int first;
+            unsigned int last;
+            VkCommandBuffer command_buffer;
+            CommandRecorderStats stats;
+        };
+
+        void workerLoop();
+        void recordJob(Job* job);
+
+        Device* m_device;
+        std::thread* m_workers;
+        unsigned int m_worker_count;
+
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::condition_variable m_finished_condition;
+        Job m_jobs[max_jobs];
+        unsigned int m_jobs_count = 0u;
+        unsigned int m_next_job = 0u;
+        unsigned int m_finished_jobs = 0u;
+        bool m_is_recording = false;
+        bool m_stop = false;
+
+        VkCommandBufferInheritanceInfo m_inheritance_info{};
+        VkExtent2D m_extent{};
+        void* m_frame_data = nullptr;
+    };
+
+    struct GpuTimingStats
+    {
+        // from the earliest begin to the latest end of the scope's queries, so a system split over several
+        // jobs executed back to back is timed once rather than once per job
+        float milliseconds[RenderScopes::count];
+    };
+
+    struct GpuTimer
+    {
+    public:
+        // begin and end timestamp pairs per frame in flight
+        static constexpr const unsigned int max_queries = 64u;
+        static constexpr const unsigned int invalid_query = ~0u;
+        static constexpr const unsigned int invalid_frame = ~0u;
+
+        GpuTimer(Device* device);
+        ~GpuTimer();
+
+        GpuTimer() = delete;
+        GpuTimer(const GpuTimer&) = delete;
+        GpuTimer& operator=(const GpuTimer&) = delete;
+
+        // reads what the slot's last frame measured without waiting and resets it, outside of any render pass
+        void beginFrame(VkCommandBuffer command_buffer, unsigned int frame);
+        // thread safe, secondaries recorded on workers time their own draws
+        unsigned int begin(VkCommandBuffer command_buffer, unsigned int scope);
+        // on the command buffer the query was begun on
+        void end(VkCommandBuffer command_buffer, unsigned int query);
+        // every begun query has to be ended by now
+        void endFrame();
+
+        // as of the last frame that finished, zero without timestamp support
+        const GpuTimingStats* getStats() const;
+        // which frame the stats were measured on, counted in beginFrame calls, invalid_frame until one was read back
+        unsigned int getStatsFrame() const;
+
+    private:
+        void readResults(unsigned int frame);
+
+        Device* m_device;
+        VkQueryPool m_query_pool = nullptr;
+        float m_period_ms = 0.0f;
+
+        unsigned int m_frame = 0u;
+        std::atomic<unsigned int> m_query_count{ 0u };
+        unsigned int m_query_counts[max_frames_in_flight]{};
+        unsigned int m_query_scopes[max_frames_in_flight][max_queries]{};
+        unsigned int m_query_frames[max_frames_in_flight]{};
+        unsigned int m_frames_begun = 0u;
+
+        GpuTimingStats m_stats{};
+        unsigned int m_stats_frame = invalid_frame;
+    };
+
+    struct RenderGraphUsages
+    {
+        static const constexpr unsigned int color_attachment = 0u;
+        static const constexpr unsigned int depth_attachment = 1u;
+        static const constexpr unsigned int sampled = 2u;
+        static const constexpr unsigned int depth_sampled = 3u;
+        // tested against and sampled in the same pass
+        static const constexpr unsigned int depth_read_only = 4u;
+        static const constexpr unsigned int transfer_src = 5u;
+        static const constexpr unsigned int transfer_dst = 6u;
+
+        static const constexpr unsigned int count = 7u;
+        static const constexpr char* names[count] = { "Color Attachment", "Depth Attachment", "Sampled", "Depth Sampled", "Depth Read Only", "Transfer Source", "Transfer Destination" };
+    };
+
+    struct RenderGraph
+    {
+    public:
+        static constexpr const unsigned int max_resources = 16u;
+        static constexpr const unsigned int max_passes = 16u;
+        static constexpr const unsigned int max_pass_accesses = 8u;
+
+        typedef void (*PassCallback)(VkCommandBuffer command_buffer, void* user_data, void* frame_data);
+
+        RenderGraph();
+
+        RenderGraph(const RenderGraph&) = delete;
+        RenderGraph& operator=(const RenderGraph&) = delete;
+
+        // the image is set every frame, a final layout of undefined leaves it wherever the last pass did
+        unsigned int importImage(const char* name, VkImageAspectFlags aspect, VkImageLayout initial_layout, VkImageLayout final_layout, VkPipelineStageFlags initial_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        // passes that do not lead to an output are culled
+        void markOutput(unsigned int resource);
+
+        unsigned int addPass(const char* name, PassCallback callback, void* user_data);
+        RenderGraph* read(unsigned int pass, unsigned int resource, unsigned int usage);
+        // a discarded write does not keep the previous contents, loading writes also depend on earlier passes
+        RenderGraph* write(unsigned int pass, unsigned int resource, unsigned int usage, bool discard = false);
+        void compile();
+
+        void setImage(unsigned int resource, VkImage image);
+        // records the passes in declaration order with the barriers between them
+        void execute(VkCommandBuffer command_buffer, void* frame_data);
+
+        bool isCulled(unsigned int pass) const;
+        // of the last execute
+        unsigned int getBarrierCount() const;
+
+    private:
+        struct Access
+        {
+            unsigned int resource;
+            VkPipelineStageFlags stages;
+            VkAccessFlags access;
+            VkAccessFlags write_access;
+            VkImageLayout layout;
+            bool is_write;
+            bool is_discard;
+        };
+
+        struct Pass
+        {
+            const char* name;
+            PassCallback callback;
+            void* user_data;
+            Access accesses[max_pass_accesses];
+            unsigned int accesses_count;
+            bool is_culled;
+        };
+
+        struct Resource
+        {
+            const char* name;
+            VkImageAspectFlags aspect;
+            VkImageLayout initial_layout;
+            VkImageLayout final_layout;
+            VkPipelineStageFlags initial_stages;
+            VkImage image;
+            bool is_output;
+
+            // tracked while executing
+            VkImageLayout layout;
+            VkPipelineStageFlags write_stages;
+            VkAccessFlags write_access;
+            VkPipelineStageFlags read_stages;
+            // stages already made to wait on the last write
+            VkPipelineStageFlags synced_stages;
+        };
+
+        RenderGraph* addAccess(unsigned int pass, unsigned int resource, unsigned int usage, bool is_write, bool is_discard);
+        // appends the barrier the access needs, if any, and moves the resource to its new state
+        bool resolveAccess(const Access* access, VkImageMemoryBarrier* barrier, VkPipelineStageFlags* src_stages, VkPipelineStageFlags* dst_stages);
+
+        Pass m_passes[max_passes];
+        unsigned int m_passes_count = 0u;
+        Resource m_resources[max_resources];
+        unsigned int m_resources_count = 0u;
+        bool m_is_compiled = false;
+        unsigned int m_barrier_count = 0u;
+    };
+
     struct PipelineConfigInfo
     {
         PipelineConfigInfo() = default;
@@ -269,7 +965,8 @@ namespace Isonia::Pipeline
 
         VkShaderStageFlags getStageFlags() const;
 
-        void bind(VkCommandBuffer command_buffer);
+        void bind(CommandRecorder* recorder);
+        void wait();
 
         Pipeline* addShaderModule(VkShaderStageFlagBits stage, const unsigned char* const code, const unsigned int size);
 
@@ -279,19 +976,64 @@ namespace Isonia::Pipeline
         static void defaultPipelineConfigInfo(PipelineConfigInfo* config_info);
         static void makePixelPerfectConfigInfo(PipelineConfigInfo* config_info);
         static void makeTransparentConfigInfo(PipelineConfigInfo* config_info);
+        // for passes that sample the depth attachment they test against
+        static void makeReadOnlyDepthConfigInfo(PipelineConfigInfo* config_info);
         static void makeTriangleStripConfigInfo(PipelineConfigInfo* config_info);
 
+        // queues the build on the device's compiler, the pipeline is waited for on first bind
         Pipeline* createGraphicsPipeline(const PipelineConfigInfo* config_info);
 
     private:
-        VkShaderModule createShaderModule(const unsigned char* const code, const unsigned int size);
+        friend struct PipelineCompiler;
+
+        void build();
 
         Device* m_device;
-        VkPipeline m_graphics_pipeline;
+        VkPipeline m_graphics_pipeline = nullptr;
         VkPipelineShaderStageCreateInfo* m_shader_stages;
+        const unsigned char** m_shader_codes;
+        unsigned int* m_shader_sizes;
         const unsigned int m_shader_stages_count;
         unsigned int m_shader_stages_index = 0u;
         VkShaderStageFlags m_stage_flags{};
+        PipelineConfigInfo* m_config = nullptr;
+
+        // shared with the compiler workers
+        std::atomic<bool> m_is_built{ false };
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        VkResult m_result = VK_SUCCESS;
+        Pipeline* m_next_job = nullptr;
+    };
+
+    struct PipelineCompiler
+    {
+    public:
+        static constexpr const unsigned int max_workers = 4u;
+
+        PipelineCompiler(Device* device);
+        ~PipelineCompiler();
+
+        PipelineCompiler() = delete;
+        PipelineCompiler(const PipelineCompiler&) = delete;
+        PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+        void enqueue(Pipeline* pipeline);
+
+    private:
+        void workerLoop();
+
+        Device* m_device;
+        std::thread* m_workers;
+        unsigned int m_worker_count;
+
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        Pipeline* m_queue_head = nullptr;
+        Pipeline* m_queue_tail = nullptr;
+        unsigned int m_active_jobs = 0u;
+        std::chrono::high_resolution_clock::time_point m_batch_start;
+        bool m_stop = false;
     };
 
     struct RenderPassInfo
@@ -305,27 +1047,19 @@ namespace Isonia::Pipeline
     public:
         VkFence m_image_in_flight = nullptr;
 
+        VkDescriptorImageInfo m_depth_descriptor;
         VkImage m_depth_image;
-        VkDeviceMemory m_depth_image_memory;
+        MemoryAllocation m_depth_image_allocation;
         VkImageView m_depth_image_view;
+        VkSampler m_depth_sampler = nullptr;
 
         VkImage m_color_image;
-        VkDeviceMemory m_color_image_memory;
+        MemoryAllocation m_color_image_allocation;
         VkImageView m_color_image_view;
 
-        VkDescriptorImageInfo m_color_descriptor_intermediate;
-        VkImage m_color_image_intermediate;
-        VkDeviceMemory m_color_image_memory_intermediate;
-        VkImageView m_color_image_view_intermediate;
-        VkSampler m_color_sampler_intermediate = nullptr;
-
-        VkDescriptorImageInfo m_depth_descriptor_intermediate;
-        VkImage m_depth_image_intermediate;
-        VkDeviceMemory m_depth_image_memory_intermediate;
-        VkImageView m_depth_image_view_intermediate;
-        VkSampler m_depth_sampler_intermediate = nullptr;
-
         VkImage m_swap_chain_image;
+        // only owned by headless swap chains, presentable images belong to the swap chain
+        MemoryAllocation m_swap_chain_image_allocation;
         VkImageView m_swap_chain_image_view;
 
         VkSemaphore m_image_available_semaphore = nullptr;
@@ -349,13 +1083,19 @@ namespace Isonia::Pipeline
         PixelSwapChain& operator=(const PixelSwapChain&) = delete;
 
         unsigned int getImageCount() const;
+        // fence of the last submission that used the image, null before its first
+        VkFence getImageInFlightFence(int index) const;
         VkImage getSwapChainImage(int index) const;
         VkImage getImage(int index) const;
         VkImage getDepthImage(int index) const;
-        VkImage getIntermediateImage(int index) const;
-        const VkDescriptorImageInfo* getIntermediateImageInfo(int index) const;
-        VkImage getIntermediateDepthImage(int index) const;
-        const VkDescriptorImageInfo* getIntermediateDepthImageInfo(int index) const;
+        // read only depth, valid while the second render pass tests against it
+        const VkDescriptorImageInfo* getDepthImageInfo(int index) const;
+        VkImageAspectFlags getDepthAspect() const;
+        // the layout swap chain images are left in at the end of a frame and the stage they become available at
+        VkImageLayout getPresentLayout() const;
+        VkPipelineStageFlags getImageAvailableStage() const;
+        // waits for the queue, out_rgb holds width * height * 3 bytes
+        void readSwapChainImage(int index, unsigned char* out_rgb);
         
         VkFramebuffer getFrameBuffer(int index) const;
         VkRenderPass getRenderPass(const unsigned int index) const;
@@ -383,14 +1123,14 @@ namespace Isonia::Pipeline
 	private:
 		void init();
 		void createPixelSwapChain();
+		void createOffscreenImages();
 		void createImageViews();
 		void createRenderPass();
 		void createFramebuffers();
 		void createColorResources();
 		void createDepthResources();
 		void createSyncObjects();
-        void createColorIntermediates();
-        void createDepthIntermediates();
+        void createDepthSamplers();
 
         VkSurfaceFormatKHR chooseSwapSurfaceFormat(VkSurfaceFormatKHR* available_formats, const unsigned int available_formats_count);
         VkPresentModeKHR chooseSwapPresentMode(VkPresentModeKHR* available_present_modes, const unsigned int available_present_modes_count);
@@ -408,10 +1148,11 @@ namespace Isonia::Pipeline
 		VkExtent2D m_window_extent;
 		VkExtent2D m_render_extent;
 
-		VkSwapchainKHR m_swap_chain;
+		VkSwapchainKHR m_swap_chain = nullptr;
 		PixelSwapChain* m_old_swap_chain;
 
         unsigned int m_image_count;
+        unsigned int m_next_offscreen_image = 0u;
 	};
 
     struct PixelRenderer
@@ -434,17 +1175,27 @@ namespace Isonia::Pipeline
         PixelSwapChain* getPixelSwapChain() const;
 
         VkCommandBuffer getCurrentCommandBuffer() const;
+        CommandRecorder* getCommandRecorder();
+        // counts of the last finished frame
+        const FrameWorkloadStats* getWorkloadStats() const;
+        // summed over every finished frame, for averages over a run
+        const FrameWorkloadStats* getWorkloadTotals() const;
+        unsigned int getFinishedFrameCount() const;
+        // milliseconds the gpu spent on the last finished frame, zero without timestamp support
+        float getGpuFrameTime() const;
+        GpuTimer* getGpuTimer();
         int getFrameIndex() const;
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer command_buffer, unsigned int render_pass_index);
+        void beginSwapChainRenderPass(VkCommandBuffer command_buffer, unsigned int render_pass_index, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+        // jobs added to the returned recorder and executed before endSwapChainRenderPass make up the whole pass
+        ParallelRecorder* beginParallelRenderPass(VkCommandBuffer command_buffer, unsigned int render_pass_index, void* frame_data);
         void endSwapChainRenderPass(VkCommandBuffer command_buffer);
+        // no barriers, the image layouts are left to the frame's render graph
         void blit(VkCommandBuffer command_buffer, Math::Vector2 offset);
 
         unsigned int getRenderFactor() const;
 
-        void copyToIntermediates(VkCommandBuffer command_buffer);
-
     protected:
         void createCommandBuffers();
         void freeCommandBuffers();
@@ -463,8 +1214,17 @@ namespace Isonia::Pipeline
         void* m_user_data[4];
 
         bool m_is_frame_started = false;
+        // reset with the command buffer each frame, bound state does not outlive it
+        CommandRecorder m_command_recorder;
+        ParallelRecorder m_parallel_recorder;
         unsigned int m_render_factor = 1u;
 
+        GpuTimer m_gpu_timer;
+        unsigned int m_frame_query = GpuTimer::invalid_query;
+        FrameWorkloadStats m_workload_stats{};
+        FrameWorkloadStats m_workload_totals{};
+        unsigned int m_finished_frame_count = 0u;
+
         unsigned int m_current_frame = 0;
     };
 
@@ -487,6 +1247,8 @@ namespace Isonia::Pipeline
         VkRenderPass getRenderPass() const;
         VkImageView getImageView(int index) const;
         unsigned int getImageCount() const;
+        // fence of the last submission that used the image, null before its first
+        VkFence getImageInFlightFence(int index) const;
         VkFormat getSwapChainImageFormat() const;
         VkExtent2D getSwapChainExtent() const;
         unsigned int getWidth() const;
@@ -520,7 +1282,7 @@ namespace Isonia::Pipeline
 
         VkFence* m_images_in_flight;
         VkImage* m_depth_images;
-        VkDeviceMemory* m_depth_image_memorys;
+        MemoryAllocation* m_depth_image_allocations;
         VkImageView* m_depth_image_views;
         VkImage* m_swap_chain_images;
         VkFramebuffer* m_swap_chain_framebuffers;
@@ -558,6 +1320,9 @@ namespace Isonia::Pipeline
         VkExtent2D getExtent() const;
         bool isFrameInProgress() const;
         VkCommandBuffer getCurrentCommandBuffer() const;
+        CommandRecorder* getCommandRecorder();
+        // counts of the last finished recording
+        const CommandRecorderStats* getCommandStats() const;
         int getFrameIndex() const;
 
         VkCommandBuffer beginFrame();
@@ -581,6 +1346,8 @@ namespace Isonia::Pipeline
         void* m_user_data[4];
 
         bool m_is_frame_started = false;
+        // reset with the command buffer each frame, bound state does not outlive it
+        CommandRecorder m_command_recorder;
 
         unsigned int m_current_frame = 0;
     };
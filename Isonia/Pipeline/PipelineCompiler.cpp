@@ -0,0 +1,91 @@
+// internal
+#include "Pipeline.h"
+
+// external
+#include <iostream>
+
+namespace Isonia::Pipeline
+{
+	PipelineCompiler::PipelineCompiler(Device* device)
+		: m_device{ device }
+	{
+		m_worker_count = Math::clampui(std::thread::hardware_concurrency(), 1u, max_workers);
+		m_workers = new std::thread[m_worker_count];
+		for (unsigned int i = 0u; i < m_worker_count; i++)
+		{
+			m_workers[i] = std::thread(&PipelineCompiler::workerLoop, this);
+		}
+	}
+
+	PipelineCompiler::~PipelineCompiler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_condition.notify_all();
+		for (unsigned int i = 0u; i < m_worker_count; i++)
+		{
+			m_workers[i].join();
+		}
+		delete[] m_workers;
+	}
+
+	void PipelineCompiler::enqueue(Pipeline* pipeline)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_queue_head == nullptr && m_active_jobs == 0u)
+			{
+				m_batch_start = std::chrono::high_resolution_clock::now();
+			}
+
+			pipeline->m_next_job = nullptr;
+			if (m_queue_tail == nullptr)
+			{
+				m_queue_head = pipeline;
+			}
+			else
+			{
+				m_queue_tail->m_next_job = pipeline;
+			}
+			m_queue_tail = pipeline;
+		}
+		m_condition.notify_one();
+	}
+
+	void PipelineCompiler::workerLoop()
+	{
+		ISONIA_PROFILE_THREAD("Pipeline Compiler");
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true)
+		{
+			m_condition.wait(lock, [this] { return m_stop || m_queue_head != nullptr; });
+			if (m_queue_head == nullptr)
+			{
+				return;
+			}
+
+			Pipeline* pipeline = m_queue_head;
+			m_queue_head = pipeline->m_next_job;
+			if (m_queue_head == nullptr)
+			{
+				m_queue_tail = nullptr;
+			}
+			m_active_jobs++;
+
+			lock.unlock();
+			pipeline->build();
+			lock.lock();
+
+			// pipeline may be destroyed by its owner from here on
+			m_active_jobs--;
+			if (m_queue_head == nullptr && m_active_jobs == 0u)
+			{
+				const PipelineCacheStats stats = m_device->getPipelineCacheStats();
+				const double wall_time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_batch_start).count();
+				std::cout << "Pipelines: " << stats.pipeline_count << " built in " << wall_time_ms << " ms on " << m_worker_count << " threads, " << stats.creation_time_us / 1000.0 << " ms compiling" << (stats.loaded_bytes == 0 ? " (cold cache)" : " (warm cache)") << '\n';
+			}
+		}
+	}
+}
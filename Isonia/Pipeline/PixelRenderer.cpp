@@ -7,7 +7,7 @@
 namespace Isonia::Pipeline
 {
 	PixelRenderer::PixelRenderer(Window* window, Device* device)
-		: m_window(window), m_device(device)
+		: m_window(window), m_device(device), m_parallel_recorder(device), m_gpu_timer(device)
 	{
 		recreateSwapChain();
 		createCommandBuffers();
@@ -62,6 +62,37 @@ namespace Isonia::Pipeline
 		return m_command_buffers[m_current_frame];
 	}
 
+	CommandRecorder* PixelRenderer::getCommandRecorder()
+	{
+		assert(m_is_frame_started && "Cannot get command recorder when frame not in progress");
+		return &m_command_recorder;
+	}
+
+	const FrameWorkloadStats* PixelRenderer::getWorkloadStats() const
+	{
+		return &m_workload_stats;
+	}
+
+	const FrameWorkloadStats* PixelRenderer::getWorkloadTotals() const
+	{
+		return &m_workload_totals;
+	}
+
+	unsigned int PixelRenderer::getFinishedFrameCount() const
+	{
+		return m_finished_frame_count;
+	}
+
+	float PixelRenderer::getGpuFrameTime() const
+	{
+		return m_gpu_timer.getStats()->milliseconds[RenderScopes::frame];
+	}
+
+	GpuTimer* PixelRenderer::getGpuTimer()
+	{
+		return &m_gpu_timer;
+	}
+
 	int PixelRenderer::getFrameIndex() const
 	{
 		assert(m_is_frame_started && "Cannot get frame index when frame not in progress");
@@ -75,6 +106,7 @@ namespace Isonia::Pipeline
 
 	VkCommandBuffer PixelRenderer::beginFrame()
 	{
+		ISONIA_PROFILE_FUNCTION();
 		assert(!m_is_frame_started && "Can't call beginFrame while already in progress");
 
 		VkResult result = m_pixel_swap_chain->acquireNextImage(&m_current_frame);
@@ -90,6 +122,7 @@ namespace Isonia::Pipeline
 		}
 
 		m_is_frame_started = true;
+		m_device->beginFrame(m_current_frame, m_pixel_swap_chain->getImageInFlightFence(m_current_frame));
 
 		VkCommandBuffer command_buffer = getCurrentCommandBuffer();
 		VkCommandBufferBeginInfo begin_info{};
@@ -99,18 +132,30 @@ namespace Isonia::Pipeline
 		{
 			throw std::runtime_error("Failed to begin recording command buffer!");
 		}
+		m_command_recorder.begin(command_buffer);
+
+		m_gpu_timer.beginFrame(command_buffer, m_current_frame);
+		m_frame_query = m_gpu_timer.begin(command_buffer, RenderScopes::frame);
 		return command_buffer;
 	}
 
 	void PixelRenderer::endFrame()
 	{
+		ISONIA_PROFILE_FUNCTION();
 		assert(m_is_frame_started && "Can't call endFrame while frame is not in progress");
 		VkCommandBuffer command_buffer = getCurrentCommandBuffer();
+		m_gpu_timer.end(command_buffer, m_frame_query);
+		m_gpu_timer.endFrame();
 		if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to record command buffer!");
 		}
 
+		m_device->getUniformRing()->flush();
+
+		// uploads recorded since the last frame go first on the queue
+		m_device->getUploadContext()->submit();
+
 		VkResult result = m_pixel_swap_chain->submitCommandBuffers(&command_buffer, &m_current_frame);
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window->m_resized)
 		{
@@ -123,11 +168,25 @@ namespace Isonia::Pipeline
 			throw std::runtime_error("Failed to present swap chain image!");
 		}
 
+		m_device->endFrame();
+
+		m_workload_stats.total = *m_command_recorder.getStats();
+		CommandRecorder::addStats(&m_workload_totals.total, &m_workload_stats.total);
+		for (unsigned int i = 0u; i < RenderScopes::count; i++)
+		{
+			m_workload_stats.scopes[i] = *m_command_recorder.getScopeStats(i);
+			CommandRecorder::addStats(&m_workload_totals.scopes[i], &m_workload_stats.scopes[i]);
+		}
+		m_workload_stats.transfers = m_device->getTransferStats();
+		m_workload_totals.transfers.buffer_bytes_uploaded += m_workload_stats.transfers.buffer_bytes_uploaded;
+		m_workload_totals.transfers.image_bytes_copied += m_workload_stats.transfers.image_bytes_copied;
+		m_finished_frame_count++;
+
 		m_is_frame_started = false;
 		m_current_frame = (m_current_frame + 1) % m_pixel_swap_chain->getImageCount();
 	}
 
-	void PixelRenderer::beginSwapChainRenderPass(VkCommandBuffer command_buffer, unsigned int render_pass_index)
+	void PixelRenderer::beginSwapChainRenderPass(VkCommandBuffer command_buffer, unsigned int render_pass_index, VkSubpassContents contents)
 	{
 		assert(m_is_frame_started && "Can't call begin SwapChainRenderPass if frame is not in progress");
 		assert(command_buffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame");
@@ -154,7 +213,12 @@ namespace Isonia::Pipeline
 		render_pass_info.clearValueCount = clear_values_count;
 		render_pass_info.pClearValues = clear_values;
 
-		vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(command_buffer, &render_pass_info, contents);
+		if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+		{
+			// secondaries set their own dynamic state
+			return;
+		}
 
 		VkViewport viewport{
 			.x = 0.0f,
@@ -169,6 +233,18 @@ namespace Isonia::Pipeline
 		vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 	}
 
+	ParallelRecorder* PixelRenderer::beginParallelRenderPass(VkCommandBuffer command_buffer, unsigned int render_pass_index, void* frame_data)
+	{
+		beginSwapChainRenderPass(command_buffer, render_pass_index, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		m_parallel_recorder.begin(
+			m_pixel_swap_chain->getRenderPass(render_pass_index),
+			m_pixel_swap_chain->getFrameBuffer(m_current_frame),
+			m_pixel_swap_chain->getRenderExtent(),
+			frame_data
+		);
+		return &m_parallel_recorder;
+	}
+
 	void PixelRenderer::endSwapChainRenderPass(VkCommandBuffer command_buffer)
 	{
 		assert(m_is_frame_started && "Can't call endPixelSwapChainRenderPass if frame is not in progress");
@@ -179,15 +255,7 @@ namespace Isonia::Pipeline
 
 	void PixelRenderer::blit(VkCommandBuffer command_buffer, Math::Vector2 offset)
 	{
-		// The common subresource thingies
-		VkImageSubresourceRange subresource_range{
-			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-			.baseMipLevel = 0,
-			.levelCount = 1,
-			.baseArrayLayer = 0,
-			.layerCount = 1
-		};
-
+		// expects the color image in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL and the swapchain image in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
 		VkImageSubresourceLayers subresource{
 			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
 			.mipLevel = 0,
@@ -195,26 +263,6 @@ namespace Isonia::Pipeline
 			.layerCount = 1
 		};
 
-		// Transfer the swapchain image to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, so we can blit to it
-		VkImageMemoryBarrier clear_barrier{
-			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-			.pNext = nullptr,
-			.srcAccessMask = 0,
-			.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-			.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-			.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.image = m_pixel_swap_chain->getSwapChainImage(m_current_frame),
-			.subresourceRange = subresource_range
-		};
-
-		vkCmdPipelineBarrier(
-			command_buffer,
-			VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-			0, 0, nullptr, 0, nullptr, 1, &clear_barrier
-		);
-
 		// Calculate pixel offsets
 		const float scale_factor = Math::pixels_per_unit * static_cast<float>(m_render_factor);
 		const int offset_x = Math::roundf_i(offset.x * scale_factor);
@@ -253,192 +301,6 @@ namespace Isonia::Pipeline
 		);
 
 		// "Blit" the remaining renderFactor * 2 border using compute shader bc of hardware limitations of blit
-
-		// Transfer to the presentation layout
-		VkImageMemoryBarrier present_barrier{
-			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-			.pNext = nullptr,
-			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-			.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
-			.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.image = m_pixel_swap_chain->getSwapChainImage(m_current_frame),
-			.subresourceRange = subresource_range
-		};
-
-		vkCmdPipelineBarrier(
-			command_buffer,
-			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-			0, 0, nullptr, 0, nullptr, 1, &present_barrier
-		);
-	}
-
-	void PixelRenderer::copyToIntermediates(VkCommandBuffer command_buffer)
-	{
-		// The common subresource thingies for color
-		VkImageSubresourceRange color_subresource_range{
-			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-			.baseMipLevel = 0,
-			.levelCount = 1,
-			.baseArrayLayer = 0,
-			.layerCount = 1
-		};
-
-		VkImageSubresourceLayers color_subresource{
-			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-			.mipLevel = 0,
-			.baseArrayLayer = 0,
-			.layerCount = 1
-		};
-
-		// The common subresource thingies for depth
-		VkImageSubresourceRange depth_subresource_range{
-			.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
-			.baseMipLevel = 0,
-			.levelCount = 1,
-			.baseArrayLayer = 0,
-			.layerCount = 1
-		};
-
-		VkImageSubresourceLayers depth_subresource{
-			.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
-			.mipLevel = 0,
-			.baseArrayLayer = 0,
-			.layerCount = 1
-		};
-
-		// Transfer the intermediate color image to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, so we can copy to it
-		VkImageMemoryBarrier clear_color_barrier{
-			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-			.pNext = nullptr,
-			.srcAccessMask = 0,
-			.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-			.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.image = m_pixel_swap_chain->getIntermediateImage(m_current_frame),
-			.subresourceRange = color_subresource_range
-		};
-
-		// Transfer the intermediate depth image to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, so we can copy to it
-		VkImageMemoryBarrier clear_depth_barrier{
-			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-			.pNext = nullptr,
-			.srcAccessMask = 0,
-			.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-			.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
-			.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.image = m_pixel_swap_chain->getIntermediateDepthImage(m_current_frame),
-			.subresourceRange = depth_subresource_range
-		};
-
-		// Pipeline barriers for color and depth
-		vkCmdPipelineBarrier(
-			command_buffer,
-			VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-			0, 0, nullptr, 0, nullptr, 1, &clear_color_barrier
-		);
-
-		vkCmdPipelineBarrier(
-			command_buffer,
-			VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-			0, 0, nullptr, 0, nullptr, 1, &clear_depth_barrier
-		);
-
-		// Set up the copy region for color
-		VkImageCopy color_copy_region{
-			.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
-			.srcOffset = { 0, 0, 0 },
-			.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
-			.dstOffset = { 0, 0, 0 },
-			.extent = {
-				m_pixel_swap_chain->getRenderWidth(),
-				m_pixel_swap_chain->getRenderHeight(),
-				1
-			}
-		};
-
-		// Set up the copy region for depth
-		VkImageCopy depth_copy_region{
-			.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 },
-			.srcOffset = { 0, 0, 0 },
-			.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 },
-			.dstOffset = { 0, 0, 0 },
-			.extent = {
-				m_pixel_swap_chain->getRenderWidth(),
-				m_pixel_swap_chain->getRenderHeight(),
-				1
-			}
-		};
-
-		// Perform the copy operation for color
-		vkCmdCopyImage(
-			command_buffer,
-			m_pixel_swap_chain->getImage(m_current_frame),
-			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-			m_pixel_swap_chain->getIntermediateImage(m_current_frame),
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1, &color_copy_region
-		);
-
-		// Perform the copy operation for depth
-		vkCmdCopyImage(
-			command_buffer,
-			m_pixel_swap_chain->getDepthImage(m_current_frame),
-			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-			m_pixel_swap_chain->getIntermediateDepthImage(m_current_frame),
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1, &depth_copy_region
-		);
-
-		// Transfer the intermediate color image to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		VkImageMemoryBarrier present_color_barrier{
-			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-			.pNext = nullptr,
-			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-			.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
-			.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.image = m_pixel_swap_chain->getIntermediateImage(m_current_frame),
-			.subresourceRange = color_subresource_range
-		};
-
-		// Transfer the intermediate depth image to VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-		VkImageMemoryBarrier present_depth_barrier{
-			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-			.pNext = nullptr,
-			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-			.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
-			.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
-			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.image = m_pixel_swap_chain->getIntermediateDepthImage(m_current_frame),
-			.subresourceRange = depth_subresource_range
-		};
-
-		// Pipeline barriers for color and depth to presentation layout
-		vkCmdPipelineBarrier(
-			command_buffer,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-			0, 0, nullptr, 0, nullptr, 1, &present_color_barrier
-		);
-
-		vkCmdPipelineBarrier(
-			command_buffer,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-			0, 0, nullptr, 0, nullptr, 1, &present_depth_barrier
-		);
 	}
 
 	void PixelRenderer::createCommandBuffers()
@@ -2,6 +2,7 @@
 #include "Pipeline.h"
 
 // external
+#include <cassert>
 #include <stdexcept>
 #include <iostream>
 
@@ -32,28 +33,21 @@ namespace Isonia::Pipeline
 		{
 			PixelSwapChainResourceSet* resource = &m_resource_set[i];
 			vkDestroyImageView(m_device->getDevice(), resource->m_swap_chain_image_view, nullptr);
+			if (m_device->isHeadless())
+			{
+				m_device->destroyImage(resource->m_swap_chain_image, &resource->m_swap_chain_image_allocation);
+			}
 
 			vkDestroyImageView(m_device->getDevice(), resource->m_color_image_view, nullptr);
-			vkDestroyImage(m_device->getDevice(), resource->m_color_image, nullptr);
-			vkFreeMemory(m_device->getDevice(), resource->m_color_image_memory, nullptr);
+			m_device->destroyImage(resource->m_color_image, &resource->m_color_image_allocation);
 
 			vkDestroyImageView(m_device->getDevice(), resource->m_depth_image_view, nullptr);
-			vkDestroyImage(m_device->getDevice(), resource->m_depth_image, nullptr);
-			vkFreeMemory(m_device->getDevice(), resource->m_depth_image_memory, nullptr);
+			m_device->destroyImage(resource->m_depth_image, &resource->m_depth_image_allocation);
+			vkDestroySampler(m_device->getDevice(), resource->m_depth_sampler, nullptr);
 		
 			vkDestroySemaphore(m_device->getDevice(), resource->m_render_finished_semaphore, nullptr);
 			vkDestroySemaphore(m_device->getDevice(), resource->m_image_available_semaphore, nullptr);
 			vkDestroyFence(m_device->getDevice(), resource->m_in_flight_fence, nullptr);
-		
-			vkDestroyImageView(m_device->getDevice(), resource->m_color_image_view_intermediate, nullptr);
-			vkDestroyImage(m_device->getDevice(), resource->m_color_image_intermediate, nullptr);
-			vkFreeMemory(m_device->getDevice(), resource->m_color_image_memory_intermediate, nullptr);
-			vkDestroySampler(m_device->getDevice(), resource->m_color_sampler_intermediate, nullptr);
-		
-			vkDestroyImageView(m_device->getDevice(), resource->m_depth_image_view_intermediate, nullptr);
-			vkDestroyImage(m_device->getDevice(), resource->m_depth_image_intermediate, nullptr);
-			vkFreeMemory(m_device->getDevice(), resource->m_depth_image_memory_intermediate, nullptr);
-			vkDestroySampler(m_device->getDevice(), resource->m_depth_sampler_intermediate, nullptr);
 		}
 
 		for (unsigned int i = 0; i < m_render_pass_count; i++)
@@ -78,6 +72,10 @@ namespace Isonia::Pipeline
 	{
 		return m_image_count;
 	}
+	VkFence PixelSwapChain::getImageInFlightFence(int index) const
+	{
+		return m_resource_set[index].m_image_in_flight;
+	}
 	VkImage PixelSwapChain::getSwapChainImage(int index) const
 	{
 		return m_resource_set[index].m_swap_chain_image;
@@ -90,21 +88,24 @@ namespace Isonia::Pipeline
 	{
 		return m_resource_set[index].m_depth_image;
 	}
-	VkImage PixelSwapChain::getIntermediateImage(int index) const
+	const VkDescriptorImageInfo* PixelSwapChain::getDepthImageInfo(int index) const
 	{
-		return m_resource_set[index].m_color_image_intermediate;
+		return &m_resource_set[index].m_depth_descriptor;
 	}
-	const VkDescriptorImageInfo* PixelSwapChain::getIntermediateImageInfo(int index) const
+	VkImageAspectFlags PixelSwapChain::getDepthAspect() const
 	{
-		return &m_resource_set[index].m_color_descriptor_intermediate;
+		// barriers on combined formats have to cover the stencil too
+		return m_swap_chain_depth_format == VK_FORMAT_D32_SFLOAT ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
 	}
-	VkImage PixelSwapChain::getIntermediateDepthImage(int index) const
+	VkImageLayout PixelSwapChain::getPresentLayout() const
 	{
-		return m_resource_set[index].m_depth_image_intermediate;
+		// headless frames are read back instead of presented
+		return m_device->isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 	}
-	const VkDescriptorImageInfo* PixelSwapChain::getIntermediateDepthImageInfo(int index) const
+	VkPipelineStageFlags PixelSwapChain::getImageAvailableStage() const
 	{
-		return &m_resource_set[index].m_depth_descriptor_intermediate;
+		// the stage the submit waits on the acquire semaphore at, offscreen only the last read back is ahead
+		return m_device->isHeadless() ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 	}
 	
 	VkFramebuffer PixelSwapChain::getFrameBuffer(int index) const
@@ -162,12 +163,13 @@ namespace Isonia::Pipeline
 			candidates,
 			3u,
 			VK_IMAGE_TILING_OPTIMAL,
-			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
 		);
 	}
 
 	VkResult PixelSwapChain::acquireNextImage(unsigned int* image_index)
 	{
+		ISONIA_PROFILE_FUNCTION();
 		vkWaitForFences(
 			m_device->getDevice(),
 			1,
@@ -176,6 +178,14 @@ namespace Isonia::Pipeline
 			Math::unsigned_long_max
 		);
 
+		if (m_device->isHeadless())
+		{
+			// offscreen images are taken in turn, the fence above keeps the next one from being in flight
+			*image_index = m_next_offscreen_image;
+			m_next_offscreen_image = (m_next_offscreen_image + 1u) % m_image_count;
+			return VK_SUCCESS;
+		}
+
 		VkResult result = vkAcquireNextImageKHR(
 			m_device->getDevice(),
 			m_swap_chain,
@@ -190,18 +200,22 @@ namespace Isonia::Pipeline
 
 	VkResult PixelSwapChain::submitCommandBuffers(const VkCommandBuffer* buffers, unsigned int* image_index)
 	{
+		ISONIA_PROFILE_FUNCTION();
 		if (m_resource_set[*image_index].m_image_in_flight != nullptr)
 		{
 			vkWaitForFences(m_device->getDevice(), 1, &m_resource_set[*image_index].m_image_in_flight, VK_TRUE, UINT64_MAX);
 		}
 		m_resource_set[*image_index].m_image_in_flight = m_current_resource_set->m_in_flight_fence;
 
+		// nothing is acquired or presented offscreen
+		const bool is_headless = m_device->isHeadless();
+
 		VkSubmitInfo submit_info = {};
 		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
 		VkSemaphore wait_semaphores[] = { m_current_resource_set->m_image_available_semaphore };
 		VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submit_info.waitSemaphoreCount = 1;
+		submit_info.waitSemaphoreCount = is_headless ? 0 : 1;
 		submit_info.pWaitSemaphores = wait_semaphores;
 		submit_info.pWaitDstStageMask = wait_stages;
 
@@ -209,7 +223,7 @@ namespace Isonia::Pipeline
 		submit_info.pCommandBuffers = buffers;
 
 		VkSemaphore signal_semaphores[] = { m_current_resource_set->m_render_finished_semaphore };
-		submit_info.signalSemaphoreCount = 1;
+		submit_info.signalSemaphoreCount = is_headless ? 0 : 1;
 		submit_info.pSignalSemaphores = signal_semaphores;
 
 		vkResetFences(m_device->getDevice(), 1, &m_current_resource_set->m_in_flight_fence);
@@ -219,6 +233,11 @@ namespace Isonia::Pipeline
 			throw std::runtime_error("Failed to submit draw command buffer!");
 		}
 
+		if (is_headless)
+		{
+			return VK_SUCCESS;
+		}
+
 		VkPresentInfoKHR present_info = {};
 		present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -234,6 +253,69 @@ namespace Isonia::Pipeline
 		return vkQueuePresentKHR(m_device->getPresentQueue(), &present_info);
 	}
 
+	void PixelSwapChain::readSwapChainImage(int index, unsigned char* out_rgb)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		assert(m_device->isHeadless() && "Only offscreen swap chain images can be read back");
+
+		const unsigned int pixel_count = m_swap_chain_extent.width * m_swap_chain_extent.height;
+		VkBuffer staging_buffer;
+		MemoryAllocation staging_allocation;
+		m_device->createBuffer(
+			static_cast<VkDeviceSize>(pixel_count) * 4u,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			&staging_buffer,
+			&staging_allocation,
+			ResourceCategories::staging
+		);
+
+		VkCommandBuffer command_buffer = m_device->beginSingleTimeCommands();
+
+		// the frame's blit was submitted earlier on the same queue, its final barrier made nothing visible
+		VkImageMemoryBarrier image_barrier{};
+		image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		image_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		image_barrier.oldLayout = getPresentLayout();
+		image_barrier.newLayout = getPresentLayout();
+		image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		image_barrier.image = m_resource_set[index].m_swap_chain_image;
+		image_barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &image_barrier);
+
+		VkBufferImageCopy region{};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = { m_swap_chain_extent.width, m_swap_chain_extent.height, 1 };
+		vkCmdCopyImageToBuffer(command_buffer, m_resource_set[index].m_swap_chain_image, getPresentLayout(), staging_buffer, 1, &region);
+		m_device->trackTransfer(0, static_cast<VkDeviceSize>(pixel_count) * 4u);
+
+		VkBufferMemoryBarrier buffer_barrier{};
+		buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		buffer_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		buffer_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		buffer_barrier.buffer = staging_buffer;
+		buffer_barrier.offset = 0;
+		buffer_barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &buffer_barrier, 0, nullptr);
+
+		m_device->endSingleTimeCommands(command_buffer);
+
+		// offscreen images are always bgra
+		const unsigned char* bgra = static_cast<const unsigned char*>(staging_allocation.mapped);
+		for (unsigned int i = 0; i < pixel_count; i++)
+		{
+			out_rgb[i * 3u + 0u] = bgra[i * 4u + 2u];
+			out_rgb[i * 3u + 1u] = bgra[i * 4u + 1u];
+			out_rgb[i * 3u + 2u] = bgra[i * 4u + 0u];
+		}
+
+		m_device->destroyBuffer(staging_buffer, &staging_allocation);
+	}
+
 	bool PixelSwapChain::compareSwapFormats(const PixelSwapChain* swap_chain) const
 	{
 		return swap_chain->m_swap_chain_depth_format == m_swap_chain_depth_format && swap_chain->m_swap_chain_image_format == m_swap_chain_image_format;
@@ -241,15 +323,21 @@ namespace Isonia::Pipeline
 
 	void PixelSwapChain::init()
 	{
-		createPixelSwapChain();
+		if (m_device->isHeadless())
+		{
+			createOffscreenImages();
+		}
+		else
+		{
+			createPixelSwapChain();
+		}
 		createImageViews();
 		createRenderPass();
 		createColorResources();
 		createDepthResources();
 		createFramebuffers();
 		createSyncObjects();
-		createColorIntermediates();
-		createDepthIntermediates();
+		createDepthSamplers();
 	}
 
 	void PixelSwapChain::createPixelSwapChain()
@@ -337,6 +425,50 @@ namespace Isonia::Pipeline
 		free(m_swap_chain_images);
 	}
 
+	void PixelSwapChain::createOffscreenImages()
+	{
+		// stand ins for the presentable images, at the window's extent so the blit is the same
+		m_image_count = max_frames_in_flight;
+		m_swap_chain_image_format = VK_FORMAT_B8G8R8A8_SRGB;
+		m_swap_chain_extent = m_window_extent;
+
+		for (unsigned int i = 0; i < m_image_count; i++)
+		{
+			VkImageCreateInfo image_info{};
+			image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			image_info.imageType = VK_IMAGE_TYPE_2D;
+			image_info.extent.width = m_swap_chain_extent.width;
+			image_info.extent.height = m_swap_chain_extent.height;
+			image_info.extent.depth = 1;
+			image_info.mipLevels = 1;
+			image_info.arrayLayers = 1;
+			image_info.format = m_swap_chain_image_format;
+			image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+			image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+			image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			image_info.flags = 0;
+
+			m_device->createImageWithInfo(
+				&image_info,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				&m_resource_set[i].m_swap_chain_image,
+				&m_resource_set[i].m_swap_chain_image_allocation,
+				ResourceCategories::swap_chain
+			);
+
+			m_device->transitionImageLayout(
+				m_resource_set[i].m_swap_chain_image,
+				m_swap_chain_image_format,
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				getPresentLayout(),
+				1,
+				1
+			);
+		}
+	}
+
 	void PixelSwapChain::createImageViews()
 	{
 		for (unsigned int i = 0; i < m_image_count; i++)
@@ -368,8 +500,9 @@ namespace Isonia::Pipeline
 		depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depth_attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		// the frame's render graph moves the attachments in and out of these layouts
+		depth_attachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 		VkAttachmentReference depth_attachment_ref{};
 		depth_attachment_ref.attachment = 1;
@@ -382,8 +515,8 @@ namespace Isonia::Pipeline
 		color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 		color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		color_attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		color_attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		color_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 		VkAttachmentReference color_attachment_ref = {};
 		color_attachment_ref.attachment = 0;
@@ -418,11 +551,14 @@ namespace Isonia::Pipeline
 			throw std::runtime_error("Failed to create render pass!");
 		}
 
+		// the water samples the depth while testing against it, so the depth stays read only and is dropped afterwards
 		VkAttachmentDescription load_attachments[attachments_length] = { color_attachment, depth_attachment };
 		load_attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-		load_attachments[0].initialLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 		load_attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-		load_attachments[1].initialLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		load_attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		load_attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		load_attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		depth_attachment_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 		render_pass_info.pAttachments = load_attachments;
 		if (vkCreateRenderPass(m_device->getDevice(), &render_pass_info, nullptr, &m_render_passes[1].m_render_pass) != VK_SUCCESS)
 		{
@@ -480,7 +616,8 @@ namespace Isonia::Pipeline
 				&image_info,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 				&m_resource_set[i].m_color_image,
-				&m_resource_set[i].m_color_image_memory
+				&m_resource_set[i].m_color_image_allocation,
+				ResourceCategories::swap_chain
 			);
 
 			VkImageViewCreateInfo view_info{};
@@ -517,7 +654,7 @@ namespace Isonia::Pipeline
 			image_info.format = m_swap_chain_depth_format;
 			image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
 			image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
 			image_info.samples = VK_SAMPLE_COUNT_1_BIT;
 			image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 			image_info.flags = 0;
@@ -526,7 +663,8 @@ namespace Isonia::Pipeline
 				&image_info,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 				&m_resource_set[i].m_depth_image,
-				&m_resource_set[i].m_depth_image_memory
+				&m_resource_set[i].m_depth_image_allocation,
+				ResourceCategories::swap_chain
 			);
 
 			VkImageViewCreateInfo view_info{};
@@ -567,157 +705,8 @@ namespace Isonia::Pipeline
 		}
 	}
 
-	void PixelSwapChain::createColorIntermediates()
+	void PixelSwapChain::createDepthSamplers()
 	{
-		for (unsigned int i = 0; i < m_image_count; i++)
-		{
-			VkImageCreateInfo image_info{};
-			image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-			image_info.imageType = VK_IMAGE_TYPE_2D;
-			image_info.extent.width = getRenderWidth();
-			image_info.extent.height = getRenderHeight();
-			image_info.extent.depth = 1;
-			image_info.mipLevels = 1;
-			image_info.arrayLayers = 1;
-			image_info.format = m_swap_chain_color_format;
-			image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
-			image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-			image_info.samples = VK_SAMPLE_COUNT_1_BIT;
-			image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-			image_info.flags = 0;
-
-			m_device->createImageWithInfo(
-				&image_info,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				&m_resource_set[i].m_color_image_intermediate,
-				&m_resource_set[i].m_color_image_memory_intermediate
-			);
-
-			VkImageViewCreateInfo view_info{};
-			view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			view_info.image = m_resource_set[i].m_color_image_intermediate;
-			view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-			view_info.format = m_swap_chain_color_format;
-			view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			view_info.subresourceRange.baseMipLevel = 0;
-			view_info.subresourceRange.levelCount = 1;
-			view_info.subresourceRange.baseArrayLayer = 0;
-			view_info.subresourceRange.layerCount = 1;
-
-			if (vkCreateImageView(m_device->getDevice(), &view_info, nullptr, &m_resource_set[i].m_color_image_view_intermediate) != VK_SUCCESS)
-			{
-				throw std::runtime_error("Failed to create texture image view!");
-			}
-		}
-
-		// Transition swap chain images to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL because render pipeline expects it
-		for (unsigned int i = 0; i < m_image_count; i++)
-		{
-			m_device->transitionImageLayout(
-				m_resource_set[i].m_color_image_intermediate,
-				m_swap_chain_image_format,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-				1,
-				1
-			);
-		}
-
-		// samplers
-		VkSamplerCreateInfo sampler_info{};
-		sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		sampler_info.magFilter = VK_FILTER_NEAREST;
-		sampler_info.minFilter = VK_FILTER_NEAREST;
-		sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-		sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-		sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-		sampler_info.anisotropyEnable = VK_FALSE;
-		sampler_info.maxAnisotropy = 1.0f;
-		sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-		sampler_info.unnormalizedCoordinates = VK_FALSE;
-		sampler_info.compareEnable = VK_FALSE;
-		sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
-		sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-		sampler_info.mipLodBias = 0.0f;
-		sampler_info.minLod = 0.0f;
-		sampler_info.maxLod = 0.0f;
-
-		for (unsigned int i = 0; i < m_image_count; i++)
-		{
-			if (vkCreateSampler(m_device->getDevice(), &sampler_info, nullptr, &m_resource_set[i].m_color_sampler_intermediate) != VK_SUCCESS)
-			{
-				throw std::runtime_error("Failed to create samplers!");
-			}
-		}
-
-		// descriptors
-		for (unsigned int i = 0; i < m_image_count; i++)
-		{
-			m_resource_set[i].m_color_descriptor_intermediate.sampler = m_resource_set[i].m_color_sampler_intermediate;
-			m_resource_set[i].m_color_descriptor_intermediate.imageView = m_resource_set[i].m_color_image_view_intermediate;
-			m_resource_set[i].m_color_descriptor_intermediate.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		}
-	}
-
-	void PixelSwapChain::createDepthIntermediates()
-	{
-		for (unsigned int i = 0; i < m_image_count; i++)
-		{
-			VkImageCreateInfo image_info{};
-			image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-			image_info.imageType = VK_IMAGE_TYPE_2D;
-			image_info.extent.width = getRenderWidth();
-			image_info.extent.height = getRenderHeight();
-			image_info.extent.depth = 1;
-			image_info.mipLevels = 1;
-			image_info.arrayLayers = 1;
-			image_info.format = m_swap_chain_depth_format;
-			image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
-			image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-			image_info.samples = VK_SAMPLE_COUNT_1_BIT;
-			image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-			image_info.flags = 0;
-
-			m_device->createImageWithInfo(
-				&image_info,
-				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				&m_resource_set[i].m_depth_image_intermediate,
-				&m_resource_set[i].m_depth_image_memory_intermediate
-			);
-
-			VkImageViewCreateInfo view_info{};
-			view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-			view_info.image = m_resource_set[i].m_depth_image_intermediate;
-			view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-			view_info.format = m_swap_chain_depth_format;
-			view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-			view_info.subresourceRange.baseMipLevel = 0;
-			view_info.subresourceRange.levelCount = 1;
-			view_info.subresourceRange.baseArrayLayer = 0;
-			view_info.subresourceRange.layerCount = 1;
-
-			if (vkCreateImageView(m_device->getDevice(), &view_info, nullptr, &m_resource_set[i].m_depth_image_view_intermediate) != VK_SUCCESS)
-			{
-				throw std::runtime_error("Failed to create texture image view!");
-			}
-		}
-
-		// Transition swap chain images to VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL because render pipeline expects it
-		for (unsigned int i = 0; i < m_image_count; i++)
-		{
-			m_device->transitionImageLayout(
-				m_resource_set[i].m_depth_image_intermediate,
-				m_swap_chain_depth_format,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
-				1,
-				1
-			);
-		}
-
-		// samplers
 		VkSamplerCreateInfo sampler_info{};
 		sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
 		sampler_info.magFilter = VK_FILTER_NEAREST;
@@ -738,18 +727,18 @@ namespace Isonia::Pipeline
 
 		for (unsigned int i = 0; i < m_image_count; i++)
 		{
-			if (vkCreateSampler(m_device->getDevice(), &sampler_info, nullptr, &m_resource_set[i].m_depth_sampler_intermediate) != VK_SUCCESS)
+			if (vkCreateSampler(m_device->getDevice(), &sampler_info, nullptr, &m_resource_set[i].m_depth_sampler) != VK_SUCCESS)
 			{
 				throw std::runtime_error("Failed to create samplers!");
 			}
 		}
 
-		// descriptors
+		// sampled in place during the second render pass, no copy of the depth attachment is made
 		for (unsigned int i = 0; i < m_image_count; i++)
 		{
-			m_resource_set[i].m_depth_descriptor_intermediate.sampler = m_resource_set[i].m_depth_sampler_intermediate;
-			m_resource_set[i].m_depth_descriptor_intermediate.imageView = m_resource_set[i].m_depth_image_view_intermediate;
-			m_resource_set[i].m_depth_descriptor_intermediate.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			m_resource_set[i].m_depth_descriptor.sampler = m_resource_set[i].m_depth_sampler;
+			m_resource_set[i].m_depth_descriptor.imageView = m_resource_set[i].m_depth_image_view;
+			m_resource_set[i].m_depth_descriptor.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 		}
 	}
 
@@ -0,0 +1,299 @@
+// internal
+#include "Pipeline.h"
+
+// external
+#include <cassert>
+
+namespace Isonia::Pipeline
+{
+	struct RenderGraphUsageInfo
+	{
+		VkPipelineStageFlags stages;
+		VkAccessFlags read_access;
+		VkAccessFlags write_access;
+		VkImageLayout layout;
+	};
+
+	static const constexpr RenderGraphUsageInfo usage_infos[RenderGraphUsages::count] = {
+		{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL },
+		{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL },
+		{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, 0, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL },
+		{ VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL },
+		{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT, 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL },
+		{ VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, 0, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL },
+		{ VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL }
+	};
+
+	RenderGraph::RenderGraph()
+	{
+	}
+
+	unsigned int RenderGraph::importImage(const char* name, VkImageAspectFlags aspect, VkImageLayout initial_layout, VkImageLayout final_layout, VkPipelineStageFlags initial_stages)
+	{
+		assert(!m_is_compiled && "Cannot import images into a compiled render graph");
+		assert(m_resources_count < max_resources && "Too many render graph resources");
+
+		Resource* resource = &m_resources[m_resources_count];
+		resource->name = name;
+		resource->aspect = aspect;
+		resource->initial_layout = initial_layout;
+		resource->final_layout = final_layout;
+		resource->initial_stages = initial_stages;
+		resource->image = nullptr;
+		resource->is_output = false;
+		return m_resources_count++;
+	}
+
+	void RenderGraph::markOutput(unsigned int resource)
+	{
+		assert(resource < m_resources_count && "Render graph resource does not exist");
+		m_resources[resource].is_output = true;
+	}
+
+	unsigned int RenderGraph::addPass(const char* name, PassCallback callback, void* user_data)
+	{
+		assert(!m_is_compiled && "Cannot add passes to a compiled render graph");
+		assert(m_passes_count < max_passes && "Too many render graph passes");
+
+		Pass* pass = &m_passes[m_passes_count];
+		pass->name = name;
+		pass->callback = callback;
+		pass->user_data = user_data;
+		pass->accesses_count = 0u;
+		pass->is_culled = false;
+		return m_passes_count++;
+	}
+
+	RenderGraph* RenderGraph::read(unsigned int pass, unsigned int resource, unsigned int usage)
+	{
+		return addAccess(pass, resource, usage, false, false);
+	}
+
+	RenderGraph* RenderGraph::write(unsigned int pass, unsigned int resource, unsigned int usage, bool discard)
+	{
+		return addAccess(pass, resource, usage, true, discard);
+	}
+
+	RenderGraph* RenderGraph::addAccess(unsigned int pass, unsigned int resource, unsigned int usage, bool is_write, bool is_discard)
+	{
+		assert(!m_is_compiled && "Cannot add accesses to a compiled render graph");
+		assert(pass < m_passes_count && "Render graph pass does not exist");
+		assert(resource < m_resources_count && "Render graph resource does not exist");
+		assert(usage < RenderGraphUsages::count && "Unknown render graph usage");
+		assert((usage_infos[usage].write_access != 0) == is_write && "Render graph usage does not match the access");
+
+		Pass* target = &m_passes[pass];
+		assert(target->accesses_count < max_pass_accesses && "Too many accesses in one render graph pass");
+		for (unsigned int i = 0u; i < target->accesses_count; i++)
+		{
+			assert(target->accesses[i].resource != resource && "A render graph pass can only access a resource once");
+		}
+
+		// writes that load the previous contents read them as well
+		Access* access = &target->accesses[target->accesses_count++];
+		access->resource = resource;
+		access->stages = usage_infos[usage].stages;
+		access->access = is_discard ? usage_infos[usage].write_access : usage_infos[usage].read_access | usage_infos[usage].write_access;
+		access->write_access = usage_infos[usage].write_access;
+		access->layout = usage_infos[usage].layout;
+		access->is_write = is_write;
+		access->is_discard = is_discard;
+		return this;
+	}
+
+	void RenderGraph::compile()
+	{
+		// walk backwards from the outputs, a pass survives when something still needs one of its writes
+		bool needed[max_resources];
+		for (unsigned int r = 0u; r < m_resources_count; r++)
+		{
+			needed[r] = m_resources[r].is_output;
+		}
+
+		for (unsigned int p = m_passes_count; p-- > 0u;)
+		{
+			Pass* pass = &m_passes[p];
+			pass->is_culled = true;
+			for (unsigned int a = 0u; a < pass->accesses_count; a++)
+			{
+				if (pass->accesses[a].is_write && needed[pass->accesses[a].resource])
+				{
+					pass->is_culled = false;
+				}
+			}
+
+			if (pass->is_culled)
+			{
+				continue;
+			}
+
+			// a discarded write hides every earlier write, anything else keeps its producers alive
+			for (unsigned int a = 0u; a < pass->accesses_count; a++)
+			{
+				needed[pass->accesses[a].resource] = !pass->accesses[a].is_discard;
+			}
+		}
+
+		m_is_compiled = true;
+	}
+
+	void RenderGraph::setImage(unsigned int resource, VkImage image)
+	{
+		assert(resource < m_resources_count && "Render graph resource does not exist");
+		m_resources[resource].image = image;
+	}
+
+	void RenderGraph::execute(VkCommandBuffer command_buffer, void* frame_data)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		assert(m_is_compiled && "Cannot execute a render graph before compiling it");
+
+		for (unsigned int r = 0u; r < m_resources_count; r++)
+		{
+			Resource* resource = &m_resources[r];
+			resource->layout = resource->initial_layout;
+			resource->write_stages = resource->initial_stages;
+			resource->write_access = 0;
+			resource->read_stages = 0;
+			// whatever came before the frame is already visible, only ordering against the initial stages remains
+			resource->synced_stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		}
+		m_barrier_count = 0u;
+
+		VkImageMemoryBarrier barriers[max_resources];
+		for (unsigned int p = 0u; p < m_passes_count; p++)
+		{
+			const Pass* pass = &m_passes[p];
+			if (pass->is_culled)
+			{
+				continue;
+			}
+
+			// one batched barrier in front of each pass
+			unsigned int barriers_count = 0u;
+			VkPipelineStageFlags src_stages = 0;
+			VkPipelineStageFlags dst_stages = 0;
+			for (unsigned int a = 0u; a < pass->accesses_count; a++)
+			{
+				if (resolveAccess(&pass->accesses[a], &barriers[barriers_count], &src_stages, &dst_stages))
+				{
+					barriers_count++;
+				}
+			}
+
+			if (barriers_count != 0u)
+			{
+				vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0, 0, nullptr, 0, nullptr, barriers_count, barriers);
+				m_barrier_count += barriers_count;
+			}
+
+			{
+				// pass names are literals, they outlive the trace
+				ISONIA_PROFILE_ZONE(pass->name);
+				pass->callback(command_buffer, pass->user_data, frame_data);
+			}
+		}
+
+		// hand imported images back in the layout their owner expects
+		unsigned int barriers_count = 0u;
+		VkPipelineStageFlags src_stages = 0;
+		for (unsigned int r = 0u; r < m_resources_count; r++)
+		{
+			Resource* resource = &m_resources[r];
+			if (resource->final_layout == VK_IMAGE_LAYOUT_UNDEFINED || resource->final_layout == resource->layout)
+			{
+				continue;
+			}
+
+			const VkPipelineStageFlags wait_stages = resource->write_stages | resource->read_stages;
+			VkImageMemoryBarrier* barrier = &barriers[barriers_count++];
+			*barrier = {};
+			barrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier->srcAccessMask = resource->write_access;
+			barrier->dstAccessMask = 0;
+			barrier->oldLayout = resource->layout;
+			barrier->newLayout = resource->final_layout;
+			barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier->image = resource->image;
+			barrier->subresourceRange = { resource->aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+			src_stages |= wait_stages != 0 ? wait_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		}
+
+		if (barriers_count != 0u)
+		{
+			vkCmdPipelineBarrier(command_buffer, src_stages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, barriers_count, barriers);
+			m_barrier_count += barriers_count;
+		}
+	}
+
+	bool RenderGraph::isCulled(unsigned int pass) const
+	{
+		assert(pass < m_passes_count && "Render graph pass does not exist");
+		return m_passes[pass].is_culled;
+	}
+
+	unsigned int RenderGraph::getBarrierCount() const
+	{
+		return m_barrier_count;
+	}
+
+	bool RenderGraph::resolveAccess(const Access* access, VkImageMemoryBarrier* barrier, VkPipelineStageFlags* src_stages, VkPipelineStageFlags* dst_stages)
+	{
+		Resource* resource = &m_resources[access->resource];
+		assert(resource->image != nullptr && "Render graph image was not set for this frame");
+
+		const bool is_transition = resource->layout != access->layout;
+		VkPipelineStageFlags wait_stages;
+		if (is_transition || access->is_write)
+		{
+			// layout changes and writes wait on every earlier access, reads only for ordering
+			wait_stages = resource->write_stages | resource->read_stages;
+			if (!is_transition && wait_stages == 0)
+			{
+				resource->write_stages = access->stages;
+				resource->write_access = access->write_access;
+				resource->synced_stages = access->stages;
+				return false;
+			}
+		}
+		else
+		{
+			// a read in the current layout only waits when the last write is not yet visible to its stages
+			resource->read_stages |= access->stages;
+			if (resource->write_stages == 0 || (access->stages & ~resource->synced_stages) == 0)
+			{
+				return false;
+			}
+			wait_stages = resource->write_stages;
+		}
+
+		*barrier = {};
+		barrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier->srcAccessMask = resource->write_access;
+		barrier->dstAccessMask = access->access;
+		barrier->oldLayout = access->is_discard ? VK_IMAGE_LAYOUT_UNDEFINED : resource->layout;
+		barrier->newLayout = access->layout;
+		barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier->image = resource->image;
+		barrier->subresourceRange = { resource->aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+		*src_stages |= wait_stages != 0 ? wait_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		*dst_stages |= access->stages;
+
+		if (is_transition || access->is_write)
+		{
+			// a layout transition counts as a write that the access's stages have already waited on
+			resource->layout = access->layout;
+			resource->write_stages = access->stages;
+			resource->write_access = access->write_access;
+			resource->read_stages = access->is_write ? 0 : access->stages;
+			resource->synced_stages = access->stages;
+		}
+		else
+		{
+			resource->synced_stages |= access->stages;
+		}
+		return true;
+	}
+}
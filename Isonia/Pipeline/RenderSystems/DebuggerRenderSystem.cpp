@@ -3,6 +3,7 @@
 
 // shaders
 #include "../../Shaders/Include/Billboard/FragShader_frag.h"
+#include "../../Shaders/Include/Billboard/FragShaderBindless_frag.h"
 #include "../../Shaders/Include/Billboard/VertexShader_vert.h"
 #include "../../Shaders/Include/Billboard/GeomShader_geom.h"
 
@@ -11,8 +12,8 @@
 
 namespace Isonia::Pipeline::RenderSystems
 {
-	DebuggerRenderSystem::DebuggerRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout debugger_set_layout)
-		: m_device(device)
+	DebuggerRenderSystem::DebuggerRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout debugger_set_layout, const unsigned int texture_index)
+		: m_device(device), m_texture_index(texture_index)
 	{
 		createPipelineLayout(global_set_layout, debugger_set_layout);
 		createPipeline(render_pass);
@@ -30,21 +31,18 @@ namespace Isonia::Pipeline::RenderSystems
 
 	void DebuggerRenderSystem::render(const VkDescriptorSet* debugger_descriptor_set, const State::FrameInfo* frame_info)
 	{
-		m_pipeline->bind(frame_info->command_buffer);
+		ISONIA_PROFILE_FUNCTION();
+		m_pipeline->bind(frame_info->recorder);
 
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
+		frame_info->recorder->bindDescriptorSets(
 			m_pipeline_layout,
 			0u,
 			1u,
 			&frame_info->global_descriptor_set,
-			0u,
-			nullptr
+			State::FrameInfo::global_dynamic_offsets_count,
+			frame_info->global_dynamic_offsets
 		);
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
+		frame_info->recorder->bindDescriptorSets(
 			m_pipeline_layout,
 			1u,
 			1u,
@@ -52,9 +50,19 @@ namespace Isonia::Pipeline::RenderSystems
 			0u,
 			nullptr
 		);
+		if (m_texture_index != Descriptors::TextureHeap::invalid_index)
+		{
+			frame_info->recorder->pushConstants(
+				m_pipeline_layout,
+				VK_SHADER_STAGE_FRAGMENT_BIT,
+				0u,
+				sizeof(unsigned int),
+				&m_texture_index
+			);
+		}
 
-		m_debugger->bind(frame_info->command_buffer);
-		m_debugger->draw(frame_info->command_buffer);
+		m_debugger->bind(frame_info->recorder);
+		m_debugger->draw(frame_info->recorder);
 	}
 
 	void DebuggerRenderSystem::createPipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout debugger_set_layout)
@@ -65,12 +73,18 @@ namespace Isonia::Pipeline::RenderSystems
 			debugger_set_layout
 		};
 
+		VkPushConstantRange push_constant_range{};
+		push_constant_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		push_constant_range.offset = 0;
+		push_constant_range.size = sizeof(unsigned int);
+
+		const bool is_bindless = m_texture_index != Descriptors::TextureHeap::invalid_index;
 		VkPipelineLayoutCreateInfo pipeline_layout_info{};
 		pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipeline_layout_info.setLayoutCount = descriptor_set_layouts_length;
 		pipeline_layout_info.pSetLayouts = descriptor_set_layouts;
-		pipeline_layout_info.pushConstantRangeCount = 0;
-		pipeline_layout_info.pPushConstantRanges = nullptr;
+		pipeline_layout_info.pushConstantRangeCount = is_bindless ? 1 : 0;
+		pipeline_layout_info.pPushConstantRanges = is_bindless ? &push_constant_range : nullptr;
 		if (vkCreatePipelineLayout(m_device->getDevice(), &pipeline_layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create pipeline layout!");
@@ -81,6 +95,7 @@ namespace Isonia::Pipeline::RenderSystems
 	{
 		assert(m_pipeline_layout != nullptr && "Cannot create pipeline before a pipeline layout is instantiated");
 
+		const bool is_bindless = m_texture_index != Descriptors::TextureHeap::invalid_index;
 		PipelineConfigInfo pipeline_config{};
 		pixelPipelinePointListConfigInfo(&pipeline_config);
 		pipeline_config.render_pass = render_pass;
@@ -96,8 +111,8 @@ namespace Isonia::Pipeline::RenderSystems
 				sizeof(Shaders::Billboard::VERTEXSHADER_VERT) / sizeof(unsigned char)
 			)->addShaderModule(
 				VK_SHADER_STAGE_FRAGMENT_BIT,
-				Shaders::Billboard::FRAGSHADER_FRAG,
-				sizeof(Shaders::Billboard::FRAGSHADER_FRAG) / sizeof(unsigned char)
+				is_bindless ? Shaders::Billboard::FRAGSHADERBINDLESS_FRAG : Shaders::Billboard::FRAGSHADER_FRAG,
+				is_bindless ? sizeof(Shaders::Billboard::FRAGSHADERBINDLESS_FRAG) / sizeof(unsigned char) : sizeof(Shaders::Billboard::FRAGSHADER_FRAG) / sizeof(unsigned char)
 			)->createGraphicsPipeline(&pipeline_config);
 	}
 
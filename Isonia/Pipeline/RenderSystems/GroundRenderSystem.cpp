@@ -19,10 +19,8 @@ namespace Isonia::Pipeline::RenderSystems
 	GroundRenderSystem::GroundRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout ground_set_layout, const VkDescriptorSetLayout weather_set_layout, const unsigned int quad_side_count, const float quad_size, const float density)
 		: m_device(device), m_quad_side_count(quad_side_count), m_quad_size(quad_size), m_density(density)
 	{
-		createGroundPipelineLayout(global_set_layout, ground_set_layout, weather_set_layout);
+		createPipelineLayout(global_set_layout, ground_set_layout, weather_set_layout);
 		createGroundPipeline(render_pass);
-
-		createGrassPipelineLayout(global_set_layout, ground_set_layout, weather_set_layout);
 		createGrassPipeline(render_pass);
 	}
 
@@ -30,8 +28,7 @@ namespace Isonia::Pipeline::RenderSystems
 	{
 		delete m_ground_pipeline;
 		delete m_grass_pipeline;
-		vkDestroyPipelineLayout(m_device->getDevice(), m_ground_pipeline_layout, nullptr);
-		vkDestroyPipelineLayout(m_device->getDevice(), m_grass_pipeline_layout, nullptr);
+		vkDestroyPipelineLayout(m_device->getDevice(), m_pipeline_layout, nullptr);
 
 		for (unsigned int x = 0; x < grounds; x++)
 		{
@@ -92,6 +89,7 @@ namespace Isonia::Pipeline::RenderSystems
 
 	void GroundRenderSystem::frustumCull(const Camera* camera)
 	{
+		ISONIA_PROFILE_FUNCTION();
 		const Math::Plane plane{
 			Math::Vector3{0.0f, 0.0f, 0.0f},
 			Math::Vector3{0.0f, -1.0f, 0.0f}
@@ -190,38 +188,38 @@ namespace Isonia::Pipeline::RenderSystems
 	void GroundRenderSystem::render(const VkDescriptorSet* ground_descriptor_set, const VkDescriptorSet* weather_descriptor_set, const State::FrameInfo* frame_info, const Camera* camera)
 	{
 		frustumCull(camera);
-		renderGround(ground_descriptor_set, weather_descriptor_set, frame_info);
-		renderGrass(ground_descriptor_set, weather_descriptor_set, frame_info);
+		renderGround(ground_descriptor_set, weather_descriptor_set, frame_info, 0u, grounds_count);
+		renderGrass(ground_descriptor_set, weather_descriptor_set, frame_info, 0u, grounds_count);
 	}
 
-	void GroundRenderSystem::renderGround(const VkDescriptorSet* ground_descriptor_set, const VkDescriptorSet* weather_descriptor_set, const State::FrameInfo* frame_info)
+	unsigned int GroundRenderSystem::getChunkCount() const
 	{
-		m_ground_pipeline->bind(frame_info->command_buffer);
+		return grounds_count;
+	}
 
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_ground_pipeline_layout,
+	void GroundRenderSystem::renderGround(const VkDescriptorSet* ground_descriptor_set, const VkDescriptorSet* weather_descriptor_set, const State::FrameInfo* frame_info, const unsigned int first_chunk, const unsigned int last_chunk)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		m_ground_pipeline->bind(frame_info->recorder);
+
+		frame_info->recorder->bindDescriptorSets(
+			m_pipeline_layout,
 			0u,
 			1u,
 			&frame_info->global_descriptor_set,
-			0u,
-			nullptr
+			State::FrameInfo::global_dynamic_offsets_count,
+			frame_info->global_dynamic_offsets
 		);
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_ground_pipeline_layout,
+		frame_info->recorder->bindDescriptorSets(
+			m_pipeline_layout,
 			1u,
 			1u,
 			ground_descriptor_set,
 			0u,
 			nullptr
 		);
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_ground_pipeline_layout,
+		frame_info->recorder->bindDescriptorSets(
+			m_pipeline_layout,
 			2u,
 			1u,
 			weather_descriptor_set,
@@ -229,58 +227,49 @@ namespace Isonia::Pipeline::RenderSystems
 			nullptr
 		);
 
-		for (unsigned int x = 0; x < grounds; x++)
+		for (unsigned int chunk = first_chunk; chunk < last_chunk; chunk++)
 		{
-			for (unsigned int z = 0; z < grounds; z++)
+			Renderable::BuilderXZUniformN* ground = m_grounds[chunk / grounds][chunk % grounds];
+			if (ground == nullptr || ground->m_culled)
 			{
-				Renderable::BuilderXZUniformN* ground = m_grounds[x][z];
-				if (ground == nullptr || ground->m_culled)
-				{
-					continue;
-				}
-
-				vkCmdPushConstants(
-					frame_info->command_buffer,
-					m_ground_pipeline_layout,
-					VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-					0,
-					sizeof(Math::Vector2),
-					&(ground->m_positional_data)
-				);
-				ground->bind(frame_info->command_buffer);
-				ground->draw(frame_info->command_buffer);
+				continue;
 			}
+
+			frame_info->recorder->pushConstants(
+				m_pipeline_layout,
+				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+				0,
+				sizeof(Math::Vector2),
+				&(ground->m_positional_data)
+			);
+			ground->bind(frame_info->recorder);
+			ground->draw(frame_info->recorder);
 		}
 	}
 
-	void GroundRenderSystem::renderGrass(const VkDescriptorSet* ground_descriptor_set, const VkDescriptorSet* weather_descriptor_set, const State::FrameInfo* frame_info)
+	void GroundRenderSystem::renderGrass(const VkDescriptorSet* ground_descriptor_set, const VkDescriptorSet* weather_descriptor_set, const State::FrameInfo* frame_info, const unsigned int first_chunk, const unsigned int last_chunk)
 	{
-		m_grass_pipeline->bind(frame_info->command_buffer);
+		ISONIA_PROFILE_FUNCTION();
+		m_grass_pipeline->bind(frame_info->recorder);
 
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_grass_pipeline_layout,
+		frame_info->recorder->bindDescriptorSets(
+			m_pipeline_layout,
 			0u,
 			1u,
 			&frame_info->global_descriptor_set,
-			0u,
-			nullptr
+			State::FrameInfo::global_dynamic_offsets_count,
+			frame_info->global_dynamic_offsets
 		);
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_grass_pipeline_layout,
+		frame_info->recorder->bindDescriptorSets(
+			m_pipeline_layout,
 			1u,
 			1u,
 			ground_descriptor_set,
 			0u,
 			nullptr
 		);
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			m_grass_pipeline_layout,
+		frame_info->recorder->bindDescriptorSets(
+			m_pipeline_layout,
 			2u,
 			1u,
 			weather_descriptor_set,
@@ -288,24 +277,22 @@ namespace Isonia::Pipeline::RenderSystems
 			nullptr
 		);
 
-		for (unsigned int x = 0; x < grounds; x++)
+		for (unsigned int chunk = first_chunk; chunk < last_chunk; chunk++)
 		{
-			for (unsigned int z = 0; z < grounds; z++)
+			Renderable::BuilderXZUniformNP* grass = m_grasses[chunk / grounds][chunk % grounds];
+			if (grass == nullptr || grass->m_culled)
 			{
-				Renderable::BuilderXZUniformNP* grass = m_grasses[x][z];
-				if (grass == nullptr || grass->m_culled)
-				{
-					continue;
-				}
-
-				grass->bind(frame_info->command_buffer);
-				grass->draw(frame_info->command_buffer);
+				continue;
 			}
+
+			grass->bind(frame_info->recorder);
+			grass->draw(frame_info->recorder);
 		}
 	}
 
-	void GroundRenderSystem::createGroundPipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout ground_set_layout, const VkDescriptorSetLayout weather_set_layout)
+	void GroundRenderSystem::createPipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout ground_set_layout, const VkDescriptorSetLayout weather_set_layout)
 	{
+		// shared by ground and grass so the grass pass can keep the ground pass's descriptor sets, grass ignores the push constant
 		VkPushConstantRange push_constant_range{};
 		push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 		push_constant_range.offset = 0;
@@ -324,7 +311,7 @@ namespace Isonia::Pipeline::RenderSystems
 		pipeline_layout_info.pSetLayouts = descriptor_set_layouts;
 		pipeline_layout_info.pushConstantRangeCount = 1;
 		pipeline_layout_info.pPushConstantRanges = &push_constant_range;
-		if (vkCreatePipelineLayout(m_device->getDevice(), &pipeline_layout_info, nullptr, &m_ground_pipeline_layout) != VK_SUCCESS)
+		if (vkCreatePipelineLayout(m_device->getDevice(), &pipeline_layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create pipeline layout!");
 		}
@@ -332,12 +319,12 @@ namespace Isonia::Pipeline::RenderSystems
 
 	void GroundRenderSystem::createGroundPipeline(const VkRenderPass render_pass)
 	{
-		assert(m_ground_pipeline_layout != nullptr && "Cannot create pipeline before a pipeline layout is instantiated");
+		assert(m_pipeline_layout != nullptr && "Cannot create pipeline before a pipeline layout is instantiated");
 
 		PipelineConfigInfo pipeline_config{};
 		Pipeline::pixelPipelineTriangleStripNormalConfigInfo(&pipeline_config);
 		pipeline_config.render_pass = render_pass;
-		pipeline_config.pipeline_layout = m_ground_pipeline_layout;
+		pipeline_config.pipeline_layout = m_pipeline_layout;
 		m_ground_pipeline = (new Pipeline(m_device, 2u))
 			->addShaderModule(
 				VK_SHADER_STAGE_VERTEX_BIT,
@@ -350,35 +337,14 @@ namespace Isonia::Pipeline::RenderSystems
 			)->createGraphicsPipeline(&pipeline_config);
 	}
 
-	void GroundRenderSystem::createGrassPipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout ground_set_layout, const VkDescriptorSetLayout weather_set_layout)
-	{
-		const constexpr unsigned int descriptor_set_layouts_length = 3;
-		const VkDescriptorSetLayout descriptor_set_layouts[descriptor_set_layouts_length]{
-			global_set_layout,
-			ground_set_layout,
-			weather_set_layout
-		};
-
-		VkPipelineLayoutCreateInfo pipeline_layout_info{};
-		pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipeline_layout_info.setLayoutCount = descriptor_set_layouts_length;
-		pipeline_layout_info.pSetLayouts = descriptor_set_layouts;
-		pipeline_layout_info.pushConstantRangeCount = 0;
-		pipeline_layout_info.pPushConstantRanges = nullptr;
-		if (vkCreatePipelineLayout(m_device->getDevice(), &pipeline_layout_info, nullptr, &m_grass_pipeline_layout) != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to create pipeline layout!");
-		}
-	}
-
 	void GroundRenderSystem::createGrassPipeline(const VkRenderPass render_pass)
 	{
-		assert(m_grass_pipeline_layout != nullptr && "Cannot create pipeline before a pipeline layout is instantiated");
+		assert(m_pipeline_layout != nullptr && "Cannot create pipeline before a pipeline layout is instantiated");
 
 		PipelineConfigInfo pipeline_config{};
 		pixelPipelinePointListConfigInfo(&pipeline_config);
 		pipeline_config.render_pass = render_pass;
-		pipeline_config.pipeline_layout = m_grass_pipeline_layout;
+		pipeline_config.pipeline_layout = m_pipeline_layout;
 		m_grass_pipeline = (new Pipeline(m_device, 3u))
 			->addShaderModule(
 				VK_SHADER_STAGE_GEOMETRY_BIT,
@@ -2,6 +2,7 @@
 
 // internal
 #include "../Pipeline.h"
+#include "../Descriptors/Descriptors.h"
 #include "../../State/State.h"
 #include "../../Renderable/Renderable.h"
 
@@ -13,7 +14,8 @@ namespace Isonia::Pipeline::RenderSystems
 	struct DebuggerRenderSystem
 	{
 	public:
-		DebuggerRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout debugger_set_layout);
+		// with a texture heap index the debugger set layout is the heap's and the texture is picked by push constant
+		DebuggerRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout debugger_set_layout, const unsigned int texture_index = Descriptors::TextureHeap::invalid_index);
 		~DebuggerRenderSystem();
 
 		DebuggerRenderSystem() = delete;
@@ -34,6 +36,7 @@ namespace Isonia::Pipeline::RenderSystems
 		VkPipelineLayout m_pipeline_layout;
 
 		Renderable::BuilderPosition* m_debugger;
+		const unsigned int m_texture_index;
 	};
 
 	struct GroundRenderSystem
@@ -56,15 +59,16 @@ namespace Isonia::Pipeline::RenderSystems
 
 		void render(const VkDescriptorSet* ground_descriptor_set, const VkDescriptorSet* weather_descriptor_set, const State::FrameInfo* frame_info, const Camera* camera);
 
-	private:
+		// for recording chunk ranges on separate threads, cull once before any range is rendered
+		unsigned int getChunkCount() const;
 		void frustumCull(const Camera* camera);
+		void renderGround(const VkDescriptorSet* ground_descriptor_set, const VkDescriptorSet* weather_descriptor_set, const State::FrameInfo* frame_info, const unsigned int first_chunk, const unsigned int last_chunk);
+		void renderGrass(const VkDescriptorSet* ground_descriptor_set, const VkDescriptorSet* weather_descriptor_set, const State::FrameInfo* frame_info, const unsigned int first_chunk, const unsigned int last_chunk);
 
-		void renderGround(const VkDescriptorSet* ground_descriptor_set, const VkDescriptorSet* weather_descriptor_set, const State::FrameInfo* frame_info);
-		void renderGrass(const VkDescriptorSet* ground_descriptor_set, const VkDescriptorSet* weather_descriptor_set, const State::FrameInfo* frame_info);
+	private:
 
-		void createGroundPipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout ground_set_layout, const VkDescriptorSetLayout weather_set_layout);
+		void createPipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout ground_set_layout, const VkDescriptorSetLayout weather_set_layout);
 		void createGroundPipeline(const VkRenderPass render_pass);
-		void createGrassPipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout ground_set_layout, const VkDescriptorSetLayout weather_set_layout);
 		void createGrassPipeline(const VkRenderPass render_pass);
 
 		static void pixelPipelinePointListConfigInfo(PipelineConfigInfo* config_info);
@@ -73,8 +77,7 @@ namespace Isonia::Pipeline::RenderSystems
 
 		Pipeline* m_ground_pipeline;
 		Pipeline* m_grass_pipeline;
-		VkPipelineLayout m_ground_pipeline_layout;
-		VkPipelineLayout m_grass_pipeline_layout;
+		VkPipelineLayout m_pipeline_layout;
 
 		const unsigned int m_quad_side_count;
 		const float m_quad_size;
@@ -93,17 +96,18 @@ namespace Isonia::Pipeline::RenderSystems
 	struct WaterRenderSystem
 	{
 	public:
-		WaterRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout global_swapchain_set_layout, const VkDescriptorSetLayout water_set_layout);
+		WaterRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout global_swapchain_set_layout, const VkDescriptorSetLayout palettes_set_layout);
 		~WaterRenderSystem();
 
 		WaterRenderSystem() = delete;
 		WaterRenderSystem(const WaterRenderSystem&) = delete;
 		WaterRenderSystem& operator=(const WaterRenderSystem&) = delete;
 
-		void render(const VkDescriptorSet* water_descriptor_set, const State::FrameInfo* frame_info, const Camera* camera);
+		// the palettes are read from binding 0 of a set shared with the ground
+		void render(const VkDescriptorSet* palettes_descriptor_set, const State::FrameInfo* frame_info, const Camera* camera);
 
 	private:
-		void createpipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout global_swapchain_set_layout, const VkDescriptorSetLayout water_set_layout);
+		void createpipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout global_swapchain_set_layout, const VkDescriptorSetLayout palettes_set_layout);
 		void createpipeline(const VkRenderPass render_pass);
 
 		Device* m_device;
@@ -117,14 +121,15 @@ namespace Isonia::Pipeline::RenderSystems
 	struct UIRenderSystem
 	{
 	public:
-		UIRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout text_set_layout, const Renderable::Font* font, const unsigned int max_text_length);
+		// with a texture heap index the text set layout is the heap's and the font is picked by push constant
+		UIRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout text_set_layout, const Renderable::Font* font, const unsigned int max_text_length, const unsigned int texture_index = Descriptors::TextureHeap::invalid_index);
 		~UIRenderSystem();
 
 		UIRenderSystem() = delete;
 		UIRenderSystem(const UIRenderSystem&) = delete;
 		UIRenderSystem& operator=(const UIRenderSystem&) = delete;
 
-		void update(const VkExtent2D extent, const char* text);
+		void update(const VkExtent2D extent, const char* text, const ResourceStats* resource_stats = nullptr, const FrameWorkloadStats* workload_stats = nullptr, const GpuTimingStats* gpu_timing_stats = nullptr);
 
 		void render(const VkDescriptorSet* text_descriptor_set, const State::FrameInfo* frame_info, const Camera* camera);
 
@@ -140,5 +145,8 @@ namespace Isonia::Pipeline::RenderSystems
 		VkPipelineLayout m_pipeline_layout;
 
 		Renderable::BuilderUI* m_ui;
+		unsigned int m_max_text_length;
+		char* m_text;
+		const unsigned int m_texture_index;
 	};
 }
@@ -3,15 +3,24 @@
 
 // shaders
 #include "../../Shaders/Include/UI/FragShader_frag.h"
+#include "../../Shaders/Include/UI/FragShaderBindless_frag.h"
 #include "../../Shaders/Include/UI/VertexShader_vert.h"
 
 // external
+#include <cstdio>
+#include <cstdlib>
 #include <stdexcept>
 
 namespace Isonia::Pipeline::RenderSystems
 {
-	UIRenderSystem::UIRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout text_set_layout, const Renderable::Font* font, const unsigned int max_text_length)
-		: m_device(device), m_ui(nullptr)
+	// snprintf returns the length it wanted, once the text is full every later append only rewrites the terminator
+	static int clampTextLength(const int length, const unsigned int max_text_length)
+	{
+		return length < static_cast<int>(max_text_length) ? length : static_cast<int>(max_text_length) - 1;
+	}
+
+	UIRenderSystem::UIRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout text_set_layout, const Renderable::Font* font, const unsigned int max_text_length, const unsigned int texture_index)
+		: m_device(device), m_ui(nullptr), m_max_text_length(max_text_length), m_text(static_cast<char*>(malloc(max_text_length * sizeof(char)))), m_texture_index(texture_index)
 	{
 		createPipelineLayout(global_set_layout, text_set_layout);
 		createPipeline(render_pass);
@@ -25,30 +34,103 @@ namespace Isonia::Pipeline::RenderSystems
 		vkDestroyPipelineLayout(m_device->getDevice(), m_pipeline_layout, nullptr);
 
 		delete m_ui;
+		free(m_text);
 	}
 
-	void UIRenderSystem::update(const VkExtent2D extent, const char* text)
+	void UIRenderSystem::update(const VkExtent2D extent, const char* text, const ResourceStats* resource_stats, const FrameWorkloadStats* workload_stats, const GpuTimingStats* gpu_timing_stats)
 	{
-		m_ui->update(extent, text);
+		ISONIA_PROFILE_FUNCTION();
+		if (resource_stats == nullptr && workload_stats == nullptr && gpu_timing_stats == nullptr)
+		{
+			m_ui->update(extent, text);
+			return;
+		}
+
+		// formatted into a buffer owned by the system, the overlay is rebuilt every frame it is shown
+		int length = clampTextLength(snprintf(m_text, m_max_text_length, "%s\n", text), m_max_text_length);
+		if (gpu_timing_stats != nullptr)
+		{
+			for (unsigned int i = 0u; i < RenderScopes::count; i++)
+			{
+				length = clampTextLength(length + snprintf(m_text + length, m_max_text_length - length, "\nGPU %s: %.3f ms", RenderScopes::names[i], gpu_timing_stats->milliseconds[i]), m_max_text_length);
+			}
+			length = clampTextLength(length + snprintf(m_text + length, m_max_text_length - length, "\n"), m_max_text_length);
+		}
+		if (workload_stats != nullptr)
+		{
+			constexpr const double kibibyte = 1024.0;
+			const CommandRecorderStats* total = &workload_stats->total;
+			for (unsigned int i = 0u; i < CommandTypes::count; i++)
+			{
+				length = clampTextLength(length + snprintf(m_text + length, m_max_text_length - length, "\n%s: %u issued %u elided", CommandTypes::names[i], total->issued[i], total->elided[i]), m_max_text_length);
+			}
+			length = clampTextLength(length + snprintf(
+				m_text + length,
+				m_max_text_length - length,
+				"\nVertices: %llu Instances: %llu Push Constants: %llu B\nUploaded: %.2f KiB Image Copies: %.2f KiB\n",
+				total->vertices, total->instances, total->push_constant_bytes,
+				workload_stats->transfers.buffer_bytes_uploaded / kibibyte, workload_stats->transfers.image_bytes_copied / kibibyte
+			), m_max_text_length);
+
+			// only the scopes jobs were recorded for
+			for (unsigned int i = 0u; i < RenderScopes::count; i++)
+			{
+				const CommandRecorderStats* scope = &workload_stats->scopes[i];
+				if (scope->issued[CommandTypes::draw] == 0u)
+				{
+					continue;
+				}
+				length = clampTextLength(length + snprintf(
+					m_text + length,
+					m_max_text_length - length,
+					"\n%s: %u draws %llu vertices %u pipelines %u sets %llu B push",
+					RenderScopes::names[i], scope->issued[CommandTypes::draw], scope->vertices,
+					scope->issued[CommandTypes::pipeline], scope->issued[CommandTypes::descriptor_sets], scope->push_constant_bytes
+				), m_max_text_length);
+			}
+		}
+		if (resource_stats == nullptr)
+		{
+			m_ui->update(extent, m_text);
+			return;
+		}
+
+		constexpr const double mebibyte = 1024.0 * 1024.0;
+		length = clampTextLength(length + snprintf(m_text + length, m_max_text_length - length, "\n"), m_max_text_length);
+		for (unsigned int i = 0u; i < ResourceCategories::count; i++)
+		{
+			const ResourceCounter* counter = &resource_stats->categories[i];
+			length = clampTextLength(length + snprintf(m_text + length, m_max_text_length - length, "\n%s: %u (%u) %.2f MiB (%.2f MiB)", ResourceCategories::names[i], counter->count, counter->peak_count, counter->bytes / mebibyte, counter->peak_bytes / mebibyte), m_max_text_length);
+		}
+		length = clampTextLength(length + snprintf(
+			m_text + length,
+			m_max_text_length - length,
+			"\nBuffers: %u (%u) Images: %u (%u)\nDescriptor Sets: %u (%u) Pipelines: %u (%u)\nDevice Memory: %u (%u) %.2f / %.2f MiB (%.2f MiB)",
+			resource_stats->buffers.count, resource_stats->buffers.peak_count,
+			resource_stats->images.count, resource_stats->images.peak_count,
+			resource_stats->descriptor_sets.count, resource_stats->descriptor_sets.peak_count,
+			resource_stats->pipelines.count, resource_stats->pipelines.peak_count,
+			resource_stats->memory.device_memory_count, resource_stats->memory.peak_device_memory_count,
+			resource_stats->memory.used_bytes / mebibyte, resource_stats->memory.reserved_bytes / mebibyte, resource_stats->memory.peak_reserved_bytes / mebibyte
+		), m_max_text_length);
+
+		m_ui->update(extent, m_text);
 	}
 
 	void UIRenderSystem::render(const VkDescriptorSet* text_descriptor_set, const State::FrameInfo* frame_info, const Camera* camera)
 	{
-		m_pipeline->bind(frame_info->command_buffer);
+		ISONIA_PROFILE_FUNCTION();
+		m_pipeline->bind(frame_info->recorder);
 
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
+		frame_info->recorder->bindDescriptorSets(
 			m_pipeline_layout,
 			0u,
 			1u,
 			&frame_info->global_descriptor_set,
-			0u,
-			nullptr
+			State::FrameInfo::global_dynamic_offsets_count,
+			frame_info->global_dynamic_offsets
 		);
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
+		frame_info->recorder->bindDescriptorSets(
 			m_pipeline_layout,
 			1u,
 			1u,
@@ -56,9 +138,19 @@ namespace Isonia::Pipeline::RenderSystems
 			0u,
 			nullptr
 		);
+		if (m_texture_index != Descriptors::TextureHeap::invalid_index)
+		{
+			frame_info->recorder->pushConstants(
+				m_pipeline_layout,
+				VK_SHADER_STAGE_FRAGMENT_BIT,
+				0u,
+				sizeof(unsigned int),
+				&m_texture_index
+			);
+		}
 
-		m_ui->bind(frame_info->command_buffer);
-		m_ui->draw(frame_info->command_buffer);
+		m_ui->bind(frame_info->recorder);
+		m_ui->draw(frame_info->recorder);
 	}
 
 	void UIRenderSystem::createPipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout text_set_layout)
@@ -69,12 +161,18 @@ namespace Isonia::Pipeline::RenderSystems
 			text_set_layout
 		};
 
+		VkPushConstantRange push_constant_range{};
+		push_constant_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		push_constant_range.offset = 0;
+		push_constant_range.size = sizeof(unsigned int);
+
+		const bool is_bindless = m_texture_index != Descriptors::TextureHeap::invalid_index;
 		VkPipelineLayoutCreateInfo pipeline_layout_info{};
 		pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipeline_layout_info.setLayoutCount = descriptor_set_layouts_length;
 		pipeline_layout_info.pSetLayouts = descriptor_set_layouts;
-		pipeline_layout_info.pushConstantRangeCount = 0;
-		pipeline_layout_info.pPushConstantRanges = nullptr;
+		pipeline_layout_info.pushConstantRangeCount = is_bindless ? 1 : 0;
+		pipeline_layout_info.pPushConstantRanges = is_bindless ? &push_constant_range : nullptr;
 		if (vkCreatePipelineLayout(m_device->getDevice(), &pipeline_layout_info, nullptr, &m_pipeline_layout) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create pipeline layout!");
@@ -85,6 +183,7 @@ namespace Isonia::Pipeline::RenderSystems
 	{
 		assert(m_pipeline_layout != nullptr && "Cannot create pipeline before a pipeline layout is instantiated");
 
+		const bool is_bindless = m_texture_index != Descriptors::TextureHeap::invalid_index;
 		PipelineConfigInfo pipeline_config{};
 		pipelineConfigInfo(&pipeline_config);
 		pipeline_config.render_pass = render_pass;
@@ -96,14 +195,16 @@ namespace Isonia::Pipeline::RenderSystems
 				sizeof(Shaders::UI::VERTEXSHADER_VERT) / sizeof(unsigned char)
 			)->addShaderModule(
 				VK_SHADER_STAGE_FRAGMENT_BIT,
-				Shaders::UI::FRAGSHADER_FRAG,
-				sizeof(Shaders::UI::FRAGSHADER_FRAG) / sizeof(unsigned char)
+				is_bindless ? Shaders::UI::FRAGSHADERBINDLESS_FRAG : Shaders::UI::FRAGSHADER_FRAG,
+				is_bindless ? sizeof(Shaders::UI::FRAGSHADERBINDLESS_FRAG) / sizeof(unsigned char) : sizeof(Shaders::UI::FRAGSHADER_FRAG) / sizeof(unsigned char)
 			)->createGraphicsPipeline(&pipeline_config);
 	}
 
 	void UIRenderSystem::pipelineConfigInfo(PipelineConfigInfo* pipeline_config)
 	{
 		Pipeline::pixelPipelineConfigInfo(pipeline_config);
+		// drawn in the water's render pass, where the depth is read only
+		Pipeline::makeReadOnlyDepthConfigInfo(pipeline_config);
 
 		pipeline_config->binding_descriptions = Renderable::VertexUI::getBindingDescriptions();
 		pipeline_config->binding_descriptions_count = Renderable::VertexUI::getBindingDescriptionsCount();
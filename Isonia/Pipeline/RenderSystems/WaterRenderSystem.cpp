@@ -10,10 +10,10 @@
 
 namespace Isonia::Pipeline::RenderSystems
 {
-	WaterRenderSystem::WaterRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout global_swapchain_set_layout, const VkDescriptorSetLayout water_set_layout)
+	WaterRenderSystem::WaterRenderSystem(Device* device, const VkRenderPass render_pass, const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout global_swapchain_set_layout, const VkDescriptorSetLayout palettes_set_layout)
 		: m_device(device)
 	{
-		createpipelineLayout(global_set_layout, global_swapchain_set_layout, water_set_layout);
+		createpipelineLayout(global_set_layout, global_swapchain_set_layout, palettes_set_layout);
 		createpipeline(render_pass);
 
 		m_water = new Renderable::BuilderXZUniform(m_device, 2u, 100.0f);
@@ -27,27 +27,24 @@ namespace Isonia::Pipeline::RenderSystems
 		delete m_water;
 	}
 
-	void WaterRenderSystem::render(const VkDescriptorSet* water_descriptor_set, const State::FrameInfo* frame_info, const Camera* camera)
+	void WaterRenderSystem::render(const VkDescriptorSet* palettes_descriptor_set, const State::FrameInfo* frame_info, const Camera* camera)
 	{
-		m_pipeline->bind(frame_info->command_buffer);
+		ISONIA_PROFILE_FUNCTION();
+		m_pipeline->bind(frame_info->recorder);
 
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
+		frame_info->recorder->bindDescriptorSets(
 			m_pipeline_layout,
 			0u,
 			2u,
 			&frame_info->global_descriptor_set,
-			0u,
-			nullptr
+			State::FrameInfo::global_dynamic_offsets_count,
+			frame_info->global_dynamic_offsets
 		);
-		vkCmdBindDescriptorSets(
-			frame_info->command_buffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
+		frame_info->recorder->bindDescriptorSets(
 			m_pipeline_layout,
 			2u,
 			1u,
-			water_descriptor_set,
+			palettes_descriptor_set,
 			0u,
 			nullptr
 		);
@@ -73,19 +70,18 @@ namespace Isonia::Pipeline::RenderSystems
 			offset_to_center + intersection_point.z
 		};
 
-		vkCmdPushConstants(
-			frame_info->command_buffer,
+		frame_info->recorder->pushConstants(
 			m_pipeline_layout,
 			VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 			0,
 			sizeof(Math::Vector3),
 			&(m_water->m_position)
 		);
-		m_water->bind(frame_info->command_buffer);
-		m_water->draw(frame_info->command_buffer);
+		m_water->bind(frame_info->recorder);
+		m_water->draw(frame_info->recorder);
 	}
 
-	void WaterRenderSystem::createpipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout global_swapchain_set_layout, const VkDescriptorSetLayout water_set_layout)
+	void WaterRenderSystem::createpipelineLayout(const VkDescriptorSetLayout global_set_layout, const VkDescriptorSetLayout global_swapchain_set_layout, const VkDescriptorSetLayout palettes_set_layout)
 	{
 		VkPushConstantRange push_constant_range{};
 		push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -96,7 +92,7 @@ namespace Isonia::Pipeline::RenderSystems
 		const VkDescriptorSetLayout descriptor_set_layouts[descriptor_set_layouts_length]{
 			global_set_layout,
 			global_swapchain_set_layout,
-			water_set_layout
+			palettes_set_layout
 		};
 
 		VkPipelineLayoutCreateInfo pipeline_layout_info{};
@@ -118,6 +114,7 @@ namespace Isonia::Pipeline::RenderSystems
 		PipelineConfigInfo pipeline_config{};
 		Pipeline::pixelPipelineTriangleStripConfigInfo(&pipeline_config);
 		Pipeline::makeTransparentConfigInfo(&pipeline_config);
+		Pipeline::makeReadOnlyDepthConfigInfo(&pipeline_config);
 		pipeline_config.render_pass = render_pass;
 		pipeline_config.pipeline_layout = m_pipeline_layout;
 		m_pipeline = (new Pipeline(m_device, 2u))
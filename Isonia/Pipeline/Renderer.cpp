@@ -57,6 +57,17 @@ namespace Isonia::Pipeline
 		return m_command_buffers[m_current_frame];
 	}
 
+	CommandRecorder* Renderer::getCommandRecorder()
+	{
+		assert(m_is_frame_started && "Cannot get command recorder when frame not in progress");
+		return &m_command_recorder;
+	}
+
+	const CommandRecorderStats* Renderer::getCommandStats() const
+	{
+		return m_command_recorder.getFrameStats();
+	}
+
 	int Renderer::getFrameIndex() const
 	{
 		assert(m_is_frame_started && "Cannot get frame index when frame not in progress");
@@ -80,6 +91,7 @@ namespace Isonia::Pipeline
 		}
 
 		m_is_frame_started = true;
+		m_device->beginFrame(m_current_frame, m_swap_chain->getImageInFlightFence(m_current_frame));
 
 		VkCommandBuffer command_buffer = getCurrentCommandBuffer();
 		VkCommandBufferBeginInfo begin_info{};
@@ -89,6 +101,7 @@ namespace Isonia::Pipeline
 		{
 			throw std::runtime_error("Failed to begin recording command buffer!");
 		}
+		m_command_recorder.begin(command_buffer);
 		return command_buffer;
 	}
 
@@ -101,6 +114,11 @@ namespace Isonia::Pipeline
 			throw std::runtime_error("Failed to record command buffer!");
 		}
 
+		m_device->getUniformRing()->flush();
+
+		// uploads recorded since the last frame go first on the queue
+		m_device->getUploadContext()->submit();
+
 		VkResult result = m_swap_chain->submitCommandBuffers(&command_buffer, &m_current_frame);
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window->m_resized)
 		{
@@ -113,6 +131,7 @@ namespace Isonia::Pipeline
 			throw std::runtime_error("Failed to present swap chain image!");
 		}
 
+		m_device->endFrame();
 		m_is_frame_started = false;
 		m_current_frame = (m_current_frame + 1) % m_swap_chain->getImageCount();
 	}
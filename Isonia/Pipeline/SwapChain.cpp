@@ -39,12 +39,11 @@ namespace Isonia::Pipeline
 		for (unsigned int i = 0; i < max_frames_in_flight; i++)
 		{
 			vkDestroyImageView(m_device->getDevice(), m_depth_image_views[i], nullptr);
-			vkDestroyImage(m_device->getDevice(), m_depth_images[i], nullptr);
-			vkFreeMemory(m_device->getDevice(), m_depth_image_memorys[i], nullptr);
+			m_device->destroyImage(m_depth_images[i], &m_depth_image_allocations[i]);
 		}
 		delete[] m_depth_image_views;
 		delete[] m_depth_images;
-		delete[] m_depth_image_memorys;
+		delete[] m_depth_image_allocations;
 
 		for (unsigned int i = 0; i < max_frames_in_flight; i++)
 		{
@@ -87,6 +86,10 @@ namespace Isonia::Pipeline
 	{
 		return m_image_count;
 	}
+	VkFence SwapChain::getImageInFlightFence(int index) const
+	{
+		return m_images_in_flight[index];
+	}
 	VkFormat SwapChain::getSwapChainImageFormat() const
 	{
 		return m_swap_chain_image_format;
@@ -383,7 +386,7 @@ namespace Isonia::Pipeline
 		VkExtent2D m_swap_chainExtent = getSwapChainExtent();
 
 		m_depth_images = new VkImage[max_frames_in_flight];
-		m_depth_image_memorys = new VkDeviceMemory[max_frames_in_flight];
+		m_depth_image_allocations = new MemoryAllocation[max_frames_in_flight];
 		m_depth_image_views = new VkImageView[max_frames_in_flight];
 
 		for (unsigned int i = 0; i < max_frames_in_flight; i++)
@@ -408,7 +411,8 @@ namespace Isonia::Pipeline
 				&image_info,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 				&m_depth_images[i],
-				&m_depth_image_memorys[i]
+				&m_depth_image_allocations[i],
+				ResourceCategories::swap_chain
 			);
 
 			VkImageViewCreateInfo view_info{};
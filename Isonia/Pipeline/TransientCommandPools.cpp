@@ -0,0 +1,150 @@
+// internal
+#include "Pipeline.h"
+
+// external
+#include <cassert>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace Isonia::Pipeline
+{
+	TransientCommandPools::TransientCommandPools(Device* device) : m_device{ device }
+	{
+	}
+
+	TransientCommandPools::~TransientCommandPools()
+	{
+		vkDeviceWaitIdle(m_device->getDevice());
+
+		for (unsigned int i = 0u; i < max_frames_in_flight; i++)
+		{
+			for (unsigned int t = 0u; t < m_thread_count; t++)
+			{
+				TransientCommandPool* pool = &m_pools[i][t];
+				vkDestroyCommandPool(m_device->getDevice(), pool->command_pool, nullptr);
+				free(pool->command_buffers[0]);
+				free(pool->command_buffers[1]);
+			}
+		}
+	}
+
+	VkCommandBuffer TransientCommandPools::beginPrimary()
+	{
+		VkCommandBufferBeginInfo begin_info{};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		return acquire(0u, &begin_info);
+	}
+
+	VkCommandBuffer TransientCommandPools::beginSecondary(const VkCommandBufferInheritanceInfo* inheritance_info)
+	{
+		VkCommandBufferBeginInfo begin_info{};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (inheritance_info->renderPass != nullptr)
+		{
+			begin_info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		}
+		begin_info.pInheritanceInfo = inheritance_info;
+
+		return acquire(1u, &begin_info);
+	}
+
+	void TransientCommandPools::beginFrame(unsigned int frame, VkFence frame_fence)
+	{
+		assert(frame < max_frames_in_flight && "Frame slot out of range");
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// normally signaled long ago, null when the slot was never submitted
+		if (frame_fence != nullptr)
+		{
+			vkWaitForFences(m_device->getDevice(), 1, &frame_fence, VK_TRUE, UINT64_MAX);
+		}
+		m_frame = frame;
+
+		// one reset per pool instead of one per command buffer
+		for (unsigned int t = 0u; t < m_thread_count; t++)
+		{
+			TransientCommandPool* pool = &m_pools[m_frame][t];
+			if (pool->used_counts[0] == 0u && pool->used_counts[1] == 0u)
+			{
+				continue;
+			}
+			vkResetCommandPool(m_device->getDevice(), pool->command_pool, 0);
+			pool->used_counts[0] = 0u;
+			pool->used_counts[1] = 0u;
+		}
+	}
+
+	TransientCommandPool* TransientCommandPools::getThreadPool()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const std::thread::id thread_id = std::this_thread::get_id();
+		unsigned int index = 0u;
+		while (index < m_thread_count && m_thread_ids[index] != thread_id)
+		{
+			index++;
+		}
+
+		if (index == m_thread_count)
+		{
+			assert(m_thread_count < max_threads && "Too many threads recording transient command buffers");
+
+			VkCommandPoolCreateInfo pool_info = {};
+			pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			pool_info.queueFamilyIndex = m_device->getPhysicalQueueFamilies().graphics_family;
+			pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+			for (unsigned int i = 0u; i < max_frames_in_flight; i++)
+			{
+				TransientCommandPool* pool = &m_pools[i][index];
+				if (vkCreateCommandPool(m_device->getDevice(), &pool_info, nullptr, &pool->command_pool) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to create transient command pool!");
+				}
+				for (unsigned int level = 0u; level < 2u; level++)
+				{
+					pool->command_buffers[level] = nullptr;
+					pool->allocated_counts[level] = 0u;
+					pool->used_counts[level] = 0u;
+				}
+			}
+			m_thread_ids[index] = thread_id;
+			m_thread_count++;
+		}
+		return &m_pools[m_frame][index];
+	}
+
+	VkCommandBuffer TransientCommandPools::acquire(unsigned int level, const VkCommandBufferBeginInfo* begin_info)
+	{
+		// only the calling thread records from its own pool, no lock needed past the lookup
+		TransientCommandPool* pool = getThreadPool();
+
+		if (pool->used_counts[level] == pool->allocated_counts[level])
+		{
+			const unsigned int count = pool->allocated_counts[level] == 0u ? 4u : pool->allocated_counts[level] * 2u;
+			pool->command_buffers[level] = (VkCommandBuffer*)realloc(pool->command_buffers[level], count * sizeof(VkCommandBuffer));
+
+			VkCommandBufferAllocateInfo alloc_info{};
+			alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			alloc_info.level = level == 0u ? VK_COMMAND_BUFFER_LEVEL_PRIMARY : VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			alloc_info.commandPool = pool->command_pool;
+			alloc_info.commandBufferCount = count - pool->allocated_counts[level];
+
+			if (vkAllocateCommandBuffers(m_device->getDevice(), &alloc_info, pool->command_buffers[level] + pool->allocated_counts[level]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate transient command buffers!");
+			}
+			pool->allocated_counts[level] = count;
+		}
+
+		VkCommandBuffer command_buffer = pool->command_buffers[level][pool->used_counts[level]++];
+		if (vkBeginCommandBuffer(command_buffer, begin_info) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin transient command buffer!");
+		}
+		return command_buffer;
+	}
+}
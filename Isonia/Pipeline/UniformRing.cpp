@@ -0,0 +1,74 @@
+// internal
+#include "Pipeline.h"
+
+// external
+#include <cassert>
+#include <cstring>
+
+namespace Isonia::Pipeline
+{
+	UniformRing::UniformRing(Device* device) : m_device{ device }, m_alignment{ device->m_properties.limits.minUniformBufferOffsetAlignment }
+	{
+		// one slice per frame slot, each slice is reused once its frame's fence signals
+		m_buffer = new Buffer(
+			m_device,
+			frame_size,
+			max_frames_in_flight,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+			1,
+			ResourceCategories::uniform
+		);
+		m_buffer->map();
+	}
+
+	UniformRing::~UniformRing()
+	{
+		delete m_buffer;
+	}
+
+	void* UniformRing::allocate(VkDeviceSize size, unsigned int* dynamic_offset)
+	{
+		m_device->trackTransfer(size, 0);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const VkDeviceSize offset = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+		assert(offset + size <= frame_size && "Uniform ring frame is full");
+		m_head = offset + size;
+
+		*dynamic_offset = static_cast<unsigned int>(m_frame_begin + offset);
+		return static_cast<unsigned char*>(m_buffer->getMappedMemory()) + m_frame_begin + offset;
+	}
+
+	unsigned int UniformRing::push(const void* data, VkDeviceSize size)
+	{
+		unsigned int dynamic_offset;
+		memcpy(allocate(size, &dynamic_offset), data, size);
+		return dynamic_offset;
+	}
+
+	VkDescriptorBufferInfo UniformRing::getDescriptorInfo(VkDeviceSize range) const
+	{
+		return VkDescriptorBufferInfo{ m_buffer->getBuffer(), 0, range };
+	}
+
+	void UniformRing::beginFrame(unsigned int frame)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_frame_begin = frame * m_buffer->getAlignmentSize();
+		m_head = 0;
+	}
+
+	VkResult UniformRing::flush()
+	{
+		ISONIA_PROFILE_FUNCTION();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_head == 0)
+		{
+			return VK_SUCCESS;
+		}
+		// skipped by the allocator when the memory is coherent
+		return m_buffer->flush(m_head, m_frame_begin);
+	}
+}
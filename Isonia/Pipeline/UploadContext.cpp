@@ -0,0 +1,456 @@
+// internal
+#include "Pipeline.h"
+
+// external
+#include <cassert>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace Isonia::Pipeline
+{
+	UploadContext::UploadContext(Device* device) : m_device{ device }
+	{
+		VkCommandPoolCreateInfo pool_info = {};
+		pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		pool_info.queueFamilyIndex = m_device->getPhysicalQueueFamilies().graphics_family;
+		pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		if (vkCreateCommandPool(m_device->getDevice(), &pool_info, nullptr, &m_command_pool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create upload command pool!");
+		}
+
+		VkCommandBuffer command_buffers[max_batches];
+		VkCommandBufferAllocateInfo alloc_info{};
+		alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		alloc_info.commandPool = m_command_pool;
+		alloc_info.commandBufferCount = max_batches;
+
+		if (vkAllocateCommandBuffers(m_device->getDevice(), &alloc_info, command_buffers) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate upload command buffers!");
+		}
+
+		VkFenceCreateInfo fence_info = {};
+		fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		for (unsigned int i = 0u; i < max_batches; i++)
+		{
+			UploadBatch* batch = &m_batches[i];
+			batch->command_buffer = command_buffers[i];
+			batch->ticket = 0ull;
+			batch->is_pending = false;
+			batch->has_staging = false;
+			batch->staging_begin = 0;
+			batch->released_count = 0u;
+			batch->released_capacity = 8u;
+			batch->released_buffers = (Buffer**)malloc(batch->released_capacity * sizeof(Buffer*));
+
+			if (vkCreateFence(m_device->getDevice(), &fence_info, nullptr, &batch->fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create upload fence!");
+			}
+		}
+
+		// mapped once and written in place by every producer
+		m_staging_ring = new Buffer(
+			m_device,
+			staging_ring_size,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			1,
+			ResourceCategories::staging
+		);
+		m_staging_ring->map();
+	}
+
+	UploadContext::~UploadContext()
+	{
+		if (m_recording != nullptr)
+		{
+			vkEndCommandBuffer(m_recording->command_buffer);
+			retireBatch(m_recording);
+			m_recording = nullptr;
+		}
+
+		for (unsigned int i = 0u; i < max_batches; i++)
+		{
+			UploadBatch* batch = &m_batches[i];
+			if (batch->is_pending)
+			{
+				vkWaitForFences(m_device->getDevice(), 1, &batch->fence, VK_TRUE, UINT64_MAX);
+				retireBatch(batch);
+			}
+			vkDestroyFence(m_device->getDevice(), batch->fence, nullptr);
+			free(batch->released_buffers);
+		}
+		delete m_staging_ring;
+		vkDestroyCommandPool(m_device->getDevice(), m_command_pool, nullptr);
+	}
+
+	void* UploadContext::stageBuffer(VkBuffer dst_buffer, VkDeviceSize size, VkDeviceSize dst_offset, unsigned long long* ticket)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		VkBuffer staging_buffer;
+		VkDeviceSize staging_offset;
+		void* mapped = allocateStaging(size, &staging_buffer, &staging_offset);
+		m_device->trackTransfer(size, 0);
+
+		VkBufferCopy copy_region{};
+		copy_region.srcOffset = staging_offset;
+		copy_region.dstOffset = dst_offset;
+		copy_region.size = size;
+		vkCmdCopyBuffer(m_recording->command_buffer, staging_buffer, dst_buffer, 1, &copy_region);
+
+		if (ticket != nullptr)
+		{
+			*ticket = m_recording->ticket;
+		}
+		return mapped;
+	}
+
+	void* UploadContext::stageImage(VkImage image, VkFormat format, unsigned int width, unsigned int height, unsigned int layer_count, VkDeviceSize size, unsigned long long* ticket)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		VkBuffer staging_buffer;
+		VkDeviceSize staging_offset;
+		void* mapped = allocateStaging(size, &staging_buffer, &staging_offset);
+		m_device->trackTransfer(0, size);
+		VkCommandBuffer command_buffer = m_recording->command_buffer;
+
+		m_device->recordTransitionImageLayout(command_buffer, image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, layer_count);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = staging_offset;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = layer_count;
+
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { width, height, 1 };
+
+		vkCmdCopyBufferToImage(command_buffer, staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		m_device->recordTransitionImageLayout(command_buffer, image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, layer_count);
+
+		if (ticket != nullptr)
+		{
+			*ticket = m_recording->ticket;
+		}
+		return mapped;
+	}
+
+	Buffer* UploadContext::createBuffer(VkDeviceSize instance_size, unsigned int instance_count, VkBufferUsageFlags usage_flags, void** data, unsigned int category)
+	{
+		if (m_device->hasHostVisibleDeviceMemory())
+		{
+			Buffer* buffer = new Buffer(
+				m_device,
+				instance_size,
+				instance_count,
+				usage_flags,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				1,
+				category
+			);
+			buffer->map();
+			*data = buffer->getMappedMemory();
+			return buffer;
+		}
+
+		Buffer* buffer = new Buffer(
+			m_device,
+			instance_size,
+			instance_count,
+			usage_flags | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			1,
+			category
+		);
+		*data = stageBuffer(buffer->getBuffer(), buffer->getBufferSize());
+		return buffer;
+	}
+
+	unsigned long long UploadContext::submit()
+	{
+		ISONIA_PROFILE_FUNCTION();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pollBatches();
+
+		if (m_recording == nullptr)
+		{
+			return 0ull;
+		}
+		const unsigned long long ticket = m_recording->ticket;
+		submitBatch();
+		return ticket;
+	}
+
+	bool UploadContext::isComplete(unsigned long long ticket)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pollBatches();
+
+		if (m_recording != nullptr && m_recording->ticket == ticket)
+		{
+			return false;
+		}
+		for (unsigned int i = 0u; i < max_batches; i++)
+		{
+			if (m_batches[i].is_pending && m_batches[i].ticket == ticket)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void UploadContext::wait(unsigned long long ticket)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_recording != nullptr && m_recording->ticket == ticket)
+		{
+			submitBatch();
+		}
+		for (unsigned int i = 0u; i < max_batches; i++)
+		{
+			UploadBatch* batch = &m_batches[i];
+			if (batch->is_pending && batch->ticket == ticket)
+			{
+				vkWaitForFences(m_device->getDevice(), 1, &batch->fence, VK_TRUE, UINT64_MAX);
+				retireBatch(batch);
+			}
+		}
+	}
+
+	void* UploadContext::allocateStaging(VkDeviceSize size, VkBuffer* buffer, VkDeviceSize* offset)
+	{
+		assert(size > 0 && "Staging allocation must not be empty");
+
+		if (size >= staging_ring_size)
+		{
+			// too large for the ring
+			return allocateDedicatedStaging(size, buffer, offset);
+		}
+
+		VkDeviceSize staging_offset;
+		while (!findStagingSpace(size, &staging_offset))
+		{
+			// the ring is full, retire the batch holding its tail
+			UploadBatch* oldest = getOldestStagingBatch();
+			if (oldest == m_recording)
+			{
+				// earlier regions of the recording batch may not be filled yet, so it must not be submitted from here
+				return allocateDedicatedStaging(size, buffer, offset);
+			}
+			vkWaitForFences(m_device->getDevice(), 1, &oldest->fence, VK_TRUE, UINT64_MAX);
+			retireBatch(oldest);
+		}
+
+		UploadBatch* batch = beginBatch();
+		if (!batch->has_staging)
+		{
+			batch->has_staging = true;
+			batch->staging_begin = staging_offset;
+		}
+		m_staging_head = staging_offset + size;
+
+		*buffer = m_staging_ring->getBuffer();
+		*offset = staging_offset;
+		return static_cast<unsigned char*>(m_staging_ring->getMappedMemory()) + staging_offset;
+	}
+
+	void* UploadContext::allocateDedicatedStaging(VkDeviceSize size, VkBuffer* buffer, VkDeviceSize* offset)
+	{
+		// a one off buffer freed with the batch
+		Buffer* dedicated = new Buffer(
+			m_device,
+			size,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			1,
+			ResourceCategories::staging
+		);
+		dedicated->map();
+		releaseBuffer(beginBatch(), dedicated);
+		*buffer = dedicated->getBuffer();
+		*offset = 0;
+		return dedicated->getMappedMemory();
+	}
+
+	bool UploadContext::findStagingSpace(VkDeviceSize size, VkDeviceSize* offset) const
+	{
+		const UploadBatch* oldest = getOldestStagingBatch();
+		if (oldest == nullptr)
+		{
+			*offset = 0;
+			return true;
+		}
+
+		// head never catches up with the tail exactly, so head == tail only ever means empty
+		const VkDeviceSize tail = oldest->staging_begin;
+		const VkDeviceSize aligned_head = (m_staging_head + staging_alignment - 1) / staging_alignment * staging_alignment;
+		if (m_staging_head < tail)
+		{
+			*offset = aligned_head;
+			return aligned_head + size < tail;
+		}
+		if (aligned_head + size <= staging_ring_size)
+		{
+			*offset = aligned_head;
+			return true;
+		}
+		*offset = 0;
+		return size < tail;
+	}
+
+	UploadBatch* UploadContext::getOldestStagingBatch() const
+	{
+		UploadBatch* oldest = nullptr;
+		for (unsigned int i = 0u; i < max_batches; i++)
+		{
+			UploadBatch* batch = const_cast<UploadBatch*>(&m_batches[i]);
+			if (batch->has_staging && (oldest == nullptr || batch->ticket < oldest->ticket))
+			{
+				oldest = batch;
+			}
+		}
+		return oldest;
+	}
+
+	void UploadContext::releaseBuffer(UploadBatch* batch, Buffer* buffer)
+	{
+		if (batch->released_count == batch->released_capacity)
+		{
+			batch->released_capacity *= 2u;
+			batch->released_buffers = (Buffer**)realloc(batch->released_buffers, batch->released_capacity * sizeof(Buffer*));
+		}
+		batch->released_buffers[batch->released_count++] = buffer;
+	}
+
+	UploadBatch* UploadContext::beginBatch()
+	{
+		if (m_recording != nullptr)
+		{
+			return m_recording;
+		}
+
+		// reuse the oldest batch, only blocks when max_batches uploads are still in flight
+		UploadBatch* batch = &m_batches[m_next_batch];
+		m_next_batch = (m_next_batch + 1u) % max_batches;
+		if (batch->is_pending)
+		{
+			vkWaitForFences(m_device->getDevice(), 1, &batch->fence, VK_TRUE, UINT64_MAX);
+			retireBatch(batch);
+		}
+		vkResetFences(m_device->getDevice(), 1, &batch->fence);
+		vkResetCommandBuffer(batch->command_buffer, 0);
+
+		VkCommandBufferBeginInfo begin_info{};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(batch->command_buffer, &begin_info) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin recording upload command buffer!");
+		}
+
+		// destinations may still be read by frames submitted earlier on the same queue
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			batch->command_buffer,
+			VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0,
+			1,
+			&barrier,
+			0,
+			nullptr,
+			0,
+			nullptr
+		);
+
+		batch->ticket = m_next_ticket++;
+		m_recording = batch;
+		return batch;
+	}
+
+	void UploadContext::submitBatch()
+	{
+		UploadBatch* batch = m_recording;
+
+		// make the copies visible to every later submission on the queue
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(
+			batch->command_buffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0,
+			1,
+			&barrier,
+			0,
+			nullptr,
+			0,
+			nullptr
+		);
+
+		if (vkEndCommandBuffer(batch->command_buffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record upload command buffer!");
+		}
+
+		VkSubmitInfo submit_info{};
+		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submit_info.commandBufferCount = 1;
+		submit_info.pCommandBuffers = &batch->command_buffer;
+
+		if (vkQueueSubmit(m_device->getGraphicsQueue(), 1, &submit_info, batch->fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit upload command buffer!");
+		}
+		batch->is_pending = true;
+		m_recording = nullptr;
+	}
+
+	void UploadContext::pollBatches()
+	{
+		for (unsigned int i = 0u; i < max_batches; i++)
+		{
+			UploadBatch* batch = &m_batches[i];
+			if (batch->is_pending && vkGetFenceStatus(m_device->getDevice(), batch->fence) == VK_SUCCESS)
+			{
+				retireBatch(batch);
+			}
+		}
+	}
+
+	void UploadContext::retireBatch(UploadBatch* batch)
+	{
+		for (unsigned int i = 0u; i < batch->released_count; i++)
+		{
+			delete batch->released_buffers[i];
+		}
+		batch->released_count = 0u;
+		batch->is_pending = false;
+		batch->has_staging = false;
+	}
+}
@@ -2,17 +2,23 @@
 #include "Pipeline.h"
 
 // external
+#ifdef _WIN32
 #include <windows.h>
 #include <vulkan/vulkan_win32.h>
+#endif
+#include <cstring>
 #include <stdexcept>
 #include <iostream>
 
 namespace Isonia::Pipeline
 {
-    Window::Window(const unsigned int width, const unsigned int height, const char* name)
-        : m_extent({ width, height }), m_name(name)
+    Window::Window(const unsigned int width, const unsigned int height, const char* name, bool headless)
+        : m_extent({ width, height }), m_name(name), m_headless(headless)
     {
-        createWindow();
+        if (!m_headless)
+        {
+            createWindow();
+        }
     }
 
     Window::~Window()
@@ -28,7 +34,12 @@ namespace Isonia::Pipeline
     {
         // switch current and previous
         memcpy(m_input.previous_key_state, m_input.current_key_state, sizeof(m_input.current_key_state));
+        if (m_headless)
+        {
+            return;
+        }
 
+#ifdef _WIN32
         MSG message;
         while (PeekMessage(&message, NULL, 0, 0, PM_REMOVE))
         {
@@ -42,6 +53,7 @@ namespace Isonia::Pipeline
                 DispatchMessage(&message);
             }
         }
+#endif
     }
 
     void Window::waitEvents() const
@@ -51,6 +63,7 @@ namespace Isonia::Pipeline
 
     void Window::createWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
     {
+#ifdef _WIN32
         VkWin32SurfaceCreateInfoKHR create_info{};
         create_info.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
         create_info.hwnd = static_cast<HWND>(m_window);
@@ -60,6 +73,14 @@ namespace Isonia::Pipeline
         {
             throw std::runtime_error("Failed to create window surface!");
         }
+#else
+        throw std::runtime_error("Window surfaces are only supported on Win32!");
+#endif
+    }
+
+    bool Window::isHeadless() const
+    {
+        return m_headless;
     }
 
     void Window::registerCallback(EventHandler handler)
@@ -83,6 +104,7 @@ namespace Isonia::Pipeline
         }
     }
 
+#ifdef _WIN32
     static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     {
         switch (message)
@@ -259,4 +281,11 @@ namespace Isonia::Pipeline
         SetForegroundWindow(m_window_recast);
         SetFocus(m_window_recast);
     }
+#else
+    void Window::createWindow()
+    {
+        // other platforms only render headless
+        throw std::runtime_error("Windows are only supported on Win32, run with --headless!");
+    }
+#endif
 }
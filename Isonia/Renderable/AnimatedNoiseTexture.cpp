@@ -0,0 +1,365 @@
+// internal
+#include "Renderable.h"
+
+// external
+#include <cstring>
+#include <stdexcept>
+
+namespace Isonia::Renderable
+{
+	AnimatedNoiseTexture::AnimatedNoiseTexture(Pipeline::Device* device, const Noise4DTextureFactory* factory, const VkFormat format, const unsigned int frames_in_flight, const unsigned int rows_per_frame, const float time_scale, const VkFilter filter, const VkSamplerAddressMode address_mode)
+		: m_device{ device }, m_factory{ factory }, m_source_format{ format }, m_format{ format }, m_frames_in_flight{ frames_in_flight }, m_rows_per_frame{ rows_per_frame }, m_time_scale{ time_scale }
+	{
+		m_height = m_factory->getTextureHeight();
+		m_width = m_factory->getTextureWidth();
+
+		// compressed rows are encoded on the worker and streamed one row of blocks at a time
+		const VkFormat compressed_format = toBlockCompressedFormat(format);
+		if (m_height % block_dimension == 0u && m_width % block_dimension == 0u && isBlockCompressionSupported(device, compressed_format, filter))
+		{
+			m_format = compressed_format;
+			m_row_height = block_dimension;
+			m_row_size = (m_width / block_dimension) * Texture::formatToBytesPerBlock(m_format);
+		}
+		else
+		{
+			m_row_height = 1u;
+			m_row_size = m_width * Texture::formatToBytesPerPixel(m_format);
+		}
+		m_row_count = m_height / m_row_height;
+
+		m_generated = static_cast<unsigned char*>(malloc(m_row_count * m_row_size));
+		if (m_row_height != 1u)
+		{
+			m_band_texels = static_cast<unsigned char*>(malloc(m_rows_per_frame * m_row_height * m_width * Texture::formatToBytesPerPixel(m_source_format)));
+		}
+
+		createImages(filter, address_mode);
+
+		for (unsigned int i = 0u; i < m_frames_in_flight; i++)
+		{
+			m_staging_buffers[i] = new Pipeline::Buffer(
+				m_device,
+				m_row_size,
+				m_rows_per_frame,
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				1,
+				Pipeline::ResourceCategories::staging
+			);
+			m_staging_buffers[i]->map();
+		}
+
+		m_worker = std::thread(&AnimatedNoiseTexture::workerLoop, this);
+	}
+
+	AnimatedNoiseTexture::~AnimatedNoiseTexture()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_condition.notify_one();
+		m_worker.join();
+		free(m_band_texels);
+		free(m_generated);
+
+		for (unsigned int i = 0u; i < m_frames_in_flight; i++)
+		{
+			delete m_staging_buffers[i];
+		}
+		Pipeline::DeletionQueue* deletion_queue = m_device->getDeletionQueue();
+		deletion_queue->destroySampler(m_sampler);
+		for (unsigned int i = 0u; i < image_count; i++)
+		{
+			deletion_queue->destroyImageView(m_image_views[i]);
+			deletion_queue->destroyImage(m_images[i], &m_image_allocations[i]);
+		}
+	}
+
+	const VkDescriptorImageInfo* AnimatedNoiseTexture::getImageInfo() const
+	{
+		return &m_descriptor;
+	}
+
+	bool AnimatedNoiseTexture::update(VkCommandBuffer command_buffer, const unsigned int frame_index, const float time_s)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		// frames recorded before the last swap still point at the previous front image
+		bool descriptor_changed = m_frame_generations[frame_index] != m_generation;
+		m_frame_generations[frame_index] = m_generation;
+
+		if (!m_generation_requested)
+		{
+			requestGeneration(time_s);
+		}
+		const unsigned int remaining_rows = m_row_count - m_uploaded_rows;
+		const unsigned int band_rows = remaining_rows < m_rows_per_frame ? remaining_rows : m_rows_per_frame;
+		if (m_lockstep)
+		{
+			// sleeps rather than spins, the wait is part of the frame times being measured
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_ready_condition.wait(lock, [this, band_rows] { return m_generated_rows.load(std::memory_order_acquire) >= m_uploaded_rows + band_rows; });
+		}
+		const unsigned int ready_rows = m_generated_rows.load(std::memory_order_acquire) - m_uploaded_rows;
+		if (ready_rows == 0u || !isBackImageIdle())
+		{
+			return descriptor_changed;
+		}
+
+		const unsigned int back = 1u - m_front;
+		if (m_uploaded_rows == 0u)
+		{
+			// previous contents are discarded, every row gets rewritten
+			transitionBackImage(
+				command_buffer,
+				VK_IMAGE_LAYOUT_UNDEFINED,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				0,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT
+			);
+		}
+
+		const unsigned int rows = ready_rows < band_rows ? ready_rows : band_rows;
+		memcpy(m_staging_buffers[frame_index]->getMappedMemory(), m_generated + m_uploaded_rows * m_row_size, rows * m_row_size);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, static_cast<int>(m_uploaded_rows * m_row_height), 0 };
+		region.imageExtent = { m_width, rows * m_row_height, 1 };
+
+		vkCmdCopyBufferToImage(command_buffer, m_staging_buffers[frame_index]->getBuffer(), m_images[back], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+		m_device->trackTransfer(0, rows * m_row_size);
+		{
+			// lets the worker start on the next band
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_uploaded_rows += rows;
+		}
+		m_condition.notify_one();
+
+		if (m_uploaded_rows == m_row_count)
+		{
+			transitionBackImage(
+				command_buffer,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+			);
+
+			// swap, this frame samples the new image right away
+			m_front = back;
+			m_descriptor.imageView = m_image_views[m_front];
+			m_generation++;
+			m_frame_generations[frame_index] = m_generation;
+			descriptor_changed = true;
+
+			// the worker finished its last band before it was uploaded, it is idle until the next request
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_uploaded_rows = 0u;
+			}
+			m_generated_rows.store(0u, std::memory_order_release);
+			requestGeneration(time_s);
+		}
+		return descriptor_changed;
+	}
+
+	void AnimatedNoiseTexture::setLockstep(const bool lockstep)
+	{
+		m_lockstep = lockstep;
+	}
+
+	bool AnimatedNoiseTexture::isBackImageIdle() const
+	{
+		// once every frame slot has been recorded against the current front image, the fences
+		// waited on before those recordings guarantee nothing in flight still samples the back image
+		for (unsigned int i = 0u; i < m_frames_in_flight; i++)
+		{
+			if (m_frame_generations[i] != m_generation)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void AnimatedNoiseTexture::requestGeneration(const float time_s)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_requested = true;
+			m_requested_time = time_s * m_time_scale;
+		}
+		m_generation_requested = true;
+		m_condition.notify_one();
+	}
+
+	void AnimatedNoiseTexture::workerLoop()
+	{
+		ISONIA_PROFILE_THREAD("Noise");
+		while (true)
+		{
+			float time;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this] { return m_requested || m_stop; });
+				if (m_stop)
+				{
+					return;
+				}
+				m_requested = false;
+				time = m_requested_time;
+			}
+
+			for (unsigned int first_row = 0u; first_row < m_row_count; first_row += m_rows_per_frame)
+			{
+				{
+					// at most one band waits ahead of the one being uploaded, so each frame pays for about one band
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_condition.wait(lock, [this, first_row] { return first_row <= m_uploaded_rows + m_rows_per_frame || m_stop; });
+					if (m_stop)
+					{
+						return;
+					}
+				}
+
+				const unsigned int remaining_rows = m_row_count - first_row;
+				const unsigned int rows = remaining_rows < m_rows_per_frame ? remaining_rows : m_rows_per_frame;
+				generateRows(m_generated + first_row * m_row_size, first_row, rows, time);
+				{
+					// published under the lock so a lockstep wait can not miss the notification
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_generated_rows.store(first_row + rows, std::memory_order_release);
+				}
+				m_ready_condition.notify_one();
+			}
+		}
+	}
+
+	void AnimatedNoiseTexture::generateRows(unsigned char* destination, const unsigned int first_row, const unsigned int row_count, const float time) const
+	{
+		ISONIA_PROFILE_FUNCTION();
+		if (m_row_height == 1u)
+		{
+			m_factory->fillRowsAt(destination, first_row, row_count, time);
+			return;
+		}
+
+		// bands hold whole rows of blocks, so compressing one on its own matches compressing the full map
+		m_factory->fillRowsAt(m_band_texels, first_row * m_row_height, row_count * m_row_height, time);
+		BlockCompressionError error;
+		compressTextureInto(m_band_texels, destination, row_count * m_row_height, m_width, m_source_format, &error);
+	}
+
+	void AnimatedNoiseTexture::transitionBackImage(VkCommandBuffer command_buffer, const VkImageLayout old_layout, const VkImageLayout new_layout, const VkAccessFlags src_access, const VkAccessFlags dst_access, const VkPipelineStageFlags src_stage, const VkPipelineStageFlags dst_stage) const
+	{
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = old_layout;
+		barrier.newLayout = new_layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_images[1u - m_front];
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.srcAccessMask = src_access;
+		barrier.dstAccessMask = dst_access;
+
+		vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	void AnimatedNoiseTexture::createImages(const VkFilter filter, const VkSamplerAddressMode address_mode)
+	{
+		for (unsigned int i = 0u; i < image_count; i++)
+		{
+			VkImageCreateInfo image_info{};
+			image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			image_info.imageType = VK_IMAGE_TYPE_2D;
+			image_info.extent = { m_width, m_height, 1 };
+			image_info.mipLevels = 1;
+			image_info.arrayLayers = 1;
+			image_info.format = m_format;
+			image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+			image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			image_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+			image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			image_info.flags = 0;
+
+			m_device->createImageWithInfo(
+				&image_info,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				&m_images[i],
+				&m_image_allocations[i],
+				Pipeline::ResourceCategories::textures
+			);
+
+			VkImageViewCreateInfo view_info{};
+			view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			view_info.image = m_images[i];
+			view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			view_info.format = m_format;
+			view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			view_info.subresourceRange.baseMipLevel = 0;
+			view_info.subresourceRange.levelCount = 1;
+			view_info.subresourceRange.baseArrayLayer = 0;
+			view_info.subresourceRange.layerCount = 1;
+
+			if (vkCreateImageView(m_device->getDevice(), &view_info, nullptr, &m_image_views[i]) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create texture image view!");
+			}
+		}
+
+		// the first front image is generated synchronously, before the worker takes over the band scratch
+		for (unsigned int first_row = 0u; first_row < m_row_count; first_row += m_rows_per_frame)
+		{
+			const unsigned int remaining_rows = m_row_count - first_row;
+			generateRows(m_generated + first_row * m_row_size, first_row, remaining_rows < m_rows_per_frame ? remaining_rows : m_rows_per_frame, 0.0f);
+		}
+		const VkDeviceSize image_size = m_row_count * m_row_size;
+
+		memcpy(m_device->getUploadContext()->stageImage(m_images[m_front], m_format, m_width, m_height, 1, image_size), m_generated, image_size);
+
+		VkSamplerCreateInfo sampler_info{};
+		sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		sampler_info.magFilter = filter;
+		sampler_info.minFilter = filter;
+		sampler_info.addressModeU = address_mode;
+		sampler_info.addressModeV = address_mode;
+		sampler_info.addressModeW = address_mode;
+		sampler_info.anisotropyEnable = VK_FALSE;
+		sampler_info.maxAnisotropy = 1.0f;
+		sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+		sampler_info.unnormalizedCoordinates = VK_FALSE;
+		sampler_info.compareEnable = VK_FALSE;
+		sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
+		sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		sampler_info.mipLodBias = 0.0f;
+		sampler_info.minLod = 0.0f;
+		sampler_info.maxLod = 1.0f;
+
+		if (vkCreateSampler(m_device->getDevice(), &sampler_info, nullptr, &m_sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create texture sampler!");
+		}
+
+		m_descriptor.sampler = m_sampler;
+		m_descriptor.imageView = m_image_views[m_front];
+		m_descriptor.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	}
+}
@@ -0,0 +1,189 @@
+// internal
+#include "Renderable.h"
+
+// external
+#include <cstdlib>
+#include <thread>
+#include <stdexcept>
+
+namespace Isonia::Renderable
+{
+	static constexpr int divideRound7(const int value)
+	{
+		return (value + (value >= 0 ? 3 : -3)) / 7;
+	}
+
+	static void compressBC4Block(const int* texels, unsigned char* block, unsigned long long* squared_error, unsigned int* max_error)
+	{
+		int high = texels[0];
+		int low = texels[0];
+		for (unsigned int t = 1u; t < block_texel_count; t++)
+		{
+			high = Math::maxi(high, texels[t]);
+			low = Math::mini(low, texels[t]);
+		}
+
+		// high > low selects the 8 value palette, equal endpoints select the 6 value palette where index 0 is exact
+		int palette[8];
+		palette[0] = high;
+		palette[1] = low;
+		for (int i = 1; i < 7; i++)
+		{
+			palette[i + 1] = divideRound7((7 - i) * high + i * low);
+		}
+
+		unsigned long long indices = 0u;
+		for (unsigned int t = 0u; t < block_texel_count; t++)
+		{
+			unsigned int best_index = 0u;
+			int best_error = Math::absi(texels[t] - palette[0]);
+			for (unsigned int p = 1u; p < 8u; p++)
+			{
+				const int error = Math::absi(texels[t] - palette[p]);
+				if (error < best_error)
+				{
+					best_error = error;
+					best_index = p;
+				}
+			}
+			indices |= static_cast<unsigned long long>(best_index) << (3u * t);
+			*squared_error += static_cast<unsigned long long>(best_error * best_error);
+			if (static_cast<unsigned int>(best_error) > *max_error)
+			{
+				*max_error = static_cast<unsigned int>(best_error);
+			}
+		}
+
+		block[0] = static_cast<unsigned char>(high);
+		block[1] = static_cast<unsigned char>(low);
+		for (unsigned int b = 0u; b < 6u; b++)
+		{
+			block[2u + b] = static_cast<unsigned char>(indices >> (8u * b));
+		}
+	}
+
+	static void compressBlockRows(const unsigned char* source, unsigned char* destination, const unsigned int tex_height, const unsigned int tex_width, const unsigned int channels, const bool is_signed, const unsigned int first_row, const unsigned int last_row, unsigned long long* squared_error, unsigned int* max_error)
+	{
+		const unsigned int blocks_wide = (tex_width + block_dimension - 1u) / block_dimension;
+		int texels[block_texel_count];
+		for (unsigned int b_h = first_row; b_h < last_row; b_h++)
+		{
+			for (unsigned int b_w = 0u; b_w < blocks_wide; b_w++)
+			{
+				unsigned char* block = destination + (b_h * blocks_wide + b_w) * bc4_block_size * channels;
+				for (unsigned int c = 0u; c < channels; c++)
+				{
+					// gather the block, replicating edge texels for partial blocks
+					for (unsigned int t_h = 0u; t_h < block_dimension; t_h++)
+					{
+						const unsigned int y = Math::clampui(b_h * block_dimension + t_h, 0u, tex_height - 1u);
+						for (unsigned int t_w = 0u; t_w < block_dimension; t_w++)
+						{
+							const unsigned int x = Math::clampui(b_w * block_dimension + t_w, 0u, tex_width - 1u);
+							const unsigned char value = source[(y * tex_width + x) * channels + c];
+							// snorm -128 and -127 both decode to -1.0
+							texels[t_h * block_dimension + t_w] = is_signed ? Math::maxi(static_cast<signed char>(value), -127) : value;
+						}
+					}
+					compressBC4Block(texels, block + c * bc4_block_size, squared_error, max_error);
+				}
+			}
+		}
+	}
+
+	extern VkFormat toBlockCompressedFormat(const VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_R8_UNORM:
+			return VK_FORMAT_BC4_UNORM_BLOCK;
+		case VK_FORMAT_R8_SNORM:
+			return VK_FORMAT_BC4_SNORM_BLOCK;
+		case VK_FORMAT_R8G8_UNORM:
+			return VK_FORMAT_BC5_UNORM_BLOCK;
+		case VK_FORMAT_R8G8_SNORM:
+			return VK_FORMAT_BC5_SNORM_BLOCK;
+		default:
+			return VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	extern bool isBlockCompressionSupported(Pipeline::Device* device, const VkFormat compressed_format, const VkFilter filter)
+	{
+		if (compressed_format == VK_FORMAT_UNDEFINED || !device->m_enabled_features.textureCompressionBC)
+		{
+			return false;
+		}
+
+		VkFormatFeatureFlags features = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+		if (filter == VK_FILTER_LINEAR)
+		{
+			features |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		}
+		return device->isFormatSupported(compressed_format, VK_IMAGE_TILING_OPTIMAL, features);
+	}
+
+	static unsigned int formatToChannels(const VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_R8_UNORM:
+		case VK_FORMAT_R8_SNORM:
+			return 1u;
+		case VK_FORMAT_R8G8_UNORM:
+		case VK_FORMAT_R8G8_SNORM:
+			return 2u;
+		default:
+			throw std::invalid_argument("Unsupported block compression format!");
+		}
+	}
+
+	extern void* compressTexture(const void* source, const unsigned int tex_height, const unsigned int tex_width, const VkFormat format, BlockCompressionError* error)
+	{
+		const unsigned int blocks_high = (tex_height + block_dimension - 1u) / block_dimension;
+		const unsigned int blocks_wide = (tex_width + block_dimension - 1u) / block_dimension;
+		void* destination = malloc(blocks_high * blocks_wide * bc4_block_size * formatToChannels(format));
+		compressTextureInto(source, destination, tex_height, tex_width, format, error);
+		return destination;
+	}
+
+	extern void compressTextureInto(const void* source, void* destination, const unsigned int tex_height, const unsigned int tex_width, const VkFormat format, BlockCompressionError* error)
+	{
+		const bool is_signed = format == VK_FORMAT_R8_SNORM || format == VK_FORMAT_R8G8_SNORM;
+		const unsigned int channels = formatToChannels(format);
+		const unsigned int blocks_high = (tex_height + block_dimension - 1u) / block_dimension;
+		const unsigned int blocks_wide = (tex_width + block_dimension - 1u) / block_dimension;
+
+		// split block rows evenly across the available hardware threads
+		const unsigned int thread_count = Math::clampui(std::thread::hardware_concurrency(), 1u, blocks_high);
+		std::thread* threads = new std::thread[thread_count];
+		unsigned long long* squared_errors = static_cast<unsigned long long*>(calloc(thread_count, sizeof(unsigned long long)));
+		unsigned int* max_errors = static_cast<unsigned int*>(calloc(thread_count, sizeof(unsigned int)));
+		for (unsigned int i = 0u; i < thread_count; i++)
+		{
+			const unsigned int first_row = blocks_high * i / thread_count;
+			const unsigned int last_row = blocks_high * (i + 1u) / thread_count;
+			threads[i] = std::thread(compressBlockRows, static_cast<const unsigned char*>(source), static_cast<unsigned char*>(destination), tex_height, tex_width, channels, is_signed, first_row, last_row, &squared_errors[i], &max_errors[i]);
+		}
+
+		unsigned long long squared_error = 0u;
+		unsigned int max_error = 0u;
+		for (unsigned int i = 0u; i < thread_count; i++)
+		{
+			threads[i].join();
+			squared_error += squared_errors[i];
+			if (max_errors[i] > max_error)
+			{
+				max_error = max_errors[i];
+			}
+		}
+		delete[] threads;
+		free(squared_errors);
+		free(max_errors);
+
+		// partial edge blocks count their replicated texels, close enough for reporting
+		const unsigned int sample_count = blocks_high * blocks_wide * block_texel_count * channels;
+		error->rms_error = Math::sqrtf(static_cast<float>(squared_error) / static_cast<float>(sample_count));
+		error->max_error = max_error;
+	}
+}
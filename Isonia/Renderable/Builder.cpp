@@ -5,8 +5,8 @@ namespace Isonia::Renderable
 {
 	BuilderPosition::BuilderPosition(Pipeline::Device* device) : m_device(device), m_point_count(7 * 7)
 	{
-		// alloc memory
-		VertexPosition* vertices = (VertexPosition*)malloc(sizeof(VertexPosition) * m_point_count);
+		// create the buffers and write the vertices in place
+		VertexPosition* vertices = static_cast<VertexPosition*>(createVertexBuffers());
 
 		for (int z = -3; z <= 3; z++)
 		{
@@ -18,12 +18,6 @@ namespace Isonia::Renderable
 				vertices[i].position.z = static_cast<float>(z * 64) * Math::units_per_pixel;
 			}
 		}
-
-		// create the buffers
-		createVertexBuffers(vertices);
-
-		// free
-		free(vertices);
 	}
 
 	BuilderPosition::~BuilderPosition()
@@ -31,63 +25,38 @@ namespace Isonia::Renderable
 		delete m_vertex_buffer;
 	}
 
-	void BuilderPosition::bind(VkCommandBuffer command_buffer)
+	void BuilderPosition::bind(Pipeline::CommandRecorder* recorder)
 	{
 		VkBuffer buffers[] = { m_vertex_buffer->getBuffer() };
 		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
+		recorder->bindVertexBuffers(0, 1, buffers, offsets);
 	}
 
-	void BuilderPosition::draw(VkCommandBuffer command_buffer)
+	void BuilderPosition::draw(Pipeline::CommandRecorder* recorder)
 	{
-		vkCmdDraw(command_buffer, static_cast<unsigned int>(m_point_count), 1, 0, 0);
+		recorder->draw(static_cast<unsigned int>(m_point_count), 1, 0, 0);
 	}
 
-	void BuilderPosition::createVertexBuffers(void* vertices)
+	void* BuilderPosition::createVertexBuffers()
 	{
-		const unsigned int vertex_count = static_cast<unsigned int>(m_point_count);
-
-		const VkDeviceSize buffer_size = sizeof(VertexPosition) * m_point_count;
-		const unsigned int vertex_size = sizeof(VertexPosition);
-
-		Pipeline::Buffer staging_buffer{
-			m_device,
-			vertex_size,
-			vertex_count,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-
-		staging_buffer.map();
-		staging_buffer.writeToBuffer(vertices);
-
-		m_vertex_buffer = new Pipeline::Buffer(
-			m_device,
-			vertex_size,
-			vertex_count,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
-
-		m_device->copyBuffer(staging_buffer.getBuffer(), m_vertex_buffer->getBuffer(), buffer_size);
+		void* vertices;
+		m_vertex_buffer = m_device->getUploadContext()->createBuffer(sizeof(VertexPosition), m_point_count, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &vertices);
+		return vertices;
 	}
 
 	BuilderXZUniform::BuilderXZUniform(Pipeline::Device* device, const unsigned int vertices_side_count, const float quad_size)
 		: m_device(device), m_vertices_side_count(vertices_side_count), m_vertices_count(vertices_side_count * vertices_side_count + (vertices_side_count - 2) * (vertices_side_count - 1)), m_quad_size(quad_size)
 	{
-		// alloc memory
-		VertexXZUniform* vertices = (VertexXZUniform*)malloc(sizeof(VertexXZUniform) * m_vertices_count);
-		// create the buffers
-		createVertexBuffers(vertices);
-		// cleanup
-		free(vertices);
+		// create the buffers, contents are left undefined
+		createVertexBuffers();
 	}
 
 	BuilderXZUniform::BuilderXZUniform(Pipeline::Device* device, const Noise::VirtualWarpNoise* warp_noise, const Noise::VirtualNoise* noise, const float amplitude, const Math::Vector3 position, const unsigned int vertices_side_count, const float quad_size)
 		: m_device(device), m_position(position), m_vertices_side_count(vertices_side_count), m_vertices_count(vertices_side_count * vertices_side_count + (vertices_side_count - 2) * (vertices_side_count - 1)), m_quad_size(quad_size)
 	{
-		// alloc memory
-		VertexXZUniform* vertices = (VertexXZUniform*)malloc(sizeof(VertexXZUniform) * m_vertices_count);
+		ISONIA_PROFILE_FUNCTION();
+		// create the buffers and write the vertices in place
+		VertexXZUniform* vertices = static_cast<VertexXZUniform*>(createVertexBuffers());
 
 		// calculate and assign perlin altitude
 		for (unsigned int i = 0; i < m_vertices_count; i++)
@@ -103,12 +72,6 @@ namespace Isonia::Renderable
 			warp_noise->transformCoordinate(&x, &z);
 			vertices[i].altitude = noise->generateNoise(x, z) * amplitude;
 		}
-
-		// create the buffers
-		createVertexBuffers(vertices);
-
-		// cleanup
-		free(vertices);
 	}
 
 	BuilderXZUniform::~BuilderXZUniform()
@@ -116,16 +79,16 @@ namespace Isonia::Renderable
 		delete m_vertex_buffer;
 	}
 
-	void BuilderXZUniform::bind(VkCommandBuffer command_buffer)
+	void BuilderXZUniform::bind(Pipeline::CommandRecorder* recorder)
 	{
 		VkBuffer buffers[] = { m_vertex_buffer->getBuffer() };
 		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
+		recorder->bindVertexBuffers(0, 1, buffers, offsets);
 	}
 
-	void BuilderXZUniform::draw(VkCommandBuffer command_buffer)
+	void BuilderXZUniform::draw(Pipeline::CommandRecorder* recorder)
 	{
-		vkCmdDraw(command_buffer, m_vertices_count, 1, 0, 0);
+		recorder->draw(m_vertices_count, 1, 0, 0);
 	}
 
 	int BuilderXZUniform::calculateCol(const int index, const int strip) const
@@ -141,39 +104,17 @@ namespace Isonia::Renderable
 		return (index - 1) / (int(m_vertices_side_count) * 2 - 1);
 	}
 
-	void BuilderXZUniform::createVertexBuffers(void* vertices)
+	void* BuilderXZUniform::createVertexBuffers()
 	{
-		const VkDeviceSize buffer_size = sizeof(VertexXZUniform) * m_vertices_count;
-		const unsigned int vertex_size = sizeof(VertexXZUniform);
-
-		Pipeline::Buffer staging_buffer{
-			m_device,
-			vertex_size,
-			m_vertices_count,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-
-		staging_buffer.map();
-		staging_buffer.writeToBuffer(vertices);
-
-		m_vertex_buffer = new Pipeline::Buffer(
-			m_device,
-			vertex_size,
-			m_vertices_count,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
-
-		m_device->copyBuffer(staging_buffer.getBuffer(), m_vertex_buffer->getBuffer(), buffer_size);
+		void* vertices;
+		m_vertex_buffer = m_device->getUploadContext()->createBuffer(sizeof(VertexXZUniform), m_vertices_count, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &vertices);
+		return vertices;
 	}
 
 	BuilderXZUniformN::BuilderXZUniformN(Pipeline::Device* device, const Noise::VirtualWarpNoise* warp_noise, const Noise::VirtualNoise* noise, const float amplitude, const float x, const float z, const unsigned int vertices_side_count, const float quad_size)
 		: m_device(device), m_positional_data(x, z), m_vertices_side_count(vertices_side_count), m_vertices_count(vertices_side_count * vertices_side_count + (vertices_side_count - 2) * (vertices_side_count - 1)), m_quad_size(quad_size)
 	{
-		// alloc memory
-		VertexXZUniformN* vertices = (VertexXZUniformN*)malloc(sizeof(VertexXZUniformN) * m_vertices_count);
-
+		ISONIA_PROFILE_FUNCTION();
 		const unsigned int sample = m_vertices_side_count + 2;
 		m_sample_altitudes = (float*)malloc(sample * sample * sizeof(float));
 		// calculate perlin
@@ -197,6 +138,9 @@ namespace Isonia::Renderable
 			}
 		}
 
+		// create the buffers and write the vertices in place, each vertex is written once and never read back
+		VertexXZUniformN* vertices = static_cast<VertexXZUniformN*>(createVertexBuffers());
+
 		// assign normal and altitude
 		for (unsigned int i = 0; i < m_vertices_count; i++)
 		{
@@ -215,12 +159,6 @@ namespace Isonia::Renderable
 			vertices[i].pitch = Math::atan2f(normal.y, normal.z);
 			vertices[i].yaw = Math::atan2f(normal.y, normal.x);
 		}
-
-		// create the buffers
-		createVertexBuffers(vertices);
-
-		// cleanup
-		free(vertices);
 	}
 
 	BuilderXZUniformN::~BuilderXZUniformN()
@@ -228,16 +166,16 @@ namespace Isonia::Renderable
 		delete m_vertex_buffer;
 	}
 
-	void BuilderXZUniformN::bind(VkCommandBuffer command_buffer)
+	void BuilderXZUniformN::bind(Pipeline::CommandRecorder* recorder)
 	{
 		VkBuffer buffers[] = { m_vertex_buffer->getBuffer() };
 		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
+		recorder->bindVertexBuffers(0, 1, buffers, offsets);
 	}
 
-	void BuilderXZUniformN::draw(VkCommandBuffer command_buffer)
+	void BuilderXZUniformN::draw(Pipeline::CommandRecorder* recorder)
 	{
-		vkCmdDraw(command_buffer, m_vertices_count, 1, 0, 0);
+		recorder->draw(m_vertices_count, 1, 0, 0);
 	}
 
 	float* BuilderXZUniformN::sampleAltitude(const unsigned int i_z, const unsigned int i_x) const
@@ -328,38 +266,19 @@ namespace Isonia::Renderable
 		return (index - 1) / (int(m_vertices_side_count) * 2 - 1);
 	}
 
-	void BuilderXZUniformN::createVertexBuffers(void* vertices)
+	void* BuilderXZUniformN::createVertexBuffers()
 	{
-		const VkDeviceSize buffer_size = sizeof(VertexXZUniformN) * m_vertices_count;
-		const unsigned int vertex_size = sizeof(VertexXZUniformN);
-
-		Pipeline::Buffer staging_buffer{
-			m_device,
-			vertex_size,
-			m_vertices_count,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-
-		staging_buffer.map();
-		staging_buffer.writeToBuffer(vertices);
-
-		m_vertex_buffer = new Pipeline::Buffer(
-			m_device,
-			vertex_size,
-			m_vertices_count,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
-
-		m_device->copyBuffer(staging_buffer.getBuffer(), m_vertex_buffer->getBuffer(), buffer_size);
+		void* vertices;
+		m_vertex_buffer = m_device->getUploadContext()->createBuffer(sizeof(VertexXZUniformN), m_vertices_count, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &vertices, Pipeline::ResourceCategories::terrain);
+		return vertices;
 	}
 
 	BuilderXZUniformNP::BuilderXZUniformNP(Pipeline::Device* device, BuilderXZUniformN* ground, const float density)
 		: m_device(device), m_count_side(static_cast<unsigned int>(density* static_cast<float>(ground->m_vertices_side_count - 1u))), m_count(m_count_side * m_count_side)
 	{
-		// alloc memory
-		VertexXZUniformNP* vertices = (VertexXZUniformNP*)malloc(sizeof(VertexXZUniformNP) * m_count);
+		ISONIA_PROFILE_FUNCTION();
+		// create the buffers and write the vertices in place
+		VertexXZUniformNP* vertices = static_cast<VertexXZUniformNP*>(createVertexBuffers());
 
 		const Noise::WhiteNoise offset_noise = { 69u };
 		const float size = ground->m_quad_size / density;
@@ -393,12 +312,6 @@ namespace Isonia::Renderable
 				vertices[i].gain = 0.0f;
 			}
 		}
-
-		// create the buffers
-		createVertexBuffers(vertices);
-
-		// free
-		free(vertices);
 	}
 
 	BuilderXZUniformNP::~BuilderXZUniformNP()
@@ -406,44 +319,22 @@ namespace Isonia::Renderable
 		delete m_vertex_buffer;
 	}
 
-	void BuilderXZUniformNP::bind(VkCommandBuffer command_buffer)
+	void BuilderXZUniformNP::bind(Pipeline::CommandRecorder* recorder)
 	{
 		VkBuffer buffers[] = { m_vertex_buffer->getBuffer() };
 		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
+		recorder->bindVertexBuffers(0, 1, buffers, offsets);
 	}
 
-	void BuilderXZUniformNP::draw(VkCommandBuffer command_buffer)
+	void BuilderXZUniformNP::draw(Pipeline::CommandRecorder* recorder)
 	{
-		vkCmdDraw(command_buffer, m_count, 1, 0, 0);
+		recorder->draw(m_count, 1, 0, 0);
 	}
 
-	void BuilderXZUniformNP::createVertexBuffers(void* vertices)
+	void* BuilderXZUniformNP::createVertexBuffers()
 	{
-		const unsigned int vertex_count = static_cast<unsigned int>(m_count);
-
-		const VkDeviceSize buffer_size = sizeof(VertexXZUniformNP) * m_count;
-		const unsigned int vertex_size = sizeof(VertexXZUniformNP);
-
-		Pipeline::Buffer staging_buffer{
-			m_device,
-			vertex_size,
-			vertex_count,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-
-		staging_buffer.map();
-		staging_buffer.writeToBuffer(vertices);
-
-		m_vertex_buffer = new Pipeline::Buffer(
-			m_device,
-			vertex_size,
-			vertex_count,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
-
-		m_device->copyBuffer(staging_buffer.getBuffer(), m_vertex_buffer->getBuffer(), buffer_size);
+		void* vertices;
+		m_vertex_buffer = m_device->getUploadContext()->createBuffer(sizeof(VertexXZUniformNP), m_count, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &vertices, Pipeline::ResourceCategories::grass);
+		return vertices;
 	}
 }
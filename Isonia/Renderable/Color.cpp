@@ -3,6 +3,48 @@
 
 namespace Isonia::Renderable
 {
+	static constexpr const Color grass_day_palette[palette_length] =
+	{
+		{ 56, 55, 77 },
+		{ 60, 63, 78 },
+		{ 74, 91, 88 },
+		{ 76, 105, 81 },
+		{ 104, 145, 101 },
+		{ 132, 191, 110 },
+		{ 157, 220, 114 },
+		{ 184, 232, 120 },
+		{ 195, 239, 126 },
+		{ 218, 250, 139 },
+	};
+
+	static constexpr const Color grass_night_palette[palette_length] =
+	{
+		{ 0, 14, 28 },
+		{ 1, 18, 32 },
+		{ 2, 22, 35 },
+		{ 4, 30, 45 },
+		{ 16, 46, 65 },
+		{ 24, 63, 90 },
+		{ 33, 89, 119 },
+		{ 51, 115, 145 },
+		{ 86, 154, 181 },
+		{ 102, 173, 198 },
+	};
+
+	static constexpr const Color water_day_palette[palette_length] =
+	{
+		{ 187, 222, 229 },
+		{ 178, 221, 230 },
+		{ 157, 214, 226 },
+		{ 133, 209, 226 },
+		{ 88, 190, 219 },
+		{ 82, 190, 222 },
+		{ 64, 177, 212 },
+		{ 44, 146, 184 },
+		{ 15, 101, 138 },
+		{ 16, 81, 123 },
+	};
+
 	extern Color blendColors(const Color* colors, const unsigned int color_count)
 	{
 		unsigned int total_r = 0u;
@@ -26,57 +68,12 @@ namespace Isonia::Renderable
 		return Color(avg_r, avg_g, avg_b, avg_a);
 	}
 
-	extern Texture* createGrassDayPalette(Pipeline::Device* device)
+	extern TextureArray* createPalettes(Pipeline::Device* device)
 	{
-		constexpr const Color grass_day_palette[palette_length] =
-		{
-			{ 56, 55, 77 },
-			{ 60, 63, 78 },
-			{ 74, 91, 88 },
-			{ 76, 105, 81 },
-			{ 104, 145, 101 },
-			{ 132, 191, 110 },
-			{ 157, 220, 114 },
-			{ 184, 232, 120 },
-			{ 195, 239, 126 },
-			{ 218, 250, 139 },
-		};
-		return new Texture(device, grass_day_palette, 1u, palette_length, VK_FORMAT_R8G8B8A8_SRGB);
-	}
-
-	extern Texture* createGrassNightPalette(Pipeline::Device* device)
-	{
-		constexpr const Color grass_night_palette[palette_length] =
-		{
-			{ 0, 14, 28 },
-			{ 1, 18, 32 },
-			{ 2, 22, 35 },
-			{ 4, 30, 45 },
-			{ 16, 46, 65 },
-			{ 24, 63, 90 },
-			{ 33, 89, 119 },
-			{ 51, 115, 145 },
-			{ 86, 154, 181 },
-			{ 102, 173, 198 },
-		};
-		return new Texture(device, grass_night_palette, 1u, palette_length, VK_FORMAT_R8G8B8A8_SRGB);
-	}
-
-	extern Texture* createWaterDayPalette(Pipeline::Device* device)
-	{
-		constexpr const Color water_day_palette[palette_length] =
-		{
-			{ 187, 222, 229 },
-			{ 178, 221, 230 },
-			{ 157, 214, 226 },
-			{ 133, 209, 226 },
-			{ 88, 190, 219 },
-			{ 82, 190, 222 },
-			{ 64, 177, 212 },
-			{ 44, 146, 184 },
-			{ 15, 101, 138 },
-			{ 16, 81, 123 },
-		};
-		return new Texture(device, water_day_palette, 1u, palette_length, VK_FORMAT_R8G8B8A8_SRGB);
+		return (new TextureArray(device, VK_FORMAT_R8G8B8A8_SRGB, palette_count))
+			->addTexture(grass_day_palette, 1u, palette_length)
+			->addTexture(grass_night_palette, 1u, palette_length)
+			->addTexture(water_day_palette, 1u, palette_length)
+			->build();
 	}
 }
@@ -1,6 +1,9 @@
 // internal
 #include "Renderable.h"
 
+// external
+#include <cstring>
+
 namespace Isonia::Renderable
 {
 	Model::Model(Pipeline::Device* device, const VertexComplete* vertices, const unsigned int vertices_count, const unsigned int* indices, const unsigned int indices_count)
@@ -36,17 +39,17 @@ namespace Isonia::Renderable
 		return new Model(device, generatePrimitiveSphereVertices(sub_divisions), generatePrimitiveSphereVerticesCount(sub_divisions), generatePrimitiveSphereIndices(sub_divisions), generatePrimitiveSphereIndicesCount(sub_divisions));
 	}
 
-	void Model::bind(VkCommandBuffer command_buffer)
+	void Model::bind(Pipeline::CommandRecorder* recorder)
 	{
 		VkBuffer buffers[] = { m_vertex_buffer->getBuffer() };
 		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
-		vkCmdBindIndexBuffer(command_buffer, m_index_buffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		recorder->bindVertexBuffers(0, 1, buffers, offsets);
+		recorder->bindIndexBuffer(m_index_buffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
 	}
 
-	void Model::draw(VkCommandBuffer command_buffer)
+	void Model::draw(Pipeline::CommandRecorder* recorder)
 	{
-		vkCmdDrawIndexed(command_buffer, m_index_count, 1, 0, 0, 0);
+		recorder->drawIndexed(m_index_count, 1, 0, 0, 0);
 	}
 
 	void Model::createVertexBuffers(const VertexComplete* vertices, const unsigned int vertex_count)
@@ -57,17 +60,6 @@ namespace Isonia::Renderable
 		const unsigned int vertex_size = sizeof(VertexComplete);
 		const VkDeviceSize buffer_size = sizeof(VertexComplete) * vertex_count;
 
-		Pipeline::Buffer staging_buffer{
-			m_device,
-			vertex_size,
-			vertex_count,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-
-		staging_buffer.map();
-		staging_buffer.writeToBuffer((void*)vertices);
-
 		m_vertex_buffer = new Pipeline::Buffer(
 			m_device,
 			vertex_size,
@@ -76,7 +68,7 @@ namespace Isonia::Renderable
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		m_device->copyBuffer(staging_buffer.getBuffer(), m_vertex_buffer->getBuffer(), buffer_size);
+		memcpy(m_device->getUploadContext()->stageBuffer(m_vertex_buffer->getBuffer(), buffer_size), vertices, buffer_size);
 	}
 
 	void Model::createIndexBuffers(const unsigned int* indices, const unsigned int index_count)
@@ -86,17 +78,6 @@ namespace Isonia::Renderable
 		const unsigned int index_size = sizeof(unsigned int);
 		const VkDeviceSize buffer_size = sizeof(unsigned int) * index_count;
 
-		Pipeline::Buffer staging_buffer{
-			m_device,
-			index_size,
-			index_count,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
-
-		staging_buffer.map();
-		staging_buffer.writeToBuffer((void*)indices);
-
 		m_index_buffer = new Pipeline::Buffer(
 			m_device,
 			index_size,
@@ -105,6 +86,6 @@ namespace Isonia::Renderable
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		m_device->copyBuffer(staging_buffer.getBuffer(), m_index_buffer->getBuffer(), buffer_size);
+		memcpy(m_device->getUploadContext()->stageBuffer(m_index_buffer->getBuffer(), buffer_size), indices, buffer_size);
 	}
 }
@@ -6,6 +6,10 @@
 
 // external
 #include <vulkan/vulkan.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace Isonia::Renderable
 {
@@ -36,13 +40,17 @@ namespace Isonia::Renderable
 	struct Texture
 	{
 	public:
-		Texture(Pipeline::Device* device, const void* texture, const unsigned int tex_height, const unsigned int tex_width, const VkFormat format, const VkFilter filter = VK_FILTER_NEAREST, const VkSamplerAddressMode address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+		// a layer count of zero is a plain 2D texture, anything else an array texture with that many layers
+		Texture(Pipeline::Device* device, const void* texture, const unsigned int tex_height, const unsigned int tex_width, const VkFormat format, const VkFilter filter = VK_FILTER_NEAREST, const VkSamplerAddressMode address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT, const unsigned int layer_count = 0u);
 		~Texture();
 
 		Texture() = delete;
 		Texture(const Texture&) = delete;
 		Texture& operator=(const Texture&) = delete;
 
+		// layers are tightly packed one after another in the source
+		static Texture* createLayeredTexture(Pipeline::Device* device, const void* texture, const unsigned int tex_height, const unsigned int tex_width, const unsigned int layer_count, const VkFormat format, const VkFilter filter = VK_FILTER_NEAREST, const VkSamplerAddressMode address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+
 		VkSampler getSampler() const;
 		VkImage getImage() const;
 		VkImageView getImageView() const;
@@ -58,11 +66,12 @@ namespace Isonia::Renderable
 		void createTextureImageView();
 		void createTextureSampler(VkFilter filter, VkSamplerAddressMode address_mode);
 		static constexpr const unsigned int formatToBytesPerPixel(const VkFormat image_format);
+		static constexpr const unsigned int formatToBytesPerBlock(const VkFormat image_format);
 
 		VkDescriptorImageInfo m_descriptor;
 		Pipeline::Device* m_device;
 		VkImage m_texture_image;
-		VkDeviceMemory m_texture_image_memory;
+		Pipeline::MemoryAllocation m_texture_image_allocation;
 		VkImageView m_texture_image_view;
 		VkSampler m_texture_sampler;
 		VkFormat m_format;
@@ -71,17 +80,78 @@ namespace Isonia::Renderable
 		unsigned int m_bytes_per_pixel;
 		unsigned int m_mip_levels{ 1 };
 		unsigned int m_layer_count{ 1 };
+		bool m_is_array{ false };
 		VkExtent3D m_extent{};
+
+		friend struct TextureArray;
+		friend struct AnimatedNoiseTexture;
+	};
+
+	struct TextureArrayEntry
+	{
+		unsigned int layer;
+	};
+
+	struct TextureArray
+	{
+	public:
+		TextureArray(Pipeline::Device* device, const VkFormat format, const unsigned int max_entries);
+		~TextureArray();
+
+		TextureArray() = delete;
+		TextureArray(const TextureArray&) = delete;
+		TextureArray& operator=(const TextureArray&) = delete;
+
+		TextureArray* addTexture(const void* texture, const unsigned int tex_height, const unsigned int tex_width);
+		TextureArray* build(const VkFilter filter = VK_FILTER_NEAREST, const VkSamplerAddressMode address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+
+		const Texture* getTexture() const;
+		const VkDescriptorImageInfo* getImageInfo() const;
+		const TextureArrayEntry* getEntry(const unsigned int index) const;
+		unsigned int getEntryCount() const;
+
+	private:
+		Pipeline::Device* m_device;
+		Texture* m_texture = nullptr;
+
+		const VkFormat m_format;
+		const unsigned int m_bytes_per_pixel;
+		const unsigned int m_max_entries;
+		unsigned int m_entry_count = 0u;
+
+		TextureArrayEntry* m_entries;
+		void** m_sources;
+		VkExtent2D* m_source_extents;
 	};
 
 	static constexpr const unsigned int palette_length = 10;
-	extern Texture* createGrassDayPalette(Pipeline::Device* device);
-	extern Texture* createGrassNightPalette(Pipeline::Device* device);
-	extern Texture* createWaterDayPalette(Pipeline::Device* device);
+
+	// layers must match the palette constants in the shaders
+	static constexpr const unsigned int grass_day_palette_layer = 0u;
+	static constexpr const unsigned int grass_night_palette_layer = 1u;
+	static constexpr const unsigned int water_day_palette_layer = 2u;
+	static constexpr const unsigned int palette_count = 3u;
+	extern TextureArray* createPalettes(Pipeline::Device* device);
 
 	extern Texture* createNullTexture(Pipeline::Device* device);
 	extern Texture* createDebugTexture(Pipeline::Device* device);
 
+	// Block compression
+	static constexpr const unsigned int block_dimension = 4u;
+	static constexpr const unsigned int block_texel_count = block_dimension * block_dimension;
+	static constexpr const unsigned int bc4_block_size = 8u;
+
+	struct BlockCompressionError
+	{
+		float rms_error;
+		unsigned int max_error;
+	};
+
+	extern VkFormat toBlockCompressedFormat(const VkFormat format);
+	extern bool isBlockCompressionSupported(Pipeline::Device* device, const VkFormat compressed_format, const VkFilter filter);
+	extern void* compressTexture(const void* source, const unsigned int tex_height, const unsigned int tex_width, const VkFormat format, BlockCompressionError* error);
+	extern void compressTextureInto(const void* source, void* destination, const unsigned int tex_height, const unsigned int tex_width, const VkFormat format, BlockCompressionError* error);
+
 	struct TextureFactory
 	{
 	public:
@@ -92,6 +162,7 @@ namespace Isonia::Renderable
 		TextureFactory& operator=(const TextureFactory&) = delete;
 
 		Texture* instantiateTexture(Pipeline::Device* device, const VkFormat format, const VkFilter filter = VK_FILTER_NEAREST, const VkSamplerAddressMode address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT) const;
+		Texture* instantiateCompressedTexture(Pipeline::Device* device, const VkFormat format, const VkFilter filter = VK_FILTER_NEAREST, const VkSamplerAddressMode address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT) const;
 		virtual void* createTexture() const;
 
 	protected:
@@ -126,6 +197,8 @@ namespace Isonia::Renderable
 
 		const unsigned int atlas_height;
 		const unsigned int atlas_width;
+
+		friend struct SupersampledTextureAtlasFactory;
 	};
 
 	struct GrassTextureAtlasFactory : public TextureAtlasFactory
@@ -139,6 +212,29 @@ namespace Isonia::Renderable
 		void textureFiller(void* memory, const unsigned int index, const unsigned int a_h, const unsigned int a_w, const unsigned int t_h, const unsigned int t_w) const override;
 	};
 
+	struct SupersampledTextureAtlasFactory : public TextureAtlasFactory
+	{
+		// factory renders at samples times the output cell size on each axis
+		SupersampledTextureAtlasFactory(const TextureAtlasFactory* factory, const unsigned int samples);
+		~SupersampledTextureAtlasFactory();
+
+		SupersampledTextureAtlasFactory() = delete;
+		SupersampledTextureAtlasFactory(const SupersampledTextureAtlasFactory&) = delete;
+		SupersampledTextureAtlasFactory& operator=(const SupersampledTextureAtlasFactory&) = delete;
+
+		void* createTexture() const override;
+		void textureFiller(void* memory, const unsigned int index, const unsigned int a_h, const unsigned int a_w, const unsigned int t_h, const unsigned int t_w) const override;
+
+	private:
+		void createCells(void* texture, const unsigned int first_cell, const unsigned int last_cell) const;
+
+		const TextureAtlasFactory* factory;
+		const unsigned int samples;
+
+		unsigned char* texel_block;
+		unsigned short* texel_row_sums;
+	};
+
 	struct Noise4DTextureFactory : public TextureFactory
 	{
 		Noise4DTextureFactory(const Noise::VirtualWarpNoise* warp_noise, const Noise::VirtualNoise* noise, const unsigned int texture_height, const unsigned int texture_width, const unsigned char stride);
@@ -147,11 +243,16 @@ namespace Isonia::Renderable
 		Noise4DTextureFactory(const Noise4DTextureFactory&) = delete;
 		Noise4DTextureFactory& operator=(const Noise4DTextureFactory&) = delete;
 
+		// fills row_count texel rows starting at first_row, memory points at the first of them
+		void fillRowsAt(void* memory, const unsigned int first_row, const unsigned int row_count, const float time) const;
 		void textureFiller(void* memory, const unsigned int index, const unsigned int t_h, const unsigned int t_w) const override;
+		void textureFillerAt(void* memory, const unsigned int index, const unsigned int t_h, const unsigned int t_w, const float time) const;
 
 	private:
 		const Noise::VirtualWarpNoise* warp_noise;
 		const Noise::VirtualNoise* noise;
+
+		friend struct AnimatedNoiseTexture;
 	};
 
 	struct WarpNoiseTextureFactory : public TextureFactory
@@ -168,6 +269,78 @@ namespace Isonia::Renderable
 		const Noise::VirtualWarpNoise* warp_noise;
 	};
 
+	struct AnimatedNoiseTexture
+	{
+	public:
+		AnimatedNoiseTexture(Pipeline::Device* device, const Noise4DTextureFactory* factory, const VkFormat format, const unsigned int frames_in_flight, const unsigned int rows_per_frame, const float time_scale, const VkFilter filter = VK_FILTER_LINEAR, const VkSamplerAddressMode address_mode = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+		~AnimatedNoiseTexture();
+
+		AnimatedNoiseTexture() = delete;
+		AnimatedNoiseTexture(const AnimatedNoiseTexture&) = delete;
+		AnimatedNoiseTexture& operator=(const AnimatedNoiseTexture&) = delete;
+
+		// records this frame's share of row uploads, returns true when the frame's descriptor has to be overwritten
+		bool update(VkCommandBuffer command_buffer, const unsigned int frame_index, const float time_s);
+		// waits for the worker instead of skipping frames, so uploads land on the same frames every run
+		void setLockstep(const bool lockstep);
+
+		const VkDescriptorImageInfo* getImageInfo() const;
+
+	private:
+		void createImages(const VkFilter filter, const VkSamplerAddressMode address_mode);
+		void generateRows(unsigned char* destination, const unsigned int first_row, const unsigned int row_count, const float time) const;
+		void requestGeneration(const float time_s);
+		void workerLoop();
+		void transitionBackImage(VkCommandBuffer command_buffer, const VkImageLayout old_layout, const VkImageLayout new_layout, const VkAccessFlags src_access, const VkAccessFlags dst_access, const VkPipelineStageFlags src_stage, const VkPipelineStageFlags dst_stage) const;
+		bool isBackImageIdle() const;
+
+		static constexpr const unsigned int image_count = 2u;
+
+		Pipeline::Device* m_device;
+		const Noise4DTextureFactory* m_factory;
+		const VkFormat m_source_format;
+		VkFormat m_format;
+		const unsigned int m_frames_in_flight;
+		const unsigned int m_rows_per_frame;
+		const float m_time_scale;
+
+		// an upload row is one texel row, or one row of blocks when block compressed
+		unsigned int m_height;
+		unsigned int m_width;
+		unsigned int m_row_height;
+		unsigned int m_row_count;
+		unsigned int m_row_size;
+
+		VkImage m_images[image_count];
+		Pipeline::MemoryAllocation m_image_allocations[image_count];
+		VkImageView m_image_views[image_count];
+		VkSampler m_sampler;
+		VkDescriptorImageInfo m_descriptor;
+		Pipeline::Buffer* m_staging_buffers[Pipeline::max_frames_in_flight];
+
+		unsigned int m_front = 0u;
+		unsigned int m_generation = 0u;
+		unsigned int m_frame_generations[Pipeline::max_frames_in_flight]{};
+		bool m_generation_requested = false;
+		bool m_lockstep = false;
+
+		// shared with the worker
+		std::thread m_worker;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		// signaled by the worker once a generation is ready
+		std::condition_variable m_ready_condition;
+		// the worker fills the generation a band of m_rows_per_frame rows at a time, one band ahead of the uploads
+		std::atomic<unsigned int> m_generated_rows{ 0u };
+		unsigned char* m_generated;
+		// texel rows of one band before they are block compressed, only touched by the worker once it runs
+		unsigned char* m_band_texels = nullptr;
+		float m_requested_time = 0.0f;
+		unsigned int m_uploaded_rows = 0u;
+		bool m_requested = false;
+		bool m_stop = false;
+	};
+
 	// Vertices
 	struct VertexComplete
 	{
@@ -303,8 +476,8 @@ namespace Isonia::Renderable
 		static Model* createPrimitivePrism(Pipeline::Device* device, const unsigned int num_sides);
 		static Model* createPrimitiveSphere(Pipeline::Device* device, const unsigned int sub_divisions);
 
-		void bind(VkCommandBuffer command_buffer);
-		void draw(VkCommandBuffer command_buffer);
+		void bind(Pipeline::CommandRecorder* recorder);
+		void draw(Pipeline::CommandRecorder* recorder);
 
 	private:
 		void createVertexBuffers(const VertexComplete* vertices, const unsigned int vertex_count);
@@ -329,11 +502,11 @@ namespace Isonia::Renderable
 		BuilderPosition(const BuilderPosition&) = delete;
 		BuilderPosition& operator=(const BuilderPosition&) = delete;
 
-		void bind(VkCommandBuffer command_buffer);
-		void draw(VkCommandBuffer command_buffer);
+		void bind(Pipeline::CommandRecorder* recorder);
+		void draw(Pipeline::CommandRecorder* recorder);
 
 	private:
-		void createVertexBuffers(void* vertices);
+		void* createVertexBuffers();
 
 		const unsigned int m_point_count;
 		Pipeline::Device* m_device;
@@ -350,8 +523,8 @@ namespace Isonia::Renderable
 		BuilderXZUniform(const BuilderXZUniform&) = delete;
 		BuilderXZUniform& operator=(const BuilderXZUniform&) = delete;
 
-		void bind(VkCommandBuffer command_buffer);
-		void draw(VkCommandBuffer command_buffer);
+		void bind(Pipeline::CommandRecorder* recorder);
+		void draw(Pipeline::CommandRecorder* recorder);
 
 		Math::Vector3 m_position;
 
@@ -360,7 +533,7 @@ namespace Isonia::Renderable
 		int calculateRow(const int index, const int strip) const;
 		int calculateStrip(const int index) const;
 
-		void createVertexBuffers(void* vertices);
+		void* createVertexBuffers();
 
 		Pipeline::Device* m_device;
 		Pipeline::Buffer* m_vertex_buffer;
@@ -379,8 +552,8 @@ namespace Isonia::Renderable
 		BuilderXZUniformN(const BuilderXZUniformN&) = delete;
 		BuilderXZUniformN& operator=(const BuilderXZUniformN&) = delete;
 
-		void bind(VkCommandBuffer command_buffer);
-		void draw(VkCommandBuffer command_buffer);
+		void bind(Pipeline::CommandRecorder* recorder);
+		void draw(Pipeline::CommandRecorder* recorder);
 
 		float mapWorldToHeight(const float world_x, const float world_z) const;
 		Math::Vector3 mapWorldToNormal(const float world_x, const float world_z) const;
@@ -396,7 +569,7 @@ namespace Isonia::Renderable
 		float* sampleAltitude(const unsigned int i_z, const unsigned int i_x) const;
 		Math::Vector3* sampleNormal(const unsigned int i_z, const unsigned int i_x) const;
 
-		void createVertexBuffers(void* vertices);
+		void* createVertexBuffers();
 
 		Pipeline::Device* m_device;
 		Pipeline::Buffer* m_vertex_buffer;
@@ -420,13 +593,13 @@ namespace Isonia::Renderable
 		BuilderXZUniformNP(const BuilderXZUniformNP&) = delete;
 		BuilderXZUniformNP& operator=(const BuilderXZUniformNP&) = delete;
 
-		void bind(VkCommandBuffer command_buffer);
-		void draw(VkCommandBuffer command_buffer);
+		void bind(Pipeline::CommandRecorder* recorder);
+		void draw(Pipeline::CommandRecorder* recorder);
 
 		bool m_culled = false;
 
 	private:
-		void createVertexBuffers(void* vertices);
+		void* createVertexBuffers();
 
 		Pipeline::Device* m_device;
 		Pipeline::Buffer* m_vertex_buffer;
@@ -519,8 +692,8 @@ namespace Isonia::Renderable
 		BuilderUI(const BuilderUI&) = delete;
 		BuilderUI& operator=(const BuilderUI&) = delete;
 
-		void bind(VkCommandBuffer command_buffer);
-		void draw(VkCommandBuffer command_buffer);
+		void bind(Pipeline::CommandRecorder* recorder);
+		void draw(Pipeline::CommandRecorder* recorder);
 
 		void update(const VkExtent2D extent, const char* text);
 
@@ -529,7 +702,8 @@ namespace Isonia::Renderable
 
 		Pipeline::Device* m_device;
 
-		unsigned int m_previous_char_length = 0u;
+		// length of the text last written by update, which is also what draw covers
+		unsigned int m_char_length = 0u;
 
 		const unsigned int m_max_text_length;
 
@@ -537,7 +711,6 @@ namespace Isonia::Renderable
 		const unsigned int m_vertex_count;
 		VertexUI* m_vertices;
 		Pipeline::Buffer* m_vertex_buffer;
-		Pipeline::Buffer* m_vertex_staging_buffer;
 
 		static const constexpr unsigned int indices_per_quad = 6u;
 		const unsigned int m_index_count;
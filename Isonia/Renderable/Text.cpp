@@ -2,6 +2,7 @@
 #include "Renderable.h"
 
 // external
+#include <cstring>
 #include <stdexcept>
 
 namespace Isonia::Renderable
@@ -12,23 +13,28 @@ namespace Isonia::Renderable
 		const unsigned int vertex_size = sizeof(VertexUI);
 		const unsigned int index_size = sizeof(unsigned int);
 
-		m_vertex_staging_buffer = new Pipeline::Buffer(
+		m_vertex_buffer = new Pipeline::Buffer(
 			m_device,
 			vertex_size,
 			m_vertex_count,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			1,
+			Pipeline::ResourceCategories::ui
 		);
 
-		m_vertex_buffer = new Pipeline::Buffer(
+		m_index_buffer = new Pipeline::Buffer(
 			m_device,
-			vertex_size,
-			m_vertex_count,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			index_size,
+			m_index_count,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			1,
+			Pipeline::ResourceCategories::ui
 		);
 
-		unsigned int* indices = (unsigned int*)malloc(m_index_count * sizeof(unsigned int));
+		// indices are written straight into staging memory
+		unsigned int* indices = (unsigned int*)m_device->getUploadContext()->stageBuffer(m_index_buffer->getBuffer(), sizeof(unsigned int) * m_index_count);
 		for (unsigned int i = 0; i < max_text_length; i++)
 		{
 			indices[(i * indices_per_quad) + 0] = (i * vertices_per_quad) + 0;
@@ -38,28 +44,11 @@ namespace Isonia::Renderable
 			indices[(i * indices_per_quad) + 4] = (i * vertices_per_quad) + 2;
 			indices[(i * indices_per_quad) + 5] = (i * vertices_per_quad) + 3;
 		}
-		Pipeline::Buffer index_staging_buffer = Pipeline::Buffer{
-			m_device,
-			index_size,
-			m_index_count,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-		m_index_buffer = new Pipeline::Buffer(
-			m_device,
-			index_size,
-			m_index_count,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
-		index_staging_buffer.map();
-		index_staging_buffer.writeToBuffer(indices);
-		m_device->copyBuffer(index_staging_buffer.getBuffer(), m_index_buffer->getBuffer(), sizeof(unsigned int) * m_index_count);
-		free(indices);
 	}
 
 	void BuilderUI::update(const VkExtent2D extent, const char* text)
 	{
+		ISONIA_PROFILE_FUNCTION();
 		const unsigned int char_length = getCharLength(text);
 		assert(char_length < m_max_text_length && "Tried to write outside of buffer!");
 
@@ -107,19 +96,20 @@ namespace Isonia::Renderable
 			x += offset_screen_x;
 		}
 
-		const unsigned int write_length = Math::maxi(m_previous_char_length, char_length);
+		// quads past the previous length are already cleared
+		const unsigned int write_length = Math::maxi(m_char_length, char_length);
 		memset(&m_vertices[char_length * vertices_per_quad], 0, (write_length - char_length) * vertices_per_quad * sizeof(VertexUI));
-		m_vertex_staging_buffer->map();
-		m_vertex_staging_buffer->writeToBuffer(m_vertices);
-		m_device->copyBuffer(m_vertex_staging_buffer->getBuffer(), m_vertex_buffer->getBuffer(), sizeof(VertexUI) * vertices_per_quad * write_length);
-		m_vertex_staging_buffer->unmap();
-		m_previous_char_length = char_length;
+		const VkDeviceSize write_size = sizeof(VertexUI) * vertices_per_quad * write_length;
+		if (write_size > 0)
+		{
+			memcpy(m_device->getUploadContext()->stageBuffer(m_vertex_buffer->getBuffer(), write_size), m_vertices, write_size);
+		}
+		m_char_length = char_length;
 	}
 
 	BuilderUI::~BuilderUI()
 	{
 		free(m_vertices);
-		delete m_vertex_staging_buffer;
 		delete m_vertex_buffer;
 		delete m_index_buffer;
 	}
@@ -134,16 +124,20 @@ namespace Isonia::Renderable
 		return length;
 	}
 
-	void BuilderUI::bind(VkCommandBuffer command_buffer)
+	void BuilderUI::bind(Pipeline::CommandRecorder* recorder)
 	{
 		VkBuffer buffers[] = { m_vertex_buffer->getBuffer() };
 		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(command_buffer, 0, 1, buffers, offsets);
-		vkCmdBindIndexBuffer(command_buffer, m_index_buffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+		recorder->bindVertexBuffers(0, 1, buffers, offsets);
+		recorder->bindIndexBuffer(m_index_buffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
 	}
 
-	void BuilderUI::draw(VkCommandBuffer command_buffer)
+	void BuilderUI::draw(Pipeline::CommandRecorder* recorder)
 	{
-		vkCmdDrawIndexed(command_buffer, m_index_count, 1, 0, 0, 0);
+		// only the quads of the current text, the rest of the buffer is cleared
+		if (m_char_length > 0u)
+		{
+			recorder->drawIndexed(indices_per_quad * m_char_length, 1, 0, 0, 0);
+		}
 	}
 }
@@ -2,13 +2,14 @@
 #include "Renderable.h"
 
 // external
+#include <cassert>
 #include <cstring>
 #include <stdexcept>
 
 namespace Isonia::Renderable
 {
-	Texture::Texture(Pipeline::Device* device, const void* texture, const unsigned int tex_height, const unsigned int tex_width, const VkFormat format, const VkFilter filter, const VkSamplerAddressMode address_mode)
-		: m_device{ device }
+	Texture::Texture(Pipeline::Device* device, const void* texture, const unsigned int tex_height, const unsigned int tex_width, const VkFormat format, const VkFilter filter, const VkSamplerAddressMode address_mode, const unsigned int layer_count)
+		: m_device{ device }, m_layer_count{ layer_count > 0u ? layer_count : 1u }, m_is_array{ layer_count > 0u }
 	{
 		createTextureImage(texture, tex_height, tex_width, format);
 		createTextureImageView();
@@ -16,12 +17,19 @@ namespace Isonia::Renderable
 		updateDescriptor();
 	}
 
+	Texture* Texture::createLayeredTexture(Pipeline::Device* device, const void* texture, const unsigned int tex_height, const unsigned int tex_width, const unsigned int layer_count, const VkFormat format, const VkFilter filter, const VkSamplerAddressMode address_mode)
+	{
+		assert(layer_count > 0u && "Layered texture needs at least one layer");
+		return new Texture(device, texture, tex_height, tex_width, format, filter, address_mode, layer_count);
+	}
+
 	Texture::~Texture()
 	{
-		vkDestroySampler(m_device->getDevice(), m_texture_sampler, nullptr);
-		vkDestroyImageView(m_device->getDevice(), m_texture_image_view, nullptr);
-		vkDestroyImage(m_device->getDevice(), m_texture_image, nullptr);
-		vkFreeMemory(m_device->getDevice(), m_texture_image_memory, nullptr);
+		// frames in flight may still sample the texture
+		Pipeline::DeletionQueue* deletion_queue = m_device->getDeletionQueue();
+		deletion_queue->destroySampler(m_texture_sampler);
+		deletion_queue->destroyImageView(m_texture_image_view);
+		deletion_queue->destroyImage(m_texture_image, &m_texture_image_allocation);
 	}
 
 	VkSampler Texture::getSampler() const
@@ -63,27 +71,23 @@ namespace Isonia::Renderable
 	void Texture::createTextureImage(const void* source, const unsigned int tex_height, const unsigned int tex_width, const VkFormat format)
 	{
 		m_image_type = tex_height == 1 ? VK_IMAGE_TYPE_1D : VK_IMAGE_TYPE_2D;
-		m_bytes_per_pixel = formatToBytesPerPixel(format);
-		VkDeviceSize image_size = tex_height * tex_width * m_bytes_per_pixel;
+		VkDeviceSize image_size;
+		const unsigned int bytes_per_block = formatToBytesPerBlock(format);
+		if (bytes_per_block != 0u)
+		{
+			// block compressed formats are stored as rows of 4x4 texel blocks
+			m_bytes_per_pixel = 0u;
+			image_size = ((tex_height + block_dimension - 1u) / block_dimension) * ((tex_width + block_dimension - 1u) / block_dimension) * bytes_per_block;
+		}
+		else
+		{
+			m_bytes_per_pixel = formatToBytesPerPixel(format);
+			image_size = tex_height * tex_width * m_bytes_per_pixel;
+		}
+		image_size *= m_layer_count;
 
 		m_mip_levels = 1;
 
-		VkBuffer staging_buffer;
-		VkDeviceMemory staging_buffer_memory;
-
-		m_device->createBuffer(
-			image_size,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			&staging_buffer,
-			&staging_buffer_memory
-		);
-
-		void* data;
-		vkMapMemory(m_device->getDevice(), staging_buffer_memory, 0, image_size, 0, &data);
-		memcpy(data, source, image_size);
-		vkUnmapMemory(m_device->getDevice(), staging_buffer_memory);
-
 		m_format = format;
 		m_extent = { tex_width, tex_height, 1 };
 
@@ -105,37 +109,12 @@ namespace Isonia::Renderable
 			&image_info,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 			&m_texture_image,
-			&m_texture_image_memory
-		);
-		m_device->transitionImageLayout(
-			m_texture_image,
-			format,
-			VK_IMAGE_LAYOUT_UNDEFINED,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			m_mip_levels,
-			m_layer_count
-		);
-		m_device->copyBufferToImage(
-			staging_buffer,
-			m_texture_image,
-			tex_width,
-			tex_height,
-			m_layer_count
-		);
-
-		m_device->transitionImageLayout(
-			m_texture_image,
-			format,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			m_mip_levels,
-			m_layer_count
+			&m_texture_image_allocation,
+			Pipeline::ResourceCategories::textures
 		);
+		memcpy(m_device->getUploadContext()->stageImage(m_texture_image, format, tex_width, tex_height, m_layer_count, image_size), source, image_size);
 
 		m_texture_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-		vkDestroyBuffer(m_device->getDevice(), staging_buffer, nullptr);
-		vkFreeMemory(m_device->getDevice(), staging_buffer_memory, nullptr);
 	}
 
 	void Texture::createTextureImageView()
@@ -143,7 +122,14 @@ namespace Isonia::Renderable
 		VkImageViewCreateInfo view_info{};
 		view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		view_info.image = m_texture_image;
-		view_info.viewType = static_cast<VkImageViewType>(m_image_type);
+		if (m_is_array)
+		{
+			view_info.viewType = m_image_type == VK_IMAGE_TYPE_1D ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+		}
+		else
+		{
+			view_info.viewType = static_cast<VkImageViewType>(m_image_type);
+		}
 		view_info.format = m_format;
 		view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		view_info.subresourceRange.baseMipLevel = 0;
@@ -209,4 +195,19 @@ namespace Isonia::Renderable
 			throw std::invalid_argument("Unsupported image format!");
 		}
 	}
+
+	constexpr const unsigned int Texture::formatToBytesPerBlock(const VkFormat image_format)
+	{
+		switch (image_format)
+		{
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			return bc4_block_size;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+			return bc4_block_size * 2u;
+		default:
+			return 0u;
+		}
+	}
 }
@@ -0,0 +1,88 @@
+// internal
+#include "Renderable.h"
+
+// external
+#include <cassert>
+#include <cstring>
+
+namespace Isonia::Renderable
+{
+	TextureArray::TextureArray(Pipeline::Device* device, const VkFormat format, const unsigned int max_entries)
+		: m_device{ device }, m_format{ format }, m_bytes_per_pixel{ Texture::formatToBytesPerPixel(format) }, m_max_entries{ max_entries }
+	{
+		m_entries = (TextureArrayEntry*)malloc(m_max_entries * sizeof(TextureArrayEntry));
+		m_sources = (void**)malloc(m_max_entries * sizeof(void*));
+		m_source_extents = (VkExtent2D*)malloc(m_max_entries * sizeof(VkExtent2D));
+	}
+
+	TextureArray::~TextureArray()
+	{
+		for (unsigned int i = 0u; i < m_entry_count; i++)
+		{
+			free(m_sources[i]);
+		}
+		free(m_sources);
+		free(m_source_extents);
+		free(m_entries);
+		delete m_texture;
+	}
+
+	TextureArray* TextureArray::addTexture(const void* texture, const unsigned int tex_height, const unsigned int tex_width)
+	{
+		assert(m_texture == nullptr && "Texture array already built");
+		assert(m_entry_count < m_max_entries && "Texture array is full");
+
+		// keep a copy so callers can free their data before build
+		const unsigned int size = tex_height * tex_width * m_bytes_per_pixel;
+		m_sources[m_entry_count] = malloc(size);
+		memcpy(m_sources[m_entry_count], texture, size);
+		m_source_extents[m_entry_count] = { tex_width, tex_height };
+		m_entry_count++;
+		return this;
+	}
+
+	TextureArray* TextureArray::build(const VkFilter filter, const VkSamplerAddressMode address_mode)
+	{
+		ISONIA_PROFILE_FUNCTION();
+		assert(m_texture == nullptr && "Texture array already built");
+		assert(m_entry_count > 0u && "Texture array is empty");
+
+		// layers share one extent, nothing rescales the uvs of a smaller entry so padding it would be sampled
+		const unsigned int layer_height = m_source_extents[0].height;
+		const unsigned int layer_width = m_source_extents[0].width;
+		const unsigned int layer_size = layer_height * layer_width * m_bytes_per_pixel;
+		unsigned char* layers = (unsigned char*)malloc(m_entry_count * layer_size);
+		for (unsigned int i = 0u; i < m_entry_count; i++)
+		{
+			assert(m_source_extents[i].height == layer_height && m_source_extents[i].width == layer_width && "Texture array entries must share one extent");
+			memcpy(layers + i * layer_size, m_sources[i], layer_size);
+			// sources are consumed by the upload
+			free(m_sources[i]);
+			m_sources[i] = nullptr;
+
+			m_entries[i].layer = i;
+		}
+
+		m_texture = Texture::createLayeredTexture(m_device, layers, layer_height, layer_width, m_entry_count, m_format, filter, address_mode);
+		free(layers);
+		return this;
+	}
+
+	const Texture* TextureArray::getTexture() const
+	{
+		return m_texture;
+	}
+	const VkDescriptorImageInfo* TextureArray::getImageInfo() const
+	{
+		return m_texture->getImageInfo();
+	}
+	const TextureArrayEntry* TextureArray::getEntry(const unsigned int index) const
+	{
+		assert(index < m_entry_count && "Texture array entry out of range");
+		return &m_entries[index];
+	}
+	unsigned int TextureArray::getEntryCount() const
+	{
+		return m_entry_count;
+	}
+}
@@ -1,6 +1,16 @@
 // internal
 #include "Renderable.h"
 
+// external
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define ISONIA_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace Isonia::Renderable
 {
 	extern Texture* createNullTexture(Pipeline::Device* device)
@@ -65,6 +75,31 @@ namespace Isonia::Renderable
 		free(texture_data);
 		return texture;
 	}
+	Texture* TextureFactory::instantiateCompressedTexture(Pipeline::Device* device, const VkFormat format, const VkFilter filter, const VkSamplerAddressMode address_mode) const
+	{
+		const unsigned int height = getTextureHeight();
+		const unsigned int width = getTextureWidth();
+		const VkFormat compressed_format = toBlockCompressedFormat(format);
+
+		// only whole blocks are compressed, fall back to uncompressed otherwise
+		if (height % block_dimension != 0u || width % block_dimension != 0u || !isBlockCompressionSupported(device, compressed_format, filter))
+		{
+			return instantiateTexture(device, format, filter, address_mode);
+		}
+
+		void* texture_data = createTexture();
+		BlockCompressionError error;
+		void* compressed_data = compressTexture(texture_data, height, width, format, &error);
+		free(texture_data);
+
+#ifdef DEBUG
+		std::cout << "Block compressed texture " << width << "x" << height << ": rms error " << error.rms_error << ", max error " << error.max_error << '\n';
+#endif
+
+		Texture* texture = new Texture(device, compressed_data, height, width, compressed_format, filter, address_mode);
+		free(compressed_data);
+		return texture;
+	}
 	void* TextureFactory::createTexture() const
 	{
 		// NOTE: using modulus is a lot cleaner but a lot slower
@@ -124,7 +159,23 @@ namespace Isonia::Renderable
 		: TextureFactory(texture_height, texture_width, stride), warp_noise(warp_noise), noise(noise)
 	{
 	}
+	void Noise4DTextureFactory::fillRowsAt(void* memory, const unsigned int first_row, const unsigned int row_count, const float time) const
+	{
+		const unsigned int last_row = first_row + row_count;
+		for (unsigned int t_h = first_row; t_h < last_row; t_h++)
+		{
+			const unsigned int base_i_t_h = (t_h - first_row) * texture_width;
+			for (unsigned int t_w = 0u; t_w < texture_width; t_w++)
+			{
+				textureFillerAt(memory, base_i_t_h + t_w, t_h, t_w, time);
+			}
+		}
+	}
 	void Noise4DTextureFactory::textureFiller(void* memory, const unsigned int index, const unsigned int t_h, const unsigned int t_w) const
+	{
+		textureFillerAt(memory, index, t_h, t_w, 0.0f);
+	}
+	void Noise4DTextureFactory::textureFillerAt(void* memory, const unsigned int index, const unsigned int t_h, const unsigned int t_w, const float time) const
 	{
 		unsigned char* value = static_cast<unsigned char*>(memory) + index;
 
@@ -136,6 +187,12 @@ namespace Isonia::Renderable
 		float nz = Math::sinf(s * Math::two_pi) / (Math::two_pi);
 		float nt = Math::sinf(t * Math::two_pi) / (Math::two_pi);
 
+		// moving the torus through the noise evolves the texture while keeping it tileable
+		nx += time;
+		ny += time;
+		nz += time;
+		nt += time;
+
 		warp_noise->transformCoordinate(&nx, &ny, &nz, &nt);
 		const float noise_value = noise->generateNoise(nx, ny, nz, nt);
 		const float pushed_value = (noise_value + 1.0f) * 0.5f;
@@ -223,64 +280,133 @@ namespace Isonia::Renderable
 		*value = 0;
 	}
 
-	/*
-	extern void* createTextureAtlasMSAA(SubTextureFiller sub_texture_filler, const unsigned char stride, const unsigned int atlas_height, const unsigned int atlas_width, const unsigned int texture_height, const unsigned int texture_width, const unsigned int msaa)
+	// sums sample rows with sse2 where available, then averages each samples wide group
+	static void boxDownsample(const unsigned char* source, unsigned char* destination, const unsigned int height, const unsigned int width, const unsigned int destination_pitch, const unsigned int stride, const unsigned int samples, unsigned short* row_sums)
 	{
-		void* msaa_texture_atlas = createTextureAtlas(sub_texture_filler, stride, atlas_height, atlas_width, texture_height * msaa, texture_width * msaa);
-
-		const unsigned int texture_atlas_height = atlas_height * texture_height;
-		const unsigned int texture_atlas_width = atlas_width * texture_width;
-		const unsigned int texture_atlas_size = texture_atlas_height * texture_atlas_width;
-
-		// NOTE: using modulus is a lot cleaner but a lot slower
-		void* texture_atlas = malloc(texture_atlas_size * stride);
-		for (unsigned int a_h = 0u; a_h < atlas_height; a_h++)
+		const unsigned int source_row_size = width * samples * stride;
+		const unsigned int divisor = samples * samples;
+		for (unsigned int y = 0u; y < height; y++)
 		{
-			const unsigned int base_i_a_h = texture_height * texture_atlas_width * a_h;
-			for (unsigned int a_w = 0u; a_w < atlas_width; a_w++)
+			const unsigned char* source_row = source + y * samples * source_row_size;
+			unsigned int i = 0u;
+#ifdef ISONIA_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			for (; i + 16u <= source_row_size; i += 16u)
 			{
-				const unsigned int base_i_a_w = texture_width * a_w;
-				for (unsigned int t_h = 0u; t_h < texture_height; t_h++)
+				__m128i low = zero;
+				__m128i high = zero;
+				for (unsigned int s = 0u; s < samples; s++)
 				{
-					const unsigned int base_i_t_h = t_h * texture_atlas_width;
-					for (unsigned int t_w = 0u; t_w < texture_width; t_w++)
-					{
-						unsigned int total_r = 0u;
-						unsigned int total_g = 0u;
-						unsigned int total_b = 0u;
-						unsigned int total_a = 0u;
-
-						for (unsigned int m_h = 0u; m_h < msaa; m_h++)
-						{
-							for (unsigned int m_w = 0u; m_w < msaa; m_w++)
-							{
-								const unsigned int msaa_index =
-									(texture_height * atlas_width * texture_width * a_h * msaa * msaa) +
-									((t_h * msaa + m_h) * atlas_width * texture_width * msaa) +
-									(texture_width * a_w * msaa) +
-									(t_w * msaa + m_w);
-								Color sample = msaa_texture_atlas[msaa_index];
-								total_r += sample.r;
-								total_g += sample.g;
-								total_b += sample.b;
-								total_a += sample.a;
-							}
-						}
-
-						unsigned int rgba_divisor = msaa * msaa;
-						unsigned char avg_r = static_cast<unsigned char>(total_r / rgba_divisor);
-						unsigned char avg_g = static_cast<unsigned char>(total_g / rgba_divisor);
-						unsigned char avg_b = static_cast<unsigned char>(total_b / rgba_divisor);
-						unsigned char avg_a = static_cast<unsigned char>(total_a / rgba_divisor);
+					const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source_row + s * source_row_size + i));
+					low = _mm_add_epi16(low, _mm_unpacklo_epi8(bytes, zero));
+					high = _mm_add_epi16(high, _mm_unpackhi_epi8(bytes, zero));
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(row_sums + i), low);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(row_sums + i + 8u), high);
+			}
+#endif
+			for (; i < source_row_size; i++)
+			{
+				unsigned short sum = 0u;
+				for (unsigned int s = 0u; s < samples; s++)
+				{
+					sum += source_row[s * source_row_size + i];
+				}
+				row_sums[i] = sum;
+			}
 
-						const unsigned int index = base_i_a_h + base_i_t_h + base_i_a_w + t_w;
-						texture_atlas[index] = Color(avg_r, avg_g, avg_b, avg_a);
+			unsigned char* destination_row = destination + y * destination_pitch;
+			for (unsigned int x = 0u; x < width; x++)
+			{
+				for (unsigned int c = 0u; c < stride; c++)
+				{
+					unsigned int sum = 0u;
+					for (unsigned int s = 0u; s < samples; s++)
+					{
+						sum += row_sums[(x * samples + s) * stride + c];
 					}
+					destination_row[x * stride + c] = static_cast<unsigned char>((sum + divisor / 2u) / divisor);
+				}
+			}
+		}
+	}
+
+	SupersampledTextureAtlasFactory::SupersampledTextureAtlasFactory(const TextureAtlasFactory* factory, const unsigned int samples)
+		: TextureAtlasFactory(factory->atlas_height, factory->atlas_width, factory->texture_height / samples, factory->texture_width / samples, factory->stride), factory(factory), samples(samples)
+	{
+		assert(factory->texture_height % samples == 0u && factory->texture_width % samples == 0u && "Cell size must be a multiple of samples");
+		// an unsigned short row sum holds up to 257 samples of 255, 16 keeps the full resolution cells small
+		assert(samples > 0u && samples <= 16u && "Unsupported sample count");
+
+		// scratch for the single texel path, allocated once rather than per texel
+		texel_block = static_cast<unsigned char*>(malloc(samples * samples * stride));
+		texel_row_sums = static_cast<unsigned short*>(malloc(samples * stride * sizeof(unsigned short)));
+	}
+	SupersampledTextureAtlasFactory::~SupersampledTextureAtlasFactory()
+	{
+		free(texel_row_sums);
+		free(texel_block);
+	}
+	void* SupersampledTextureAtlasFactory::createTexture() const
+	{
+		void* texture = malloc(getTextureSize());
+
+		// split atlas cells evenly across the available hardware threads
+		const unsigned int cell_count = atlas_height * atlas_width;
+		const unsigned int thread_count = Math::clampui(std::thread::hardware_concurrency(), 1u, cell_count);
+		std::thread* threads = new std::thread[thread_count];
+		for (unsigned int i = 0u; i < thread_count; i++)
+		{
+			const unsigned int first_cell = cell_count * i / thread_count;
+			const unsigned int last_cell = cell_count * (i + 1u) / thread_count;
+			threads[i] = std::thread(&SupersampledTextureAtlasFactory::createCells, this, texture, first_cell, last_cell);
+		}
+		for (unsigned int i = 0u; i < thread_count; i++)
+		{
+			threads[i].join();
+		}
+		delete[] threads;
+		return texture;
+	}
+	void SupersampledTextureAtlasFactory::createCells(void* texture, const unsigned int first_cell, const unsigned int last_cell) const
+	{
+		const unsigned int sample_height = factory->texture_height;
+		const unsigned int sample_width = factory->texture_width;
+		const unsigned int texture_atlas_width = getTextureWidth();
+
+		unsigned char* cell = static_cast<unsigned char*>(malloc(sample_height * sample_width * stride));
+		unsigned short* row_sums = static_cast<unsigned short*>(malloc(sample_width * stride * sizeof(unsigned short)));
+		for (unsigned int c = first_cell; c < last_cell; c++)
+		{
+			const unsigned int a_h = c / atlas_width;
+			const unsigned int a_w = c % atlas_width;
+
+			// render the cell at full sample resolution
+			for (unsigned int t_h = 0u; t_h < sample_height; t_h++)
+			{
+				const unsigned int base_i_t_h = t_h * sample_width;
+				for (unsigned int t_w = 0u; t_w < sample_width; t_w++)
+				{
+					factory->textureFiller(cell, base_i_t_h + t_w, a_h, a_w, t_h, t_w);
 				}
 			}
+
+			unsigned char* destination = static_cast<unsigned char*>(texture) + (a_h * texture_height * texture_atlas_width + a_w * texture_width) * stride;
+			boxDownsample(cell, destination, texture_height, texture_width, texture_atlas_width * stride, stride, samples, row_sums);
+		}
+		free(row_sums);
+		free(cell);
+	}
+	void SupersampledTextureAtlasFactory::textureFiller(void* memory, const unsigned int index, const unsigned int a_h, const unsigned int a_w, const unsigned int t_h, const unsigned int t_w) const
+	{
+		// single texel path, createTexture renders whole cells instead, not thread safe as the scratch is shared
+		for (unsigned int m_h = 0u; m_h < samples; m_h++)
+		{
+			for (unsigned int m_w = 0u; m_w < samples; m_w++)
+			{
+				factory->textureFiller(texel_block, m_h * samples + m_w, a_h, a_w, t_h * samples + m_h, t_w * samples + m_w);
+			}
 		}
-		delete msaa_texture_atlas;
-		return texture_atlas;
+		boxDownsample(texel_block, static_cast<unsigned char*>(memory) + index * stride, 1u, 1u, stride, stride, samples, texel_row_sums);
 	}
-	*/
 }
@@ -21,16 +21,20 @@ layout(set = 0, binding = 1) uniform GlobalClock {
   float frame_time_s;
 } clock;
 
-layout (set = 1, binding = 0) uniform sampler1D colors;
+layout (set = 1, binding = 0) uniform sampler1DArray colors;
+
+// matches the palette layers in Renderable.h
+const float GRASS_DAY_PALETTE = 0.0;
 
 layout (set = 1, binding = 1) uniform sampler2D alpha_map;
 
 void main()
 {
-	if (texture(alpha_map, frag_texture_coord).r < 1)
+	// alpha map holds supersampled coverage, keep texels that are at least half covered
+	if (texture(alpha_map, frag_texture_coord).r < 0.5)
 		discard;
 
 	float directional_light = -dot(frag_normal_world, ubo.light_direction);
 	float light_intensity = max(directional_light * frag_cloud_shadow, ubo.recording_time_elapsed_s.w);
-	out_color = texture(colors, light_intensity);
+	out_color = texture(colors, vec2(light_intensity, GRASS_DAY_PALETTE));
 }
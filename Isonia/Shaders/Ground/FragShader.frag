@@ -25,7 +25,10 @@ layout(push_constant) uniform Push {
   float z;
 } push;
 
-layout (set = 1, binding = 0) uniform sampler1D colors;
+layout (set = 1, binding = 0) uniform sampler1DArray colors;
+
+// matches the palette layers in Renderable.h
+const float GRASS_DAY_PALETTE = 0.0;
 
 layout (set = 2, binding = 0) uniform sampler2D cloud_shadow_map;
 
@@ -46,5 +49,5 @@ void main()
 
 	float directional_light = -dot(frag_normal_world, ubo.light_direction);
 	float light_intensity = max(directional_light * frag_cloud_shadow, ubo.recording_time_elapsed_s.w);
-	out_color = texture(colors, light_intensity);
+	out_color = texture(colors, vec2(light_intensity, GRASS_DAY_PALETTE));
 }
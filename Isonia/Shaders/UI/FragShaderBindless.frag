@@ -0,0 +1,35 @@
+#version 450
+#extension GL_KHR_vulkan_glsl : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+layout (location = 0) in vec2 frag_texture_coord;
+
+layout (location = 0) out vec4 out_color;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 inverse_view;
+  vec4 recording_time_elapsed_s;
+  vec3 light_direction;
+  vec2 sub_pixel_offset;
+} ubo;
+
+layout(set = 0, binding = 1) uniform GlobalClock {
+  float time_s;
+  float frame_time_s;
+} clock;
+
+layout (set = 1, binding = 0) uniform sampler2D textures[];
+
+layout (push_constant) uniform Push {
+  uint texture_index;
+} push;
+
+void main()
+{
+	vec4 texture_value = texture(textures[push.texture_index], frag_texture_coord);
+	if (texture_value.a < 1)
+		discard;
+	out_color = texture_value;
+}
@@ -25,16 +25,12 @@ layout(push_constant) uniform Push {
   float z;
 } push;
 
-layout (set = 1, binding = 0) uniform sampler2D color_map;
-layout (set = 1, binding = 1) uniform sampler2D depth_map;
-layout (set = 2, binding = 0) uniform sampler1D colors;
+// the scene depth attachment itself, bound read only while the water tests against it
+layout (set = 1, binding = 0) uniform sampler2D depth_map;
+layout (set = 2, binding = 0) uniform sampler1DArray colors;
 
-vec4 alphaBlend(vec4 src_color, vec4 dst_color)
-{
-    float alpha = src_color.a;
-    vec3 blended_color = src_color.rgb * alpha + dst_color.rgb * (1.0 - alpha);
-    return vec4(blended_color, 1.0);
-}
+// matches the palette layers in Renderable.h
+const float WATER_DAY_PALETTE = 2.0;
 
 void main()
 {
@@ -51,10 +47,9 @@ void main()
         return;
     }
 
+    // blended over the scene by the pipeline instead of reading the scene color back
     float water_color_uv = water_depth_world * 0.1;
-    vec4 water_color = vec4(texture(colors, water_color_uv).rgb, water_color_uv);
-    vec4 under_water_color = texture(color_map, screen_uv);
-    out_color = alphaBlend(water_color, under_water_color);
+    out_color = vec4(texture(colors, vec2(water_color_uv, WATER_DAY_PALETTE)).rgb, min(water_color_uv, 1.0));
     //out_color = vec4(color.rgb, 1.0);
     //out_color = vec4(water_depth, 0, 0, 1.0);
     //out_color = vec4(color.rgb, water_depth);
@@ -2,13 +2,23 @@
 #include "State.h"
 
 // external
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
 
 namespace Isonia::State
 {
 	bool GrowHeap(unsigned long long size)
 	{
+#ifdef _WIN32
         void* memory = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
 		return memory != nullptr;
+#else
+		// reserved address space only, like MEM_RESERVE
+		void* memory = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		return memory != MAP_FAILED;
+#endif
 	}
 }
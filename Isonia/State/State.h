@@ -7,6 +7,11 @@
 #include <vulkan/vulkan.h>
 #include <string>
 
+namespace Isonia::Pipeline
+{
+	struct CommandRecorder;
+}
+
 namespace Isonia::State
 {
 	struct GlobalUbo
@@ -38,11 +43,23 @@ namespace Isonia::State
 		int frame_index;
 		float frame_time_s;
 		VkCommandBuffer command_buffer;
+		// render systems record through this, redundant binds are dropped
+		Pipeline::CommandRecorder* recorder;
 		VkDescriptorSet global_descriptor_set;
 		VkDescriptorSet global_swapchain_descriptor_set;
+		// uniform ring offsets of the global set's dynamic bindings
+		static constexpr const unsigned int global_dynamic_offsets_count = 2u;
+		unsigned int global_dynamic_offsets[global_dynamic_offsets_count];
+
+		FrameInfo(int frame_index, float frame_time_s, VkCommandBuffer command_buffer, Pipeline::CommandRecorder* recorder, VkDescriptorSet global_descriptor_set, VkDescriptorSet global_swapchain_descriptor_set, unsigned int ubo_offset, unsigned int clock_offset)
+			: frame_index(frame_index), frame_time_s(frame_time_s), command_buffer(command_buffer), recorder(recorder), global_descriptor_set(global_descriptor_set), global_swapchain_descriptor_set(global_swapchain_descriptor_set), global_dynamic_offsets{ ubo_offset, clock_offset }
+		{
+
+		}
 
-		FrameInfo(int frame_index, float frame_time_s, VkCommandBuffer command_buffer, VkDescriptorSet global_descriptor_set, VkDescriptorSet global_swapchain_descriptor_set)
-			: frame_index(frame_index), frame_time_s(frame_time_s), command_buffer(command_buffer), global_descriptor_set(global_descriptor_set), global_swapchain_descriptor_set(global_swapchain_descriptor_set)
+		// the same frame recorded through another command buffer, such as a secondary on a worker thread
+		FrameInfo(const FrameInfo* frame_info, VkCommandBuffer command_buffer, Pipeline::CommandRecorder* recorder)
+			: frame_index(frame_info->frame_index), frame_time_s(frame_info->frame_time_s), command_buffer(command_buffer), recorder(recorder), global_descriptor_set(frame_info->global_descriptor_set), global_swapchain_descriptor_set(frame_info->global_swapchain_descriptor_set), global_dynamic_offsets{ frame_info->global_dynamic_offsets[0], frame_info->global_dynamic_offsets[1] }
 		{
 
 		}